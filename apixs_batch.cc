@@ -0,0 +1,23 @@
+
+//
+/// \file apixs_batch.cc
+/// \brief Batch-only build of apixs: runs a macro without constructing, or linking,
+/// the Geant4 user interfaces and visualisation.
+
+#include "Application.hh"
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+int main(int argc,char** argv){
+
+    Application app( "apixs_batch", false );
+    if( !app.ParseArguments( argc, argv ) )
+        return app.GetStatus();
+
+    if( !app.Construct() )
+        return app.GetStatus();
+
+    app.ExecuteMacro();
+}
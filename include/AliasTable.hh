@@ -0,0 +1,42 @@
+/// \file AliasTable.hh
+/// \brief Definition of the AliasTable class
+
+#ifndef AliasTable_h
+#define AliasTable_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+/// Walker alias table: samples an index with probability proportional to its weight
+/// with one random number, whatever the number of entries.
+
+class AliasTable{
+
+public:
+
+    AliasTable(){}
+
+    void Build( const std::vector<G4double>& weights );
+        // Negative weights count as 0. The table is empty if all weights are 0.
+
+    G4int Sample() const;
+        // Index with probability weights[i]/sum.
+
+    G4int Sample( G4double& fraction ) const;
+        // Same, also returning a uniform random number in [0,1) independent of the index,
+        // to place the sample inside a bin.
+
+    size_t GetSize() const { return probability.size(); }
+    G4bool IsEmpty() const { return probability.empty(); }
+
+private:
+
+    std::vector<G4double> probability;
+        // probability of keeping the index drawn, otherwise its alias is taken
+    std::vector<G4int> alias;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,82 @@
+/// \file AlphaSource.hh
+/// \brief Definition of the AlphaSource class
+
+#ifndef AlphaSource_h
+#define AlphaSource_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "AliasTable.hh"
+
+#include <vector>
+
+class G4Event;
+
+/// Alpha source of tabulated lines on a disk, set up with the /generator/alpha/ commands.
+///
+/// The lines of the nuclides (Am241, Po210, Cm244) or given one by one are sampled
+/// from an alias table of their intensities. The energy lost in the encapsulation of
+/// the source is a shift of all lines with a straggling profile: a Gaussian with an
+/// exponential low-energy tail, tabulated once and sampled from a second alias table.
+/// Positions are uniform on a disk, directions isotropic or cosine-distributed within
+/// a cone around the disk axis. Each event costs a handful of random numbers, with
+/// none of the generic machinery of the GPS.
+
+class AlphaSource{
+
+public:
+
+    AlphaSource();
+    ~AlphaSource();
+
+    G4bool AddNuclide( G4String name, G4double activity );
+        // Add the lines of a known nuclide, weighted by its relative activity.
+    void AddLine( G4double energy, G4double intensity );
+    void Clear();
+        // Remove all lines.
+    G4bool IsEmpty() const { return energies.empty(); }
+
+    void SetEncapsulation( G4double loss, G4double sigma, G4double tail );
+        // Mean energy loss, Gaussian straggling and exponential tail in the encapsulation.
+
+    void SetPosition( G4ThreeVector p ){ center = p; }
+    void SetRadius( G4double r ){ radius = r; }
+    void SetAxis( G4ThreeVector );
+        // Normal of the disk, around which the directions are distributed.
+    void SetMaxTheta( G4double t ){ max_theta = t; }
+    void SetCosineLaw( G4bool b ){ cosine_law = b; }
+
+    void GeneratePrimaryVertex( G4Event* );
+
+    void Print() const;
+
+private:
+
+    std::vector<G4double> energies;
+    std::vector<G4double> intensities;
+    AliasTable line_table;
+
+    G4double loss;
+    G4double sigma;
+    G4double tail;
+
+    static const G4int nstraggling = 1024;
+    G4double straggling_min;
+    G4double straggling_width;
+    AliasTable straggling_table;
+
+    G4bool tables_ready;
+    void BuildTables();
+
+    G4ThreeVector center;
+    G4double radius;
+    G4ThreeVector axis;
+    G4ThreeVector axis_u;
+    G4ThreeVector axis_v;
+    G4double max_theta;
+    G4bool cosine_law;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
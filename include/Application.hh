@@ -0,0 +1,86 @@
+/// \file Application.hh
+/// \brief Definition of the Application class
+
+#ifndef Application_h
+#define Application_h 1
+
+#include "globals.hh"
+
+class G4RunManager;
+class GeometryProfiler;
+class StartupTimer;
+class RunAction;
+
+/// Set up of the simulation shared by apixs and apixs_batch: command line, random
+/// engine, run manager and user classes. apixs adds the visualisation and the
+/// interactive session on top, apixs_batch only executes the macro and is built
+/// without the Geant4 UI and vis libraries.
+
+class Application{
+
+public:
+
+    Application( G4String program, G4bool interactive );
+        // interactive: the program can open a UI session when no macro is given.
+    ~Application();
+
+    G4bool ParseArguments( int argc, char** argv );
+        // False when the program should stop, e.g. after -h; see GetStatus().
+    G4int GetStatus() const { return status; }
+
+    void PrintUsage() const;
+
+    G4bool Construct();
+        // Seeds, run manager and user classes. False if the command line asks for
+        // something that does not exist.
+
+    void ExecuteMacro();
+        // The macro given by -m.
+
+    G4bool IsBatch() const { return batch; }
+    G4bool IsQuiet() const { return quiet; }
+
+    StartupTimer* GetStartupTimer() const { return startup_timer; }
+        // Null unless --timing is given.
+
+private:
+
+    G4String program;
+    G4bool interactive;
+
+    G4int status;
+
+    G4bool batch;
+        // Use the flags to determine whether program run in batch mode or interactive mode.
+
+    G4bool quiet;
+
+    // macro and output filename.
+    // These variables are set by inspecting the commandline argument.
+    G4String macro;
+    G4String filename;
+
+    // Event to replay on its own. Negative means normal running.
+    G4int replay_event;
+    G4int replay_run;
+
+    // Continue an interrupted run from the last checkpoint of the output file.
+    G4bool resume;
+
+    // Fields of the recorded steps.
+    G4String record;
+
+    // Time the navigation per volume.
+    G4bool profile_geometry;
+
+    G4long seeds[2];
+
+    StartupTimer* startup_timer;
+    GeometryProfiler* geometry_profiler;
+    G4RunManager* run_manager;
+    RunAction* run_action;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,116 @@
+/// \file ConvergenceMonitor.hh
+/// \brief Definition of the ConvergenceMonitor class
+
+#ifndef ConvergenceMonitor_h
+#define ConvergenceMonitor_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+
+class G4Step;
+class G4VPhysicalVolume;
+class OutputSink;
+class ConvergenceMonitorMessenger;
+
+/// Stopping criterion of a run, set up with the /convergence/ commands.
+///
+/// One tally is followed event by event:
+///
+///     deposit: events depositing an energy in the window in one detector volume, e.g.
+///              the counts of the Ka line in the detector;
+///     xray:    photons created in the volumes with an energy in the window, e.g. the
+///              yield of a target foil.
+///
+/// Its mean per event and variance are accumulated online with Welford's algorithm,
+/// over the events and over the means of batches of events. At the end of every batch
+/// the relative standard error of the mean is estimated from the batch means, or from
+/// the events if that is larger, and the run is stopped once it reaches the precision
+/// goal. The run is also stopped when the time limit is spent. /run/beamOn then only
+/// gives the maximum number of events.
+
+class ConvergenceMonitor{
+
+public:
+
+    ConvergenceMonitor();
+    ~ConvergenceMonitor();
+
+    void SetTally( G4String type, G4String volume, G4double emin, G4double emax );
+        // type "deposit" or "xray", volume name with a trailing '*' matching any suffix.
+
+    void SetPrecision( G4double r ){ precision = r; }
+        // Relative standard error at which the run stops, 0 for none.
+    void SetTimeLimit( G4double t ){ time_limit = t; }
+        // Wall time after which the run stops, 0 for none.
+    void SetBatchSize( G4int n ){ batch_size = n; }
+    void SetMinBatches( G4int n ){ min_batches = n; }
+        // Batches before the precision is trusted.
+
+    G4bool IsEnabled() const { return type!="" && ( precision>0 || time_limit>0 ); }
+
+    void BeginOfRun( G4bool active );
+        // Reset the accumulators and start the clock. Inactive runs, e.g. the ones of
+        // /response/run, are neither followed nor stopped.
+    void SetSink( OutputSink* s ){ sink = s; }
+    void EndOfRun( G4double primaries_per_event );
+        // Print and write the tally and why the run stopped.
+
+    void ProcessStep( const G4Step* );
+    G4bool EndOfEvent();
+        // Add the event to the accumulators. Returns true when the run should stop.
+
+    G4double GetRelativeError() const;
+        // Current relative standard error of the mean, 0 before the first batch.
+
+private:
+
+    ConvergenceMonitorMessenger* messenger;
+
+    G4bool active;
+
+    G4String type;
+    G4String volume_pattern;
+    G4double emin;
+    G4double emax;
+
+    G4double precision;
+    G4double time_limit;
+    G4int batch_size;
+    G4int min_batches;
+
+    OutputSink* sink;
+
+    std::unordered_map<const G4VPhysicalVolume*, G4bool> is_tallied;
+    G4bool IsTallied( const G4VPhysicalVolume* );
+
+    // Current event
+    G4double event_value;
+    std::map< std::pair<const G4VPhysicalVolume*, G4int>, G4double > deposits;
+        // energy per detector volume and copy
+
+    // Welford accumulators over events and over batch means
+    G4int nevents;
+    G4double mean;
+    G4double m2;
+
+    G4int nbatches;
+    G4double batch_sum;
+    G4double batch_mean;
+    G4double batch_m2;
+
+    std::chrono::steady_clock::time_point start;
+    G4String reason;
+        // why the run stopped, empty if it ran to the end
+
+    G4double GetEventError() const;
+    G4double GetBatchError() const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,42 @@
+/// \file ConvergenceMonitorMessenger.hh
+/// \brief Definition of the ConvergenceMonitorMessenger class
+
+#ifndef ConvergenceMonitorMessenger_h
+#define ConvergenceMonitorMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class ConvergenceMonitor;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+class ConvergenceMonitorMessenger: public G4UImessenger{
+
+public:
+
+    ConvergenceMonitorMessenger( ConvergenceMonitor* );
+    virtual ~ConvergenceMonitorMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    ConvergenceMonitor* monitor;
+
+    G4UIdirectory* directory;
+
+    G4UIcommand* tallyCmd;
+        // Tally followed: type, volume and energy window.
+    G4UIcmdWithADouble* precisionCmd;
+        // Relative error at which the run stops.
+    G4UIcmdWithADoubleAndUnit* timeCmd;
+        // Wall time after which the run stops.
+    G4UIcmdWithAnInteger* batchCmd;
+    G4UIcmdWithAnInteger* minBatchesCmd;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/// \file DecaySource.hh
+/// \brief Definition of the DecaySource class
+
+#ifndef DecaySource_h
+#define DecaySource_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+#include <map>
+
+class G4Event;
+class G4Track;
+class G4ParticleDefinition;
+
+/// Radioactive source sampled from a table of decays, set up with the /generator/decay/ commands.
+///
+/// /generator/decay/nuclide tabulates the emissions of a nuclide once: a run of
+/// decays of the nucleus at rest in which every particle created by the decay
+/// (alphas, betas, gammas, X-rays, conversion and Auger electrons) is recorded and
+/// killed. Excited daughters are followed, so that isomeric transitions belong to the
+/// decay; with /generator/decay/chain the ground-state daughters are followed as well,
+/// down to a stable nucleus. The delay of an emission is counted from the first decay,
+/// adding up the lifetimes of the nuclei in between. The table is saved in the cache
+/// directory, under a name that includes the fluorescence and Auger settings, and read
+/// back by later runs. The tabulation run records nothing else: no output is opened
+/// and no tally is filled, and the run number of the next run is not shifted.
+///
+/// In the decay mode of the generator every event is one decay of the table, with all
+/// of its emissions and their delays, so energy correlations between the particles of
+/// a decay are kept. Directions are isotropic and independent, angular correlations are
+/// not. Source runs need no decay physics and no decay data.
+
+class DecaySource{
+
+public:
+
+    DecaySource();
+    ~DecaySource();
+
+    void SetNuclide( G4String name );
+        // Read the table of the nuclide from the cache, tabulate it if it is not there.
+    G4bool IsEmpty() const { return offsets.size()<2; }
+
+    void SetChain( G4bool b ){ chain = b; }
+    void SetDecays( G4int n ){ ndecays = n; }
+        // Decays simulated to tabulate a nuclide.
+    void SetCacheDirectory( G4String dir ){ cache_dir = dir; }
+    G4bool ReadTable( G4String file, G4bool check = false );
+        // Read a table written by a tabulation. With check, the table must be of the
+        // current nuclide, chain setting and Geant4 version, with at least as many decays.
+
+    void SetPosition( G4ThreeVector p ){ center = p; }
+    void SetRadius( G4double r ){ radius = r; }
+    void SetAxis( G4ThreeVector );
+        // Normal of the source disk.
+
+    G4bool IsTabulating() const { return tabulating; }
+    G4ParticleDefinition* GetNucleus() const { return nucleus; }
+        // Nucleus decayed at rest by the events of the tabulation.
+    G4bool Record( const G4Track* );
+        // Record the track if it was created by a decay. Returns false if the track is
+        // to be killed.
+
+    void GeneratePrimaryVertex( G4Event* );
+        // One decay of the table, or the nucleus at rest during the tabulation.
+
+    void Print() const;
+
+private:
+
+    G4String nuclide;
+    G4bool chain;
+    G4int ndecays;
+    G4String cache_dir;
+
+    G4bool tabulating;
+    G4ParticleDefinition* nucleus;
+
+    // Emissions of all decays, decay i from offsets[i] to offsets[i+1].
+    std::vector<size_t> offsets;
+    std::vector<G4int> pdg_codes;
+    std::vector<G4double> energies;
+    std::vector<G4double> delays;
+    std::vector<G4ParticleDefinition*> definitions;
+        // of the PDG codes, looked up at the first event
+    std::map<G4int, G4double> nucleus_delays;
+        // delay at which each nucleus of the decay being recorded was created
+
+    G4String GetDeexcitation() const;
+        // Fluorescence and Auger settings, which change the emissions.
+    G4String CacheFile() const;
+    void WriteTable( G4String file ) const;
+    void Tabulate();
+
+    G4ThreeVector center;
+    G4double radius;
+    G4ThreeVector axis_u;
+    G4ThreeVector axis_v;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
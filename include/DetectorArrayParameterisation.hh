@@ -0,0 +1,47 @@
+/// \file DetectorArrayParameterisation.hh
+/// \brief Definition of the DetectorArrayParameterisation class
+
+#ifndef DetectorArrayParameterisation_h
+#define DetectorArrayParameterisation_h 1
+
+#include "globals.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+
+/// Positions and orientations of the far-side detectors of an array built by
+/// /placement/ring or /placement/grid. The copy number of each element is its
+/// index in the array, used as the detector ID.
+
+class DetectorArrayParameterisation : public G4VPVParameterisation{
+
+public:
+
+    DetectorArrayParameterisation();
+    virtual ~DetectorArrayParameterisation();
+
+    void AddElement( G4ThreeVector pos, const G4RotationMatrix& rot );
+        // Position in the envelope and rotation of the element, as an active rotation
+        // of the detector axis (z).
+
+    G4int GetNumberOfElements() const { return positions.size(); }
+    G4ThreeVector GetPosition( G4int i ) const { return positions[i]; }
+    G4RotationMatrix GetRotation( G4int i ) const { return rotations[i]!=0 ? *rotations[i] : G4RotationMatrix(); }
+        // frame rotation of the element, as set on the physical volume
+
+    virtual void ComputeTransformation( const G4int copyNo, G4VPhysicalVolume* ) const;
+
+private:
+
+    std::vector<G4ThreeVector> positions;
+    std::vector<G4RotationMatrix*> rotations;
+        // frame rotations, as G4PVPlacement takes them, 0 for none
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
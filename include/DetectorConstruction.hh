@@ -18,6 +18,9 @@ class G4UserLimits;
 class G4GlobalMagFieldMessenger;
 class G4Event;
 class DetectorConstructionMessenger;
+class SphereScorer;
+class StartupTimer;
+class G4VTouchable;
 
 /// Detector construction class to define materials and geometry.
 
@@ -34,6 +37,20 @@ public:
 
     G4Material* FindMaterial(G4String);
 
+    void SetQuiet( G4bool b ){ quiet = b; }
+        // Do not print the material table.
+
+    void SetStartupTimer( StartupTimer* t ){ startup_timer = t; }
+        // Marks the end of the materials and of the volumes, see --timing.
+
+    SphereScorer* GetSphereScorer(){ return sphere_scorer; }
+        // Scorer of the virtual sphere, also when the sphere is not placed.
+
+    static G4int GetDetectorID( const G4VTouchable* );
+        // Copy number of the volume, or of the array element it belongs to: the crystals of
+        // the arrays of /placement/ring and /placement/grid are one daughter of a parameterised
+        // case, and the copy number of the case is the detector ID.
+
 private:
     
     void DefineMaterials();
@@ -46,6 +63,10 @@ private:
 
     bool fCheckOverlaps;
 
+    G4bool quiet;
+
+    StartupTimer* startup_timer;
+
     // Variables related to the dimensions of the setup.
 
     G4NistManager* mat_man;
@@ -116,6 +137,21 @@ private:
     }
 
     void PlaceFarSideDetector();
+
+    G4LogicalVolume* BuildFarSideCase( G4String crystal_name );
+        // Al case with the NaI crystal inside, along z.
+    static void GetFarSideCaseSize( G4double& radius, G4double& half_length );
+
+    G4int array_count;
+        // used to name the detector arrays.
+
+    void PlaceRing( G4int n, G4double radius, G4double z, G4double phi0, G4double dphi );
+        // n detectors on a circle in the x-y plane at height z, at the azimuths phi0+i*dphi,
+        // all facing the z axis.
+
+    void PlaceGrid( G4int nx, G4int ny, G4double pitch, G4ThreeVector center );
+        // nx x ny detectors on a square grid centered on center, in the plane perpendicular
+        // to the direction of the center, facing the origin.
     
     void SetFilterPosition( G4ThreeVector x){
         filter_position = x;
@@ -139,6 +175,13 @@ private:
         // used to keep track of number of farside detectors.
 
     G4int filter_count;
+
+    // Virtual scoring sphere
+    SphereScorer* sphere_scorer;
+    G4bool sphere_placed;
+
+    void PlaceScoringSphere( G4double radius, G4double thickness );
+        // Thin vacuum shell centered on the origin, scoring the particles crossing it outwards.
 };
 
 
@@ -44,6 +44,11 @@ private:
         // Command to specify angle of rotation the farside detector
     G4UIcommand* place_detector;
 
+    G4UIcommand* ringCmd;
+        // Place a ring of far-side detectors: N r z phi0 dphi, cm and degrees.
+    G4UIcommand* gridCmd;
+        // Place a grid of far-side detectors: nx ny pitch x y z, cm.
+
     // Filter/collimator related commands.
 
     G4UIcmdWith3VectorAndUnit* filterPosCmd;
@@ -56,6 +61,13 @@ private:
     G4UIcmdWithADoubleAndUnit* filterAngCmd_z;
         // Command to specify angle of rotation the farside detector
     G4UIcmdWith3VectorAndUnit* place_filter;
+
+    // Scoring sphere commands.
+
+    G4UIcommand* sphereCmd;
+        // Place the virtual scoring sphere: radius and thickness.
+    G4UIcommand* sphereBinCmd;
+        // Binning of the scoring sphere histograms.
 };
 
 #endif
@@ -9,6 +9,17 @@
 #include "StepInfo.hh"
 #include "RunAction.hh"
 
+class G4Track;
+
+class Trigger;
+class StepFilter;
+class StepSpill;
+class XrayTally;
+class PointDetector;
+class ResponseMatrix;
+class ConvergenceMonitor;
+class ScoringMesh;
+
 class EventAction : public G4UserEventAction{
 
 public:
@@ -21,56 +32,143 @@ public:
 
     vector<StepInfo>& GetStepCollection();
 
+    G4bool IsTabulating() const { return tabulating; }
+        // Event of a decay tabulation: its steps are neither recorded nor scored.
+
+    void CountStep(){ nsteps++; }
+        // Every step of the event, recorded or not, for the run metrics.
+
+    inline void AddStep( const G4Step* step );
+        // Store a step of the current event, within the memory limit set by /output/maxEventMemory.
+        // Only the fields of the record selected with /output/record are filled.
+    inline void AddTrack( const G4Track* track );
+        // Store the starting point of a track, the same way.
+
+    void TagTrack( const G4Track* );
+        // Record the primary the track descends from. Called when the track starts, after
+        // its parent.
+    G4int GetPrimaryIndex( G4int trackID ) const {
+        return trackID<G4int( track_primary.size() ) ? track_primary[trackID] : 0;
+    }
+        // Primary of the event a track descends from, 0 with one primary per event.
+    G4int GetOutputEventID( G4int trackID ) const {
+        return nprimaries>1 ? event_id*nprimaries + GetPrimaryIndex( trackID ) : event_id;
+    }
+        // Event ID written for a track: each primary is written as an event of its own.
+
+    Trigger* GetTrigger(){ return trigger; }
+        // Decides which events are written. Fed step by step by the SteppingAction.
+
+    StepFilter* GetStepFilter(){ return step_filter; }
+        // Decides which steps of an event are kept.
+
+    XrayTally* GetXrayTally(){ return xray_tally; }
+        // Photons created in the targets, fed step by step by the SteppingAction.
+
+    PointDetector* GetPointDetector(){ return point_detector; }
+        // Next-event estimator of the fluence at points, fed step by step by the SteppingAction.
+
+    ResponseMatrix* GetResponseMatrix(){ return response_matrix; }
+        // Energy deposited in the detectors by the photons of /response/run.
+
+    ConvergenceMonitor* GetConvergenceMonitor(){ return convergence; }
+        // Tally that stops the run once precise enough, fed step by step by the SteppingAction.
+
+    ScoringMesh* GetScoringMesh(){ return mesh; }
+        // Voxels of energy, track entries and photons in the volumes of /mesh/.
+
 private:
      
     RunAction* run_action;
     
-    TTree* data_tree;
-    
     // methods
     void PrintEventStatistics() const;
 
-    bool if_center;
-    bool if_farside;
+    Trigger* trigger;
 
+    StepFilter* step_filter;
 
-    int eventID;
-    int trackID;
-    int stepID;
-    int parentID;
+    XrayTally* xray_tally;
 
-    G4String tmp_particle_name;
-    G4String tmp_volume_name;
-    G4String tmp_process_name;
-    //int volume_copy_number;
+    PointDetector* point_detector;
 
-    G4ThreeVector position;
-    G4ThreeVector momentum;
+    ResponseMatrix* response_matrix;
 
-    double x;
-    double y;
-    double z;
-    double theta;
-    double phi;
+    ConvergenceMonitor* convergence;
 
-    double px;
-    double py;
-    double pz;
+    ScoringMesh* mesh;
 
-    double global_time;
+    vector<StepInfo> stepCollection;
 
-    double Eki;
-    double Ekf;
-    double edep;
+    const StepInfo::RecordType* record_type;
+        // fields of the stored steps, taken from the RunAction at the start of the event
+    inline StepInfo* NewStep();
+
+    G4int nsteps;
+
+    G4int event_id;
+
+    G4bool tabulating;
+
+    // Several primaries per event
+    G4int nprimaries;
+    vector<G4int> track_primary;
+        // primary index per track ID
+    vector<StepInfo> primary_steps;
+        // steps of one primary, written as an event of its own
+    void WritePrimaries( OutputSink* sink );
+
+    // Per-event memory limit
+    G4double max_bytes;
+        // per-event memory limit, 0 for no limit
+    size_t max_steps;
+        // capacity of stepCollection allowed by the limit, 0 for no limit
+    G4double name_bytes;
+        // heap memory of the names of the steps in stepCollection
+    G4bool spill_enabled;
+    StepSpill* spill;
+    G4bool spilled;
+    G4bool truncated;
+    G4double peak_bytes;
+        // largest size of the step buffer during the event
+
+    G4bool Grow();
+        // Called when stepCollection is full. Grows it up to the limit, then spills it to
+        // disk or starts dropping steps. Returns false if the step must be dropped.
+};
 
-    int max_char_len;
-    char particle_name[16];
-    char volume_name[16];
-    char process_name[16];
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+inline StepInfo* EventAction::NewStep(){
+    if( stepCollection.size()==stepCollection.capacity() && max_steps>0 && !Grow() )
+        return 0;
+    stepCollection.push_back( StepInfo() );
+    return &stepCollection.back();
+}
 
-    vector<StepInfo> stepCollection;
-};
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void EventAction::AddStep( const G4Step* step ){
+    StepInfo* info = NewStep();
+    if( info==0 )
+        return;
+    (info->*record_type->fill)( step );
+    name_bytes += info->GetMemorySize()-sizeof( StepInfo );
+    if( nprimaries>1 )
+        info->SetPrimaryIndex( GetPrimaryIndex( info->GetTrackID() ) );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void EventAction::AddTrack( const G4Track* track ){
+    StepInfo* info = NewStep();
+    if( info==0 )
+        return;
+    (info->*record_type->fill_initial)( track );
+    name_bytes += info->GetMemorySize()-sizeof( StepInfo );
+    if( nprimaries>1 )
+        info->SetPrimaryIndex( GetPrimaryIndex( info->GetTrackID() ) );
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
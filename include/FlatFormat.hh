@@ -0,0 +1,82 @@
+/// \file FlatFormat.hh
+/// \brief Layout of the flat binary output format.
+///
+/// A flat file starts with a FlatHeader followed by nfields FlatField descriptors that
+/// name the members of the fixed-size step records. The records start at header_size.
+/// When the file is closed, an index with one FlatEventEntry per event and the named
+/// text blocks (macros, seeds, geometry) are appended after the records. The header is
+/// rewritten at every checkpoint, so readers can map the file and use the records in
+/// place. Numbers are stored in the byte order of the writing host.
+///
+/// This header does not depend on Geant4 or ROOT and can be used by analysis tools.
+
+#ifndef FlatFormat_h
+#define FlatFormat_h 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace flat{
+
+    const char kMagic[8] = { 'A', 'P', 'I', 'X', 'S', 'F', 'L', 'T' };
+    const uint32_t kVersion = 2;
+    const uint32_t kNumKinematics = 12;
+
+    struct FlatHeader{
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+            // bytes before the first record, including the field table
+        uint32_t record_size;
+        uint32_t nfields;
+        uint64_t nrecords;
+        uint64_t completed_events;
+        uint64_t index_offset;
+            // 0 until the file has been closed
+        uint64_t nindex;
+        uint64_t text_offset;
+        uint64_t text_size;
+    };
+
+    struct FlatField{
+        char name[16];
+        char type;
+            // 'i': int32, 'd': double, 'c': char
+        char pad[3];
+        uint32_t count;
+            // number of values (string length for 'c')
+        uint32_t offset;
+            // byte offset within the record
+        uint32_t reserved;
+    };
+
+    struct FlatStepRecord{
+        int32_t eventID;
+        int32_t trackID;
+        int32_t stepID;
+        int32_t parentID;
+        int32_t copy_n;
+            // detector ID of the volume
+        char particle[16];
+        char volume[16];
+        char process[16];
+        double kinematics[kNumKinematics];
+            // in the order of OutputSink::kinematics_names, Geant4 internal units
+    };
+
+    struct FlatEventEntry{
+        int64_t eventID;
+        uint64_t first;
+            // index of the first record of the event
+        uint64_t nrecords;
+    };
+
+    // Text blocks are stored as: uint32 name length, name, uint32 text length, text.
+
+    inline uint32_t HeaderSize( uint32_t nfields ){
+        size_t n = sizeof( FlatHeader ) + nfields*sizeof( FlatField );
+        return uint32_t( (n+63)/64*64 );
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/// \file FlatSink.hh
+/// \brief Definition of the FlatSink class
+
+#ifndef FlatSink_h
+#define FlatSink_h 1
+
+#include "OutputSink.hh"
+#include "FlatFormat.hh"
+
+#include <cstdio>
+#include <map>
+
+/// Output sink writing the self-describing flat binary format of FlatFormat.hh:
+/// a header, fixed-size step records and an event index, meant to be memory-mapped
+/// by analysis tools (see tools/FlatReader.hh).
+///
+/// The tables are streamed to files beside the output, name.table.tsv, whose sizes
+/// are saved in name.tables at every checkpoint. They are copied into text blocks of
+/// the output and removed when the file is closed.
+
+class FlatSink : public OutputSink{
+
+public:
+
+    FlatSink();
+    virtual ~FlatSink();
+
+    virtual G4bool Open( G4String name, G4bool resume );
+    virtual G4int GetResumedEvents(){ return header.completed_events; }
+
+    virtual void WriteEvent( vector<StepInfo>& steps );
+    virtual G4bool SupportsPartialEvents() const { return true; }
+    virtual void WriteEventPart( vector<StepInfo>& steps, G4bool first, G4bool last );
+    virtual void WriteText( G4String name, const vector<std::string>& lines );
+    virtual void FillTable( G4String name, const vector<std::string>& columns, const vector<G4double>& row );
+    virtual void WriteHistogram( G4String name, G4String title, G4double min, G4double max, const vector<G4double>& contents );
+    virtual void WriteHistogram2D( G4String name, G4String title, G4int nx, G4double xmin, G4double xmax,
+                                   G4int ny, G4double ymin, G4double ymax, const vector<G4double>& contents );
+    virtual void Checkpoint( G4int completed_events, const vector<std::string>& lines );
+    virtual void Close();
+
+private:
+
+    FILE* file;
+    G4String file_name;
+
+    flat::FlatHeader header;
+
+    vector<flat::FlatField> fields;
+    G4bool kinematics_enabled[kNumKinematics];
+        // kinematic fields of the step record
+    vector<flat::FlatStepRecord> records;
+        // records of the current event, or of the part being written
+    vector<flat::FlatEventEntry> index;
+
+    vector<std::string> text_names;
+    vector<std::string> text_blocks;
+        // written after the index when the file is closed
+
+    std::map< std::string, FILE* > tables;
+        // tab-separated tables being written, stored as text blocks when the file is closed
+    G4String GetTablePath( const std::string& table ) const { return file_name + "." + table + ".tsv"; }
+    G4String GetTableListPath() const { return file_name + ".tables"; }
+    void WriteTableList();
+        // Names and sizes of the tables, saved with each checkpoint.
+    G4bool RecoverTables();
+        // Cut the tables back to their sizes at the last checkpoint.
+    void CopyTable( const std::string& table, FILE* table_file );
+
+    void BuildFields();
+    void WriteHeader();
+
+    G4bool Recover();
+        // Reopen a file after its last checkpoint and rebuild the event index.
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
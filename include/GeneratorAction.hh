@@ -1,4 +1,3 @@
-
 // $Id: GeneratorAction.hh $
 //
 /// \file GeneratorAction.hh
@@ -12,10 +11,16 @@
 #include "G4ThreeVector.hh"
 #include "G4VPhysicalVolume.hh"
 
+#include <vector>
+#include <string>
+
 class G4GeneralParticleSource;
 class G4ParticleGun;
 class G4Event;
 class GeneratorMessenger;
+class ResponseMatrix;
+class AlphaSource;
+class DecaySource;
 
 class GeneratorAction : public G4VUserPrimaryGeneratorAction {
 
@@ -28,15 +33,77 @@ public:
     //void setGeneratorDistance(G4double);
     //void setGeneratorAngle(G4double);
 
+    void SetMasterSeeds( long seeds[], int len );
+        // Master seeds from which the random state of every event is derived.
+
+    void SetReplayEvent( G4int evt, G4int run = -1 );
+        // Simulate only the given event of the given run (current run if negative).
+
+    G4bool IsReplay() const { return replay_event>=0; }
+
+    void SetResponseMatrix( ResponseMatrix* r ){ response_matrix = r; }
+        // During /response/run the GPS shoots photons of the energy of the response sweep.
+
+    void SetGeneratorMode( G4String mode ){ generator_mode = mode; }
+        // "gps" (default), "alpha" for the tabulated alpha source or "decay" for the
+        // tabulated radioactive source.
+    G4String GetGeneratorMode() const { return generator_mode; }
+
+    void SetPrimariesPerEvent( G4int n ){ primaries_per_event = n; }
+        // Independent primaries generated in every event, to share the fixed cost of an
+        // event between several histories. Their tracks are told apart by GetPrimaryIndex
+        // of the EventAction, and they are written as separate events.
+    G4int GetPrimariesPerEvent() const { return primaries_per_event; }
+
+    G4int GetEventPrimaries() const { return event_primaries; }
+        // Primaries of the current event: 1 during /response/run and decay tabulations.
+    G4int GetPrimaryTag( G4int trackID ) const {
+        return trackID-1<G4int( primary_tags.size() ) ? primary_tags[trackID-1] : 0;
+    }
+        // Index of the primary a primary track (parent ID 0) was generated by.
+
+    std::vector<std::string> DescribeSource() const;
+        // Current GPS source: particle, position and angular distributions, with a
+        // fixed sample of both for the parameters that cannot be read back.
+
+    AlphaSource* GetAlphaSource(){ return alpha_source; }
+    DecaySource* GetDecaySource(){ return decay_source; }
+
+    void SetFirstEventID( G4int n ){ first_event_id = n; }
+        // Number the events of the run from n on and stop when the requested number of
+        // events is reached. Used when resuming a run from a checkpoint.
+
 private:
     GeneratorMessenger* primaryGeneratorMessenger;
 
     //G4double generator_distance;
     //G4double generator_angle;
-    //G4String generator_mode;
+    G4String generator_mode;
+
+    G4int primaries_per_event;
+    G4int event_primaries;
+    std::vector<G4int> primary_tags;
+        // per primary particle of the event, in the order of their track IDs
+    std::vector<G4int> vertex_end;
+        // number of vertices of the event after each primary
 
     //G4ParticleGun*  fParticleSource;
     G4GeneralParticleSource*  fgps;
+    AlphaSource* alpha_source;
+    DecaySource* decay_source;
+
+    void ReseedForEvent( G4int runID, G4int eventID );
+        // Set the engine seeds from (master seeds, run, event) so that every event
+        // can be regenerated on its own, independent of the events before it.
+
+    long master_seeds[2];
+
+    G4int replay_event;
+    G4int replay_run;
+
+    G4int first_event_id;
+
+    ResponseMatrix* response_matrix;
 
 };
 
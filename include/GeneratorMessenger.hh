@@ -1,4 +1,3 @@
-
 // $Id: GeneratorMessenger.hh $
 //
 /// \file GeneratorMessenger.hh
@@ -14,8 +13,15 @@
 
 class GeneratorAction;
 class G4UIdirectory;
+class G4UIcommand;
 class G4UIcmdWithAString;
 class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWith3Vector;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
 
 class GeneratorMessenger : public G4UImessenger
 {
@@ -32,10 +38,44 @@ private:
 
 	G4UIdirectory* primaryGeneratorDir;
 
-//	G4UIcmdWithADouble* generatorDistanceCmd;
-//	G4UIcmdWithADouble* generatorAngleCmd;
-//	G4UIcmdWithAString* generatorModeCmd;
+    G4UIcmdWithAString* generatorModeCmd;
+        // gps, alpha or decay.
+    G4UIcmdWithAnInteger* primariesCmd;
+        // Independent primaries per event.
+
+    // Tabulated alpha source.
+
+    G4UIdirectory* alphaDir;
+
+    G4UIcommand* alphaNuclideCmd;
+        // Nuclide and relative activity.
+    G4UIcommand* alphaLineCmd;
+        // Energy and intensity of a line.
+    G4UIcmdWithoutParameter* alphaClearCmd;
+    G4UIcommand* alphaEncapsulationCmd;
+        // Energy loss, straggling and tail.
+    G4UIcmdWith3VectorAndUnit* alphaPositionCmd;
+    G4UIcmdWithADoubleAndUnit* alphaRadiusCmd;
+    G4UIcmdWith3Vector* alphaAxisCmd;
+    G4UIcmdWithADoubleAndUnit* alphaMaxThetaCmd;
+    G4UIcmdWithAString* alphaAngularCmd;
+        // iso or cosine.
+    G4UIcmdWithoutParameter* alphaPrintCmd;
+
+    // Tabulated radioactive source.
+
+    G4UIdirectory* decayDir;
 
+    G4UIcmdWithAString* decayNuclideCmd;
+        // Load or tabulate the decays of a nuclide.
+    G4UIcmdWithABool* decayChainCmd;
+    G4UIcmdWithAnInteger* decayDecaysCmd;
+    G4UIcmdWithAString* decayCacheCmd;
+    G4UIcmdWithAString* decayFileCmd;
+    G4UIcmdWith3VectorAndUnit* decayPositionCmd;
+    G4UIcmdWithADoubleAndUnit* decayRadiusCmd;
+    G4UIcmdWith3Vector* decayAxisCmd;
+    G4UIcmdWithoutParameter* decayPrintCmd;
 };
 
 #endif
@@ -0,0 +1,97 @@
+/// \file GeometryProfiler.hh
+/// \brief Definition of the GeometryProfiler class
+
+#ifndef GeometryProfiler_h
+#define GeometryProfiler_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+
+class G4LogicalVolume;
+class G4SmartVoxelHeader;
+class ProfiledSolid;
+class OutputSink;
+
+/// Cost of the navigation per volume, enabled with --profile-geometry.
+///
+/// During each run the solid of every logical volume is replaced by a ProfiledSolid
+/// counting and timing Inside, SurfaceNormal, DistanceToIn and DistanceToOut, and the
+/// navigator of the tracking, a ProfiledNavigator, times the step, safety and location
+/// queries of each volume. The first is the time spent in the volume's own solid,
+/// whoever asks; the second the whole geometry cost of steps taken inside the volume,
+/// daughters tested included. The timer overhead, measured at the start of the run, is
+/// subtracted from both, the one of the solids also from the navigator queries around
+/// them.
+///
+/// At the end of the run the table is printed together with the smart voxels of every
+/// volume holding daughters, and a few findings: the solids dominating the time, slow
+/// Boolean solids, volumes with too many daughters per voxel or none at all.
+
+class GeometryProfiler{
+
+public:
+
+    GeometryProfiler();
+    ~GeometryProfiler();
+
+    void InstallNavigator();
+        // Replace the navigator of the tracking. To be called before the run manager
+        // is constructed.
+
+    void BeginOfRun();
+        // Wrap the solids and reset the counters.
+    void SetSink( OutputSink* s ){ sink = s; }
+    void EndOfRun();
+        // Restore the solids, print the report and write the tables to the sink.
+
+    G4bool IsActive() const { return active; }
+
+    enum { kComputeStep, kComputeSafety, kLocate, kNumQueries };
+
+    void AddNavigation( const G4LogicalVolume* lv, G4int query, const std::chrono::steady_clock::time_point& start,
+                        long long first_solid_call );
+        // Called by the ProfiledNavigator at the end of a query, with the count of
+        // ProfiledSolid calls at its start.
+
+private:
+
+    G4bool installed;
+    G4bool active;
+
+    OutputSink* sink;
+
+    G4double timer_overhead;
+        // ns per timed call.
+
+    std::vector< std::pair<G4LogicalVolume*, ProfiledSolid*> > wrapped;
+
+    struct Queries{
+        G4double calls[kNumQueries];
+        G4double time[kNumQueries];
+        Queries(){ for( G4int i=0; i<kNumQueries; i++ ) calls[i] = time[i] = 0; }
+    };
+    std::unordered_map<const G4LogicalVolume*, Queries> navigation;
+
+    struct Voxels{
+        G4int headers;
+        G4int nodes;
+        G4int max_candidates;
+        G4double candidates;
+        Voxels() : headers( 0 ), nodes( 0 ), max_candidates( 0 ), candidates( 0 ){}
+    };
+    void CountVoxels( const G4SmartVoxelHeader* header, Voxels& voxels ) const;
+
+    void MeasureTimerOverhead();
+
+    G4double GetCalls( const ProfiledSolid* solid ) const;
+    G4double GetTime( const ProfiledSolid* solid ) const;
+        // ns, timer overhead removed.
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
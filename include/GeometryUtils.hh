@@ -0,0 +1,32 @@
+/// \file GeometryUtils.hh
+/// \brief Helpers shared by the scorers, the sources and the geometry.
+
+#ifndef GeometryUtils_h
+#define GeometryUtils_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+/// True if name is the pattern, or starts with the pattern without its trailing '*'.
+/// The volume names given to the commands are matched this way.
+
+inline G4bool MatchesVolumePattern( const G4String& pattern, const G4String& name ){
+    if( !pattern.empty() && pattern[pattern.size()-1]=='*' )
+        return name.compare( 0, pattern.size()-1, pattern, 0, pattern.size()-1 )==0;
+    return name==pattern;
+}
+
+/// Unit vectors u and v such that u, v and the unit vector w form a right-handed basis.
+/// u is horizontal, i.e. normal to z, unless w is along z, where it is the x axis.
+
+inline void GetTransverseAxes( const G4ThreeVector& w, G4ThreeVector& u, G4ThreeVector& v ){
+    u = G4ThreeVector( 0, 0, 1 ).cross( w );
+    if( u.mag()<1e-9 )
+        u = G4ThreeVector( 1, 0, 0 );
+    u = u.unit();
+    v = w.cross( u );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,50 @@
+/// \file NullSink.hh
+/// \brief Definition of the NullSink class
+
+#ifndef NullSink_h
+#define NullSink_h 1
+
+#include "OutputSink.hh"
+
+/// Output sink that discards everything, used to measure the speed of the simulation
+/// alone. Only the number of accepted events and steps is reported when closed.
+
+class NullSink : public OutputSink{
+
+public:
+
+    NullSink() : OutputSink(), nevents( 0 ), nsteps( 0 ){}
+    virtual ~NullSink(){}
+
+    virtual G4bool Open( G4String, G4bool ){ return true; }
+
+    virtual void WriteEvent( vector<StepInfo>& steps ){
+        WriteEventPart( steps, true, true );
+    }
+
+    virtual G4bool SupportsPartialEvents() const { return true; }
+    virtual void WriteEventPart( vector<StepInfo>& steps, G4bool first, G4bool ){
+        if( first )
+            nevents++;
+        nsteps += steps.size();
+    }
+
+    virtual void WriteText( G4String, const vector<std::string>& ){}
+    virtual void FillTable( G4String, const vector<std::string>&, const vector<G4double>& ){}
+    virtual void WriteHistogram( G4String, G4String, G4double, G4double, const vector<G4double>& ){}
+    virtual void WriteHistogram2D( G4String, G4String, G4int, G4double, G4double, G4int, G4double, G4double, const vector<G4double>& ){}
+    virtual void Checkpoint( G4int, const vector<std::string>& ){}
+
+    virtual void Close(){
+        G4cout << "Null output: " << nevents << " events with " << nsteps << " steps discarded." << G4endl;
+    }
+
+private:
+
+    G4long nevents;
+    G4long nsteps;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
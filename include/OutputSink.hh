@@ -0,0 +1,86 @@
+/// \file OutputSink.hh
+/// \brief Definition of the OutputSink class
+
+#ifndef OutputSink_h
+#define OutputSink_h 1
+
+#include "globals.hh"
+#include "StepInfo.hh"
+
+#include <vector>
+#include <string>
+
+/// Interface between the user actions and the output file.
+///
+/// RunAction creates the sink selected with /output/format at the beginning of the run,
+/// EventAction hands it the steps of every accepted event, and RunAction writes the
+/// bookkeeping text (macros, seeds, geometry, checkpoints) through it.
+
+class OutputSink{
+
+public:
+
+    OutputSink() : runID( 0 ), jobID( 0 ), record_fields( StepFields::kAll ){}
+    virtual ~OutputSink(){}
+
+    void SetRunInfo( G4int run, G4long job ){ runID = run; jobID = job; }
+        // Run number and job identifier (first master seed) recorded with every event.
+
+    void SetFields( unsigned f ){ record_fields = f; }
+        // StepFields of the step record, set before Open. The other fields are not written.
+
+    virtual G4bool Open( G4String name, G4bool resume ) = 0;
+        // Create the output, or reopen it after its last checkpoint. False if this fails.
+
+    virtual G4int GetResumedEvents(){ return 0; }
+        // Number of completed events recorded in a resumed output.
+
+    virtual void WriteEvent( vector<StepInfo>& steps ) = 0;
+
+    virtual G4bool SupportsPartialEvents() const { return false; }
+    virtual void WriteEventPart( vector<StepInfo>& steps, G4bool /*first*/, G4bool /*last*/ ){ WriteEvent( steps ); }
+        // Write an event in consecutive pieces, used when its steps do not fit in memory.
+        // Only sinks that store steps as separate records support it.
+
+    virtual void WriteText( G4String name, const vector<std::string>& lines ) = 0;
+        // Named block of text stored with the data.
+
+    virtual void FillTable( G4String name, const vector<std::string>& columns, const vector<G4double>& row ) = 0;
+        // Append a row to a named table of numbers, created with these columns on first use.
+
+    virtual void WriteHistogram( G4String name, G4String title, G4double min, G4double max, const vector<G4double>& contents ) = 0;
+        // Fixed-width histogram over [min,max]. contents holds the underflow, the bins and the overflow.
+
+    virtual void WriteHistogram2D( G4String name, G4String title, G4int nx, G4double xmin, G4double xmax,
+                                   G4int ny, G4double ymin, G4double ymax, const vector<G4double>& contents ) = 0;
+        // Same in two dimensions, with (nx+2)*(ny+2) values, x running fastest.
+
+    virtual void WriteMacroFile( G4String path );
+        // Store a macro file as text under its base name.
+
+    virtual void Checkpoint( G4int completed_events, const vector<std::string>& lines ) = 0;
+        // Make everything written so far recoverable and record the checkpoint text.
+
+    virtual void Close() = 0;
+
+    // Kinematic quantities stored for every step, in the order of kinematics_names.
+    enum { kX, kY, kZ, kTheta, kPhi, kPx, kPy, kPz, kT, kEki, kEkf, kEdep, kNumKinematics };
+    static const char* kinematics_names[kNumKinematics];
+
+    static void GetKinematics( StepInfo& step, double* values, const G4bool* enabled = 0 );
+        // Fill values from the step. Fields not enabled are left untouched.
+
+    static unsigned GetKinematicsField( G4int k );
+        // StepFields member the kinematic quantity k is computed from.
+
+protected:
+
+    G4int runID;
+    G4long jobID;
+
+    unsigned record_fields;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
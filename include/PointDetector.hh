@@ -0,0 +1,123 @@
+/// \file PointDetector.hh
+/// \brief Definition of the PointDetector class
+
+#ifndef PointDetector_h
+#define PointDetector_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+
+class G4Step;
+class G4VPhysicalVolume;
+class G4Material;
+class G4Navigator;
+class OutputSink;
+class PointDetectorMessenger;
+
+/// Next-event estimator of the photon fluence at points, set up with the /pointDetector/ commands.
+///
+/// At every photon creation and every Compton or Rayleigh scattering in the source
+/// volumes (the targets and the wheel by default), the probability that the photon
+/// reaches each point without interacting is added to the point's tally:
+///
+///     w p(Ω) exp(-τ) / R²
+///
+/// where p(Ω) is the emission probability per steradian towards the point (isotropic
+/// for created photons, Klein-Nishina or Rayleigh for scatterings, with the energy
+/// of the scattered photon), R the distance and τ the attenuation along the straight
+/// path through the materials of the geometry. The attenuation coefficients of all
+/// materials are tabulated at the start of the run. The photons themselves are tracked
+/// as usual: the estimator only scores, so it can be combined with /xray/yieldOnly.
+///
+/// The tally of each event is accumulated with its square, and the mean fluence per
+/// primary and its standard error are printed and written in the point_detectors table
+/// at the end of the run, with the energy spectrum of the fluence at each point.
+/// Contributions closer than the exclusion radius are scored at the exclusion radius
+/// to keep the variance finite.
+
+class PointDetector{
+
+public:
+
+    PointDetector();
+    ~PointDetector();
+
+    void AddPoint( G4ThreeVector pos, G4String name );
+    void Clear();
+    G4bool IsEnabled() const { return !points.empty(); }
+
+    void SetVolumes( G4String patterns );
+        // Names of the source volumes separated by spaces, a trailing '*' matches any suffix.
+
+    void SetExclusionRadius( G4double r ){ exclusion_radius = r; }
+
+    void SetHistogram( G4int n, G4double min, G4double max );
+        // Binning of the fluence spectra.
+
+    void BeginOfRun();
+        // Locate the world and tabulate the attenuation coefficients.
+    void SetSink( OutputSink* s ){ sink = s; }
+    void EndOfRun( G4int nevents, G4double primaries_per_event = 1 );
+        // Print and write the tallies, normalised per primary.
+
+    void ProcessStep( const G4Step* );
+        // Score the photons created or scattered in the step.
+    void EndOfEvent();
+        // Add the scores of the event to the run tallies.
+
+private:
+
+    PointDetectorMessenger* messenger;
+
+    struct Point{
+        G4String name;
+        G4ThreeVector position;
+
+        G4double event_score;
+        G4double sum;
+        G4double sum2;
+        G4double contributions;
+        std::vector<G4double> spectrum;
+    };
+
+    std::vector<Point> points;
+    std::vector<size_t> scored;
+        // points with a score in the current event
+
+    std::vector<G4String> volume_patterns;
+    std::unordered_map<const G4VPhysicalVolume*, G4bool> is_source;
+    G4bool IsSource( const G4VPhysicalVolume* );
+
+    G4double exclusion_radius;
+
+    G4int nbins;
+    G4double emin;
+    G4double emax;
+
+    OutputSink* sink;
+
+    // Attenuation
+    G4Navigator* navigator;
+
+    static const G4int ntable = 400;
+    static const G4double table_emin;
+    static const G4double table_emax;
+    std::map<const G4Material*, std::vector<G4double> > mu_table;
+        // linear attenuation coefficient on a logarithmic energy grid
+
+    G4double GetAttenuationCoefficient( const G4Material*, G4double energy );
+    G4double GetOpticalDepth( const G4ThreeVector& from, const G4ThreeVector& dir, G4double distance, G4double energy );
+
+    void Score( const G4ThreeVector& pos, const G4ThreeVector& dir, G4double energy, G4double weight, G4int type );
+        // type 0 for isotropic emission, 1 for Compton, 2 for Rayleigh scattering
+        // of a photon going along dir.
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,42 @@
+/// \file PointDetectorMessenger.hh
+/// \brief Definition of the PointDetectorMessenger class
+
+#ifndef PointDetectorMessenger_h
+#define PointDetectorMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class PointDetector;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class PointDetectorMessenger: public G4UImessenger{
+
+public:
+
+    PointDetectorMessenger( PointDetector* );
+    virtual ~PointDetectorMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    PointDetector* estimator;
+
+    G4UIdirectory* directory;
+
+    G4UIcommand* addCmd;
+        // Position and optional name of a point.
+    G4UIcmdWithoutParameter* clearCmd;
+    G4UIcmdWithAString* volumeCmd;
+        // Source volumes, a trailing * matches any suffix.
+    G4UIcmdWithADoubleAndUnit* exclusionCmd;
+    G4UIcommand* histogramCmd;
+        // Binning of the spectra.
+};
+
+#endif
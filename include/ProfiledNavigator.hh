@@ -0,0 +1,43 @@
+/// \file ProfiledNavigator.hh
+/// \brief Definition of the ProfiledNavigator class
+
+#ifndef ProfiledNavigator_h
+#define ProfiledNavigator_h 1
+
+#include "G4Navigator.hh"
+
+class GeometryProfiler;
+
+/// Navigator of the tracking timing ComputeStep, ComputeSafety and the point location
+/// for the GeometryProfiler. The time is booked to the logical volume the navigator is
+/// in, or for the location to the volume found.
+///
+/// The stepping manager keeps the navigator it finds when the run manager is built,
+/// so GeometryProfiler::InstallNavigator() must be called before that.
+
+class ProfiledNavigator : public G4Navigator{
+
+public:
+
+    ProfiledNavigator( GeometryProfiler* profiler );
+    virtual ~ProfiledNavigator();
+
+    virtual G4double ComputeStep( const G4ThreeVector& pGlobalPoint, const G4ThreeVector& pDirection,
+                                  const G4double pCurrentProposedStepLength, G4double& pNewSafety );
+
+    virtual G4double ComputeSafety( const G4ThreeVector& globalPoint, const G4double pProposedMaxLength = DBL_MAX,
+                                    const G4bool keepState = true );
+
+    virtual G4VPhysicalVolume* LocateGlobalPointAndSetup( const G4ThreeVector& point, const G4ThreeVector* direction = 0,
+                                                          const G4bool pRelativeSearch = true, const G4bool ignoreDirection = true );
+
+private:
+
+    GeometryProfiler* profiler;
+
+    const G4LogicalVolume* GetCurrentVolume() const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
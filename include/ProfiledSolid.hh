@@ -0,0 +1,86 @@
+/// \file ProfiledSolid.hh
+/// \brief Definition of the ProfiledSolid class
+
+#ifndef ProfiledSolid_h
+#define ProfiledSolid_h 1
+
+#include "G4VSolid.hh"
+
+#include <chrono>
+
+/// Solid counting and timing the navigation calls of the solid it wraps, installed by
+/// the GeometryProfiler in place of the solid of a logical volume. Everything else is
+/// passed through, and the entity type is the one of the wrapped solid.
+
+class ProfiledSolid : public G4VSolid{
+
+public:
+
+    ProfiledSolid( G4VSolid* solid );
+    virtual ~ProfiledSolid();
+
+    G4VSolid* GetSolid() const { return solid; }
+
+    enum { kInside, kSurfaceNormal, kDistanceToInPV, kDistanceToInP, kDistanceToOutPV, kDistanceToOutP, kNumMethods };
+    static const char* method_names[kNumMethods];
+
+    G4double GetCalls( G4int method ) const { return calls[method]; }
+    G4double GetTime( G4int method ) const { return time[method]; }
+        // ns, timer included
+    void Reset();
+
+    static long long GetTotalCalls(){ return total_calls; }
+        // Timed calls of all the profiled solids, to correct the timers they add to
+        // the navigator queries.
+
+    virtual EInside Inside( const G4ThreeVector& p ) const;
+    virtual G4ThreeVector SurfaceNormal( const G4ThreeVector& p ) const;
+    virtual G4double DistanceToIn( const G4ThreeVector& p, const G4ThreeVector& v ) const;
+    virtual G4double DistanceToIn( const G4ThreeVector& p ) const;
+    virtual G4double DistanceToOut( const G4ThreeVector& p, const G4ThreeVector& v, const G4bool calcNorm = false,
+                                    G4bool* validNorm = 0, G4ThreeVector* n = 0 ) const;
+    virtual G4double DistanceToOut( const G4ThreeVector& p ) const;
+
+    virtual void ComputeDimensions( G4VPVParameterisation* p, const G4int n, const G4VPhysicalVolume* pRep );
+    virtual void BoundingLimits( G4ThreeVector& pMin, G4ThreeVector& pMax ) const;
+    virtual G4bool CalculateExtent( const EAxis pAxis, const G4VoxelLimits& pVoxelLimit, const G4AffineTransform& pTransform,
+                                    G4double& pMin, G4double& pMax ) const;
+
+    virtual G4double GetCubicVolume();
+    virtual G4double GetSurfaceArea();
+    virtual G4GeometryType GetEntityType() const;
+    virtual G4ThreeVector GetPointOnSurface() const;
+    virtual G4VSolid* Clone() const;
+    virtual std::ostream& StreamInfo( std::ostream& os ) const;
+
+    virtual void DescribeYourselfTo( G4VGraphicsScene& scene ) const;
+    virtual G4VisExtent GetExtent() const;
+    virtual G4Polyhedron* CreatePolyhedron() const;
+    virtual G4Polyhedron* GetPolyhedron() const;
+
+    virtual const G4VSolid* GetConstituentSolid( G4int no ) const;
+    virtual G4VSolid* GetConstituentSolid( G4int no );
+    virtual const G4DisplacedSolid* GetDisplacedSolidPtr() const;
+    virtual G4DisplacedSolid* GetDisplacedSolidPtr();
+
+private:
+
+    G4VSolid* solid;
+
+    mutable G4double calls[kNumMethods];
+    mutable G4double time[kNumMethods];
+
+    static long long total_calls;
+
+    typedef std::chrono::steady_clock Clock;
+
+    void Count( G4int method, const Clock::time_point& start ) const {
+        calls[method] += 1;
+        total_calls++;
+        time[method] += std::chrono::duration<double, std::nano>( Clock::now()-start ).count();
+    }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,110 @@
+/// \file ResponseMatrix.hh
+/// \brief Definition of the ResponseMatrix class
+
+#ifndef ResponseMatrix_h
+#define ResponseMatrix_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+class G4Step;
+class G4VPhysicalVolume;
+class OutputSink;
+class ResponseMatrixMessenger;
+
+/// Detector response matrices from monochromatic photon sweeps, set up with the /response/ commands.
+///
+/// /response/run simulates a fixed number of photons at each energy of the incident
+/// grid, with the position and direction distributions of the GPS, and histograms the
+/// energy deposited in each detector volume per photon. The counts, incident energy
+/// along x and deposited energy along y, are written as the response_<detector>
+/// histograms and saved in the cache directory under a key made of the geometry,
+/// the physics list, the fluorescence, Auger and PIXE settings, the current GPS
+/// source and the binning. A later /response/run with the same key reads the matrices back instead of
+/// simulating. apixs-fold applies a matrix to an emission spectrum.
+///
+/// Deposited-energy bin 0 counts the photons that deposit nothing in the detector.
+
+class ResponseMatrix{
+
+public:
+
+    ResponseMatrix();
+    ~ResponseMatrix();
+
+    void SetDetectors( G4String patterns );
+        // Names of the detector volumes separated by spaces, a trailing '*' matches any suffix.
+
+    void SetIncident( G4int n, G4double min, G4double max );
+        // Incident energies at the centers of n bins between min and max.
+    void SetDeposit( G4int n, G4double max );
+        // Deposited energy histogram from 0 to max.
+    void SetPhotons( G4int n ){ photons = n; }
+        // Photons simulated per incident energy.
+    void SetCacheDirectory( G4String dir ){ cache_dir = dir; }
+    void SetForce( G4bool b ){ force = b; }
+        // Simulate even if the matrices are in the cache.
+
+    void Run();
+        // Generate the matrices: start a run of photons times incident energies events.
+
+    G4bool IsActive() const { return active; }
+        // True during the run started by Run().
+
+    G4double GetIncidentEnergy( G4int eventID ) const;
+
+    G4bool BeginOfRun( const std::vector<std::string>& geometry, const std::vector<std::string>& source );
+        // Compute the cache key from the geometry, the GPS source and the atomic
+        // de-excitation settings, and read the matrices if they are all cached. Returns
+        // true in that case, and the run can be aborted.
+    void SetSink( OutputSink* s ){ sink = s; }
+    void EndOfRun( G4int nevents );
+        // Write the matrices to the output and to the cache.
+
+    void ProcessStep( const G4Step* );
+    void EndOfEvent( G4int eventID );
+
+private:
+
+    ResponseMatrixMessenger* messenger;
+
+    G4bool active;
+    G4bool cached;
+    G4bool force;
+
+    std::vector<G4String> detector_patterns;
+    std::vector<G4String> detectors;
+        // detector volume names, in the order of the volume store
+    std::unordered_map<const G4VPhysicalVolume*, G4int> detector_index;
+    G4int GetDetector( const G4VPhysicalVolume* );
+
+    G4int nincident;
+    G4double incident_min;
+    G4double incident_max;
+
+    G4int ndeposit;
+    G4double deposit_max;
+
+    G4int photons;
+
+    G4String cache_dir;
+    G4String key;
+
+    OutputSink* sink;
+
+    std::vector< std::vector<G4double> > counts;
+        // per detector, (nincident+2) x (ndeposit+2) with the incident energy along x
+    std::vector<G4double> edep;
+        // energy deposited in each detector in the current event
+
+    G4String CacheFile( size_t detector ) const;
+    G4bool ReadCache( size_t detector );
+    void WriteCache( size_t detector ) const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
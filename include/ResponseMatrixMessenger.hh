@@ -0,0 +1,45 @@
+/// \file ResponseMatrixMessenger.hh
+/// \brief Definition of the ResponseMatrixMessenger class
+
+#ifndef ResponseMatrixMessenger_h
+#define ResponseMatrixMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class ResponseMatrix;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+class ResponseMatrixMessenger: public G4UImessenger{
+
+public:
+
+    ResponseMatrixMessenger( ResponseMatrix* );
+    virtual ~ResponseMatrixMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    ResponseMatrix* response;
+
+    G4UIdirectory* directory;
+
+    G4UIcmdWithAString* detectorCmd;
+        // Detector volumes, a trailing * matches any suffix.
+    G4UIcommand* incidentCmd;
+        // Grid of incident energies.
+    G4UIcommand* depositCmd;
+        // Binning of the deposited energy.
+    G4UIcmdWithAnInteger* photonsCmd;
+    G4UIcmdWithAString* cacheCmd;
+    G4UIcmdWithABool* forceCmd;
+    G4UIcmdWithoutParameter* runCmd;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/// \file RootSink.hh
+/// \brief Definition of the RootSink class
+
+#ifndef RootSink_h
+#define RootSink_h 1
+
+#include "OutputSink.hh"
+
+#include "Rtypes.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+class TFile;
+class TTree;
+class TBranch;
+
+/// Output sink writing ROOT trees in one of three layouts:
+/// "event": one entry per event in the events tree, with an array per field,
+/// "step": one row per step in the events tree,
+/// "track": per-track constants in the tracks tree and per-step kinematics in the steps tree.
+
+class RootSink : public OutputSink{
+
+public:
+
+    RootSink( G4String schema, const std::map< G4String, G4String >& leaf_types );
+    virtual ~RootSink();
+
+    virtual G4bool Open( G4String name, G4bool resume );
+    virtual G4int GetResumedEvents();
+
+    virtual void WriteEvent( vector<StepInfo>& steps );
+    virtual G4bool SupportsPartialEvents() const { return !columnar; }
+    virtual void WriteEventPart( vector<StepInfo>& steps, G4bool first, G4bool last );
+    virtual void WriteText( G4String name, const vector<std::string>& lines );
+    virtual void FillTable( G4String name, const vector<std::string>& columns, const vector<G4double>& row );
+    virtual void WriteHistogram( G4String name, G4String title, G4double min, G4double max, const vector<G4double>& contents );
+    virtual void WriteHistogram2D( G4String name, G4String title, G4int nx, G4double xmin, G4double xmax,
+                                   G4int ny, G4double ymin, G4double ymax, const vector<G4double>& contents );
+    virtual void Checkpoint( G4int completed_events, const vector<std::string>& lines );
+    virtual void Close();
+
+private:
+
+    G4String schema;
+
+    std::map< G4String, G4String > leaf_types;
+        // ROOT leaf type code per kinematic field, "" for fields not written.
+
+    G4String GetLeafType( G4String field ) const;
+
+    TFile* output_file;
+
+    TTree* data_tree;
+        // events tree, one entry per step ("step" schema) or per event ("event" schema)
+    TTree* track_tree;
+    TTree* step_tree;
+        // one entry per track and one per step, used with the "track" output schema
+
+    TTree* index_tree;
+        // event_index: entry range of every event in the data trees, with a summary of
+        // the energy deposited in the detectors for coincidence selections.
+
+    G4bool columnar;
+        // true for the "event" schema
+
+    // Tables filled through FillTable, one TTree with a double branch per column.
+    struct Table{
+        TTree* tree;
+        vector<G4double> row;
+    };
+    std::map< G4String, Table > tables;
+
+    void BeginIndex( vector<StepInfo>& );
+    void AddToIndex( vector<StepInfo>& );
+    void EndIndex();
+        // The index entry of an event is built over the parts it is written in.
+
+    std::set< std::pair<G4String, G4int> > farside_hit;
+        // far-side detectors hit in the event, by name and detector ID
+
+    // event_index entry
+    int index_eventID;
+    int index_runID;
+    Long64_t index_job;
+    Long64_t index_first;
+    Long64_t index_n;
+    Long64_t index_first_step;
+    Long64_t index_nsteps;
+    double edep_center;
+    double edep_farside;
+    int nfarside;
+
+    void Bind( TTree* tree, const char* name, void* address, const char* leaflist );
+        // Create the branch, or attach to it if the tree was read back from a resumed file.
+
+    void BindTrees();
+    void BindColumns();
+
+    void CopyStep( StepInfo& );
+        // Copy one step into the variables attached to the branches.
+
+    void FillSteps( vector<StepInfo>& );
+    void FillTracks( vector<StepInfo>& );
+    void FillEvent( vector<StepInfo>& );
+
+    int eventID;
+    int trackID;
+    int stepID;
+    int parentID;
+    int nsteps;
+    int volume_copy_number;
+        // detector ID of the volume, see DetectorConstruction::GetDetectorID
+
+    G4String tmp_particle_name;
+    G4String tmp_volume_name;
+    G4String tmp_process_name;
+
+    double kinematics[kNumKinematics];
+    G4bool kinematics_enabled[kNumKinematics];
+        // fields switched off with /output/precision or outside the step record are
+        // neither computed nor written
+
+    int max_char_len;
+    char particle_name[16];
+    char volume_name[16];
+    char process_name[16];
+
+    // Per-event columns of the "event" schema, filled from the step buffer and written
+    // as variable-length arrays with a single Fill per event.
+    enum { kTrackID, kStepID, kParentID, kNumIDs };
+
+    vector<int> id_columns[kNumIDs];
+    vector<double> kinematics_columns[kNumKinematics];
+
+    vector<std::string> particle_column;
+    vector<std::string> volume_column;
+    vector<std::string> process_column;
+    vector<int> copy_column;
+
+    vector<std::string>* particle_column_ptr;
+    vector<std::string>* volume_column_ptr;
+    vector<std::string>* process_column_ptr;
+        // ROOT needs the address of a pointer to attach object branches.
+
+    TBranch* id_branches[kNumIDs];
+    TBranch* kinematics_branches[kNumKinematics];
+    TBranch* copy_branch;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -1,4 +1,3 @@
-
 /// \file RunAction.hh
 /// \brief Definition of the RunAction class
 
@@ -7,16 +6,27 @@
 
 #include "G4UserRunAction.hh"
 #include "globals.hh"
-
-#include "TFile.h"
-#include "TTree.h"
-#include "TMacro.h"
+#include "StepInfo.hh"
 
 #include <vector>
+#include <map>
 #include <sstream>
 
 class G4Run;
+class G4Event;
 class RunActionMessenger;
+class GeneratorAction;
+class OutputSink;
+class Trigger;
+class StepFilter;
+class XrayTally;
+class SphereScorer;
+class PointDetector;
+class ResponseMatrix;
+class ConvergenceMonitor;
+class GeometryProfiler;
+class ScoringMesh;
+class RunMetrics;
 
 class RunAction : public G4UserRunAction {
 
@@ -39,20 +49,160 @@ public:
             random_seeds.push_back( seeds[i]);
     }
 
-    TTree* GetDataTree();
+    RunMetrics* GetMetrics(){ return metrics; }
+        // Counters of the event loop, published by a background thread with /metrics/.
+
+    OutputSink* GetSink(){ return sink; }
+        // Output of the current run, 0 if nothing is written.
+
+    void SetFormat( G4String s ){ format = s; }
+        // "root", "flat" (memory-mappable binary records) or "null" (discard everything).
+
+    void SetSchema( G4String s ){ schema = s; }
+        // Layout of the ROOT output.
+        // "step": one row per step in the events tree, the default.
+        // "track": per-track constants in the tracks tree and per-step kinematics in the steps tree.
+        // "event": one entry per event in the events tree, with an array per field.
+
+    void SetGeneratorAction( GeneratorAction* gen ){ generator = gen; }
+        // Needed to continue the event numbering when resuming a run.
+    GeneratorAction* GetGeneratorAction(){ return generator; }
+
+    G4bool IsTabulating() const { return tabulating; }
+        // True during the hidden run of a decay tabulation, which writes and scores nothing.
+
+    void SetTrigger( Trigger* t ){ trigger = t; }
+        // Its efficiency counters are reset at the start of each run, printed and written at the end.
+
+    void SetStepFilter( StepFilter* f ){ step_filter = f; }
+        // Compiled at the start of each run, its statistics printed at the end.
+
+    void SetXrayTally( XrayTally* t ){ xray_tally = t; }
+        // Written to the output at the end of each run.
+
+    void SetResponseMatrix( ResponseMatrix* r ){ response_matrix = r; }
+        // Response matrices, generated or read from the cache in the runs started by /response/run.
+
+    void SetPointDetector( PointDetector* p ){ point_detector = p; }
+        // Fluence tallies of the next-event estimator, written at the end of each run.
+
+    void SetSphereScorer( SphereScorer* s ){ sphere_scorer = s; }
+        // Histograms of the scoring sphere, written at the end of each run if it is placed.
+
+    void SetConvergenceMonitor( ConvergenceMonitor* c ){ convergence = c; }
+        // Stops the run when its tally reaches the precision goal or the time limit is spent.
+
+    void SetScoringMesh( ScoringMesh* m ){ mesh = m; }
+        // Voxels of the volumes of /mesh/, written at the end of each run.
+
+    void SetGeometryProfiler( GeometryProfiler* p ){ geometry_profiler = p; }
+        // Times the navigation in each volume during the runs, see --profile-geometry.
+
+    void SetResume( G4bool b ){ resume = b; }
+        // Continue into an existing output file from its last checkpoint. Applies to
+        // the first run that opens the file only.
+
+    void SetCheckpointInterval( G4int n ){ checkpoint_interval = n; }
+
+    G4bool SetRecord( G4String name );
+        // Fields of the recorded steps: "full", "calorimetric" or "xray", see StepInfo.hh.
+        // False for an unknown name.
+    const StepInfo::RecordType* GetRecordType() const { return record_type; }
+
+    void SetPrecision( G4String field, G4String mode, G4double min, G4double max, G4int nbits );
+        // Storage type of a kinematic field: double, float, double32 (truncated mantissa),
+        // fixed (nbits over [min,max]) or off (field not written). nbits 0 takes the
+        // default of the mode, 14 for double32 and 16 for fixed.
+
+    void SetMaxEventMemory( G4double bytes ){ max_event_memory = bytes; }
+    G4double GetMaxEventMemory() const { return max_event_memory; }
+        // Memory allowed for the steps of one event, 0 for no limit.
+
+    void SetOverflowMode( G4String s ){ overflow_mode = s; }
+    G4String GetOverflowMode() const { return overflow_mode; }
+        // What happens to the steps past the limit: "spill" to a temporary file, or "truncate".
+
+    void EventBuffered( G4int eventID, G4double buffer_bytes, G4double spilled_bytes, G4bool truncated );
+        // Memory used by the steps of an event, for the report at the end of the run.
+
+    void EventCompleted( const G4Event*, G4int nsteps, G4bool accepted );
+        // Called by EventAction after the event has been written. Triggers checkpoints,
+        // and stops the run once the convergence goal is met.
 
 private:
 
     G4String output_name = "";
     
-    TFile* output_file;
-    TTree* data_tree;
+    OutputSink* sink;
+
+    G4String format;
+    G4String schema;
+
+    std::map< G4String, G4String > leaf_types;
+
+    const StepInfo::RecordType* record_type;
 
     std::vector< G4String > macros;
     std::vector< long > random_seeds;
 
+    RunActionMessenger* fRunActionMessenger;
+
+    RunMetrics* metrics;
+
+    GeneratorAction* generator;
+
+    Trigger* trigger;
+
+    StepFilter* step_filter;
+
+    XrayTally* xray_tally;
+
+    SphereScorer* sphere_scorer;
+
+    PointDetector* point_detector;
+
+    ResponseMatrix* response_matrix;
+
+    ConvergenceMonitor* convergence;
+
+    ScoringMesh* mesh;
+
+    GeometryProfiler* geometry_profiler;
+
+    G4bool resume;
+
+    G4bool tabulating;
+
+    G4int checkpoint_interval;
+    G4int completed_events;
+        // Events completed so far, including the ones of the run being resumed.
+    G4int events_since_checkpoint;
+
+    G4int run_events;
+        // events simulated in the run, without the ones skipped when resuming
+    G4double run_primaries;
+        // primaries simulated in the run, several per event with /generator/primaries
+
+    G4double max_event_memory;
+    G4String overflow_mode;
+
+    // Step buffering statistics of the run
+    G4double peak_buffer;
+    G4int peak_buffer_event;
+    G4double peak_spilled;
+    G4int nspilled;
+    std::vector< G4int > truncated_events;
+
+    void Checkpoint( const G4Run* );
+
+    void PrintBufferStatistics() const;
+
+    std::vector< std::string > DescribeGeometry() const;
+        // Description of the volumes and physics constructors, used to check that split jobs can be merged
+        // and as the key of the cached response matrices.
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #endif
+
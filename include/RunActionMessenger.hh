@@ -0,0 +1,53 @@
+/// \file RunActionMessenger.hh
+/// \brief Definition of the RunActionMessenger class
+
+#ifndef RunActionMessenger_h
+#define RunActionMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class RunAction;
+class G4UIdirectory;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+class G4UIcommand;
+
+class RunActionMessenger: public G4UImessenger{
+
+public:
+
+    RunActionMessenger( RunAction* );
+    virtual ~RunActionMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    RunAction* run_action;
+
+    G4UIdirectory* directory;
+
+    G4UIcmdWithAnInteger* checkpointCmd;
+        // Number of events between two checkpoints of the output file. 0 disables checkpoints.
+
+    G4UIcmdWithAString* formatCmd;
+        // Output backend.
+
+    G4UIcmdWithAString* schemaCmd;
+        // Layout of the output trees.
+
+    G4UIcmdWithAString* recordCmd;
+        // Fields of the recorded steps.
+
+    G4UIcommand* precisionCmd;
+        // Storage precision of a kinematic field.
+
+    G4UIcommand* memoryCmd;
+        // Memory allowed for the steps of one event.
+
+    G4UIcmdWithAString* overflowCmd;
+        // What to do with the steps past the memory limit.
+};
+
+#endif
@@ -0,0 +1,108 @@
+/// \file RunMetrics.hh
+/// \brief Definition of the RunMetrics class
+
+#ifndef RunMetrics_h
+#define RunMetrics_h 1
+
+#include "globals.hh"
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+class RunMetricsMessenger;
+
+/// Live metrics of the run, set up with the /metrics/ commands.
+///
+/// The event loop only updates a few counters at the end of each event. A background
+/// thread samples them at a fixed interval, together with the size of the output file
+/// and the resident memory of the process, and publishes a JSON object with the event
+/// and step rates, the events accepted by the trigger, the bytes written, the RSS and
+/// the estimated time left:
+///
+///     /metrics/file    rewrites a file at every sample (written aside and renamed, so
+///                      readers never see a partial file);
+///     /metrics/socket  listens on a Unix socket and answers every connection with the
+///                      current metrics, e.g. with  nc -U <socket>.
+///
+/// The "---> End of event" lines of /run/printProgress are printed at most once per
+/// print interval, with the rate and the time left.
+
+class RunMetrics{
+
+public:
+
+    RunMetrics();
+    ~RunMetrics();
+
+    void SetFile( G4String name ){ file_name = name; }
+    void SetSocket( G4String name ){ socket_name = name; }
+        // Empty to disable.
+    void SetInterval( G4double t ){ interval = t; }
+        // Sampling period of the background thread.
+    void SetPrintInterval( G4double t ){ print_interval = t; }
+        // Shortest time between two progress lines, 0 for no limit.
+
+    void BeginOfRun( G4int runID, G4int nevents, G4String output );
+        // Reset the counters and start the sampling thread if there is a file or a socket.
+    void EndOfRun();
+        // Publish the final metrics and stop the thread.
+
+    void EventDone( G4int nsteps, G4bool accepted ){
+        events.store( events.load( std::memory_order_relaxed )+1, std::memory_order_relaxed );
+        steps.store( steps.load( std::memory_order_relaxed )+nsteps, std::memory_order_relaxed );
+        if( accepted )
+            accepted_events.store( accepted_events.load( std::memory_order_relaxed )+1, std::memory_order_relaxed );
+    }
+        // Called by the event loop only, the thread reads the counters.
+
+    void PrintProgress( G4int eventID );
+        // Progress line of the event if /run/printProgress asks for it and the print
+        // interval has passed.
+
+private:
+
+    RunMetricsMessenger* messenger;
+
+    G4String file_name;
+    G4String socket_name;
+    G4double interval;
+    G4double print_interval;
+
+    // Run
+    G4int run_id;
+    G4int total_events;
+    G4String output_name;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last_print;
+
+    std::atomic<long long> events;
+    std::atomic<long long> steps;
+    std::atomic<long long> accepted_events;
+
+    // Sampling thread
+    std::thread thread;
+    int wake_pipe[2];
+        // written to stop the thread
+    int listen_fd;
+
+    long long sampled_events;
+    long long sampled_steps;
+    G4double sampled_time;
+    std::string json;
+        // last sample, owned by the thread while it runs
+
+    void Loop();
+    void Sample( G4bool finished );
+        // Build the JSON of the current counters and rewrite the file.
+    void Serve();
+        // Answer the pending connections of the socket.
+
+    G4bool OpenSocket();
+    void CloseSocket();
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
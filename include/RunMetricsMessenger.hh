@@ -0,0 +1,40 @@
+/// \file RunMetricsMessenger.hh
+/// \brief Definition of the RunMetricsMessenger class
+
+#ifndef RunMetricsMessenger_h
+#define RunMetricsMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class RunMetrics;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+
+class RunMetricsMessenger: public G4UImessenger{
+
+public:
+
+    RunMetricsMessenger( RunMetrics* );
+    virtual ~RunMetricsMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    RunMetrics* metrics;
+
+    G4UIdirectory* directory;
+
+    G4UIcmdWithAString* fileCmd;
+        // JSON file rewritten at every sample.
+    G4UIcmdWithAString* socketCmd;
+        // Unix socket answering with the current metrics.
+    G4UIcmdWithADoubleAndUnit* intervalCmd;
+        // Sampling period.
+    G4UIcmdWithADoubleAndUnit* printCmd;
+        // Shortest time between two progress lines.
+};
+
+#endif
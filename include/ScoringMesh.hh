@@ -0,0 +1,112 @@
+/// \file ScoringMesh.hh
+/// \brief Definition of the ScoringMesh class
+
+#ifndef ScoringMesh_h
+#define ScoringMesh_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+class G4Step;
+class G4LogicalVolume;
+class OutputSink;
+class ScoringMeshMessenger;
+
+/// Sparse 3D scoring mesh, attached to logical volumes with the /mesh/ commands.
+///
+/// The volumes are cut in a grid of voxels, in the frame of each volume (origin at its
+/// centre) or of the world, and per voxel are accumulated
+///
+///     edep:   energy deposited, put at the middle of the step, with its statistical
+///             error from the spread of the event sums;
+///     tracks: tracks entering the voxel, i.e. steps of a track taken in another voxel
+///             than its previous step;
+///     xrays:  photons created, at their vertex.
+///
+/// Only the voxels that are hit are stored, in a hash table keyed by the volume and
+/// the three voxel indices, so the memory follows the occupied voxels and not the
+/// size of the grid. Each logical volume has its mesh, shared by its copies; the
+/// targets and detectors are one logical volume each. The voxels are written at the
+/// end of the run, one row per voxel in the mesh table.
+///
+/// The mesh is not checkpointed: a run continued with --resume scores only the events
+/// simulated after the checkpoint, and its events and primaries in mesh_info count
+/// those events only.
+
+class ScoringMesh{
+
+public:
+
+    ScoringMesh();
+    ~ScoringMesh();
+
+    void AddVolume( G4String pattern );
+        // Logical volume name, a trailing '*' matches any suffix.
+    void ClearVolumes();
+
+    void SetVoxelSize( G4ThreeVector size ){ voxel_size = size; }
+    void SetFrame( G4String f ){ frame = f; }
+        // "local" for the frame of the volume, "world" for the global one.
+
+    G4bool IsEnabled() const { return !patterns.empty(); }
+
+    void BeginOfRun( G4bool active );
+        // Clear the voxels. Inactive runs, e.g. the ones of /response/run, are not scored.
+    void SetSink( OutputSink* s ){ sink = s; }
+    void EndOfRun( G4int nevents, G4int nprimaries );
+        // Print the totals per volume and write the voxels. nevents are the events
+        // scored, which give the statistical errors.
+
+    void ProcessStep( const G4Step* );
+    void EndOfEvent();
+
+private:
+
+    ScoringMeshMessenger* messenger;
+
+    std::vector<G4String> patterns;
+    G4ThreeVector voxel_size;
+    G4String frame;
+
+    G4bool active;
+
+    OutputSink* sink;
+
+    // Index of the mesh of each logical volume, -1 for volumes not scored.
+    std::unordered_map<const G4LogicalVolume*, G4int> volume_index;
+    std::vector<G4String> volumes;
+        // names in the order of their index
+    G4int GetVolume( const G4LogicalVolume* );
+
+    struct Voxel{
+        G4double edep;
+        G4double edep2;
+            // sum over events of the squared energy of the event
+        G4double tracks;
+        G4double xrays;
+        Voxel() : edep( 0 ), edep2( 0 ), tracks( 0 ), xrays( 0 ){}
+    };
+    std::unordered_map<uint64_t, Voxel> voxels;
+
+    std::unordered_map<uint64_t, G4double> event_edep;
+        // energy of the current event per voxel
+
+    G4int last_track;
+    uint64_t last_key;
+        // voxel of the previous step of the track
+
+    G4double outside;
+        // points beyond the index range of the keys, not scored
+
+    G4bool GetKey( G4int volume, const G4ThreeVector& position, uint64_t& key ) const;
+    void GetIndices( uint64_t key, G4int& volume, G4int& ix, G4int& iy, G4int& iz ) const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,41 @@
+/// \file ScoringMeshMessenger.hh
+/// \brief Definition of the ScoringMeshMessenger class
+
+#ifndef ScoringMeshMessenger_h
+#define ScoringMeshMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class ScoringMesh;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWith3VectorAndUnit;
+
+class ScoringMeshMessenger: public G4UImessenger{
+
+public:
+
+    ScoringMeshMessenger( ScoringMesh* );
+    virtual ~ScoringMeshMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    ScoringMesh* mesh;
+
+    G4UIdirectory* directory;
+
+    G4UIcmdWithAString* volumeCmd;
+        // Logical volume to attach the mesh to.
+    G4UIcmdWithoutParameter* clearCmd;
+        // Detach the mesh from all the volumes.
+    G4UIcmdWith3VectorAndUnit* voxelCmd;
+        // Size of the voxels.
+    G4UIcmdWithAString* frameCmd;
+        // Frame of the grid: local or world.
+};
+
+#endif
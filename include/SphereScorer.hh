@@ -0,0 +1,75 @@
+/// \file SphereScorer.hh
+/// \brief Definition of the SphereScorer class
+
+#ifndef SphereScorer_h
+#define SphereScorer_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+#include <map>
+
+class G4Step;
+class G4TouchableHistory;
+class G4ParticleDefinition;
+class OutputSink;
+
+/// Angular scoring on the virtual sphere placed with /placement/scoringSphere.
+///
+/// Attached to a thin vacuum shell around the source, it scores every particle entering
+/// the shell from inside: the polar and azimuthal angles (θ from +z, φ from +x) of the
+/// crossing point seen from the center of the sphere, and the kinetic energy. For each
+/// particle type the θ-φ and θ-E distributions and the θ, φ and E projections are
+/// written as histograms at the end of the run. Counts are per bin, not per solid angle.
+
+class SphereScorer : public G4VSensitiveDetector{
+
+public:
+
+    SphereScorer( G4String name );
+    virtual ~SphereScorer();
+
+    void SetCenter( G4ThreeVector c ){ center = c; }
+
+    void SetPlaced(){ placed = true; }
+    G4bool IsPlaced() const { return placed; }
+        // Nothing is written unless the sphere is part of the geometry.
+
+    void SetBinning( G4int ntheta, G4int nphi, G4int nE, G4double Emin, G4double Emax );
+
+    virtual G4bool ProcessHits( G4Step*, G4TouchableHistory* );
+
+    void BeginOfRun();
+    void EndOfRun( OutputSink*, G4int nprimaries );
+        // Write the histograms and print the number of crossings per particle.
+
+private:
+
+    G4ThreeVector center;
+    G4bool placed;
+
+    G4int ntheta;
+    G4int nphi;
+    G4int nE;
+    G4double Emin;
+    G4double Emax;
+
+    struct Histograms{
+        G4String particle;
+        std::vector<G4double> theta_phi;
+        std::vector<G4double> theta_E;
+        G4double crossings;
+    };
+
+    std::vector<Histograms> histograms;
+    std::map<const G4ParticleDefinition*, size_t> particle_index;
+
+    static G4int Bin( G4double x, G4double min, G4double max, G4int n );
+        // 0 for underflow, n+1 for overflow.
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
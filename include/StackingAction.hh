@@ -0,0 +1,34 @@
+//
+/// \file /include/StackingAction.hh
+/// \brief Definition of the StackingAction class
+
+#ifndef StackingAction_h
+#define StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+
+class XrayTally;
+class DecaySource;
+
+/// Kills all secondaries when the X-ray tally runs in yield-only mode. The photons
+/// have already been tallied by then, in the step that created them.
+///
+/// While a decay table is tabulated, the particles emitted by the decays are handed
+/// to the DecaySource and killed.
+
+class StackingAction : public G4UserStackingAction {
+
+public:
+    StackingAction( XrayTally*, DecaySource* );
+    virtual ~StackingAction() {};
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack( const G4Track* );
+
+private:
+    XrayTally* fXrayTally;
+    DecaySource* fDecaySource;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
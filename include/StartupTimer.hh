@@ -0,0 +1,51 @@
+/// \file StartupTimer.hh
+/// \brief Definition of the StartupTimer class
+
+#ifndef StartupTimer_h
+#define StartupTimer_h 1
+
+#include "globals.hh"
+#include "G4VStateDependent.hh"
+
+#include <vector>
+#include <chrono>
+
+/// Wall time of the phases of the startup, enabled with --timing.
+///
+/// The program marks the end of its own phases, DetectorConstruction the materials
+/// and the volumes. The phases run by the macro are told from the changes of the
+/// application state: the commands before /run/initialize, the physics list, the
+/// commands before /run/beamOn, the physics tables and voxels, and the start of the
+/// run up to its first event. The breakdown is printed then, or when the timer is
+/// deleted if no event is ever simulated.
+
+class StartupTimer : public G4VStateDependent{
+
+public:
+
+    StartupTimer();
+    virtual ~StartupTimer();
+
+    void Mark( G4String phase );
+        // End of a phase, which began at the previous mark.
+
+    void Print();
+
+    virtual G4bool Notify( G4ApplicationState requestedState );
+
+private:
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last;
+
+    std::vector< std::pair<G4String, G4double> > phases;
+
+    G4ApplicationState state;
+    G4bool initialized;
+        // /run/initialize done.
+    G4bool printed;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,134 @@
+/// \file StepFilter.hh
+/// \brief Definition of the StepFilter class
+
+#ifndef StepFilter_h
+#define StepFilter_h 1
+
+#include "globals.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+
+#include <vector>
+#include <unordered_map>
+
+class G4VPhysicalVolume;
+class G4ParticleDefinition;
+class StepFilterMessenger;
+
+/// Selection of the steps written to the output, set with the /record/ commands.
+///
+/// Volumes, regions, particles and processes each have an include and an exclude list
+/// of names, a trailing '*' matching any suffix. An empty include list accepts every
+/// name. The volume is the post-step volume, as stored with the step, and its region
+/// is checked with it. Steps can further be required to deposit a minimum energy and
+/// to start with a kinetic energy in a window.
+///
+/// Compile() resolves the name lists into per-object flags at the start of the run, so
+/// that Accept() costs a few comparisons and hash lookups and rejected steps are
+/// dropped before a StepInfo is built.
+
+class StepFilter{
+
+public:
+
+    StepFilter();
+    ~StepFilter();
+
+    enum Key { kVolume, kRegion, kParticle, kProcess, kNKeys };
+
+    void Include( Key key, G4String pattern );
+    void Exclude( Key key, G4String pattern );
+
+    void SetMinEdep( G4double e ){ min_edep = e; active = true; }
+    void SetEkinWindow( G4double min, G4double max ){ ekin_min = min; ekin_max = max; active = true; }
+
+    void Clear();
+        // Record every step.
+
+    void Compile();
+        // Resolve the name lists for the volumes, particles and processes known so far.
+        // Objects created later are resolved when first seen.
+
+    inline G4bool Accept( const G4Step* step );
+        // Whether the step is recorded. Steps leaving the world are never recorded.
+
+    G4bool AcceptParticle( const G4ParticleDefinition* );
+
+    G4bool AcceptTrack( const G4Track* );
+        // Whether the initial step of the track is recorded: its volume, region,
+        // particle and kinetic energy, with no deposit and the initStep process.
+
+    void ResetCounters(){ nseen = 0; nrecorded = 0; }
+
+    void Print() const;
+
+private:
+
+    StepFilterMessenger* messenger;
+
+    G4bool active;
+        // false if nothing is filtered, Accept() then only checks the world boundary
+
+    struct NameList{
+        std::vector<G4String> include;
+        std::vector<G4String> exclude;
+        G4bool Passes( const G4String& name ) const;
+    };
+
+    NameList lists[kNKeys];
+
+    G4double min_edep;
+    G4double ekin_min;
+    G4double ekin_max;
+
+    std::unordered_map<const G4VPhysicalVolume*, G4bool> volume_ok;
+    std::unordered_map<const G4ParticleDefinition*, G4bool> particle_ok;
+    std::unordered_map<const G4VProcess*, G4bool> process_ok;
+
+    G4bool ResolveVolume( const G4VPhysicalVolume* );
+    G4bool ResolveProcess( const G4VProcess* );
+
+    long nseen;
+    long nrecorded;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4bool StepFilter::Accept( const G4Step* step ){
+
+    nseen++;
+
+    const G4StepPoint* post = step->GetPostStepPoint();
+    const G4VPhysicalVolume* pv = post->GetPhysicalVolume();
+    if( pv==0 )
+        return false;
+
+    if( active ){
+
+        if( step->GetTotalEnergyDeposit() < min_edep )
+            return false;
+
+        G4double ekin = step->GetPreStepPoint()->GetKineticEnergy();
+        if( ekin < ekin_min || ekin > ekin_max )
+            return false;
+
+        std::unordered_map<const G4VPhysicalVolume*, G4bool>::const_iterator v = volume_ok.find( pv );
+        if( !( v!=volume_ok.end() ? v->second : ResolveVolume( pv ) ) )
+            return false;
+
+        if( !AcceptParticle( step->GetTrack()->GetParticleDefinition() ) )
+            return false;
+
+        const G4VProcess* proc = post->GetProcessDefinedStep();
+        std::unordered_map<const G4VProcess*, G4bool>::const_iterator p = process_ok.find( proc );
+        if( !( p!=process_ok.end() ? p->second : ResolveProcess( proc ) ) )
+            return false;
+    }
+
+    nrecorded++;
+    return true;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/// \file StepFilterMessenger.hh
+/// \brief Definition of the StepFilterMessenger class
+
+#ifndef StepFilterMessenger_h
+#define StepFilterMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+#include "StepFilter.hh"
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class StepFilterMessenger: public G4UImessenger{
+
+public:
+
+    StepFilterMessenger( StepFilter* );
+    virtual ~StepFilterMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    StepFilter* filter;
+
+    G4UIdirectory* directory;
+    G4UIdirectory* subdirectory[StepFilter::kNKeys];
+
+    G4UIcmdWithAString* includeCmd[StepFilter::kNKeys];
+    G4UIcmdWithAString* excludeCmd[StepFilter::kNKeys];
+        // /record/<volume|region|particle|process>/<include|exclude> name
+
+    G4UIcmdWithADoubleAndUnit* edepCmd;
+        // Minimum energy deposited in the step.
+    G4UIcommand* ekinCmd;
+        // Window on the kinetic energy at the start of the step.
+
+    G4UIcmdWithoutParameter* clearCmd;
+    G4UIcmdWithoutParameter* printCmd;
+};
+
+#endif
@@ -11,15 +11,76 @@
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
 
+class G4Track;
+
 using namespace std;
 
+/// Fields of a step record. The event, track, step and parent IDs are always recorded.
+namespace StepFields{
+    enum {
+        kParticle = 1<<0,
+        kVolume = 1<<1,
+        kCopyNumber = 1<<2,
+        kProcess = 1<<3,
+        kPosition = 1<<4,
+        kDirection = 1<<5,
+        kTime = 1<<6,
+        kEki = 1<<7,
+        kEkf = 1<<8,
+        kEdep = 1<<9,
+        kAll = (1<<10)-1
+    };
+}
+
+/// Compile-time field list of a step record. StepInfo::Fill is instantiated once per
+/// record, and the fields outside the list are never computed.
+template< unsigned F >
+struct StepRecord{
+    enum { fields = F };
+};
+
+typedef StepRecord< StepFields::kAll > FullRecord;
+    // everything, the default
+typedef StepRecord< StepFields::kVolume | StepFields::kCopyNumber | StepFields::kPosition | StepFields::kTime
+                    | StepFields::kEdep > CalorimetricRecord;
+    // where and when energy is deposited
+typedef StepRecord< StepFields::kParticle | StepFields::kVolume | StepFields::kCopyNumber | StepFields::kProcess
+                    | StepFields::kPosition | StepFields::kDirection | StepFields::kEki | StepFields::kEdep > XrayRecord;
+    // where particles are created and go, with their energy, as for the X-ray tally
+    // The volume, copy number and deposited energy of both also fill the event index
+    // (edep_center, edep_farside, nfarside).
+
 class StepInfo
 {
   public:
     StepInfo();
     StepInfo( const G4Step* );
+        // All the fields, same as Fill<FullRecord>.
     virtual ~StepInfo();
 
+    template< class Record > void Fill( const G4Step* );
+        // Record the post-step point of the step. Fields outside the record keep their defaults.
+    template< class Record > void FillInitial( const G4Track* );
+        // Record the starting point of a track, stored before its first step.
+
+    typedef void (StepInfo::*StepFiller)( const G4Step* );
+    typedef void (StepInfo::*TrackFiller)( const G4Track* );
+
+    struct RecordType{
+        const char* name;
+        unsigned fields;
+        StepFiller fill;
+        TrackFiller fill_initial;
+    };
+
+    static const RecordType* GetRecordType( G4String name );
+        // Prebuilt records "full", "calorimetric" and "xray", 0 for other names.
+    static G4String GetRecordNames();
+        // Names of the prebuilt records, separated by spaces.
+
+    size_t GetMemorySize() const;
+        // Bytes taken by the step, including the heap buffers of the names.
+
     G4int GetEventID();
     void SetEventID( G4int );
 
@@ -32,6 +93,10 @@ class StepInfo
     G4int GetParentID();
     void SetParentID( G4int );
 
+    G4int GetPrimaryIndex() const;
+    void SetPrimaryIndex( G4int );
+        // Primary of the event the track descends from, see /generator/primaries.
+
     G4String GetParticleName();
     void SetParticleName( G4String );
 
@@ -68,6 +133,7 @@ class StepInfo
     G4int trackID;
     G4int stepID;
     G4int parentID;
+    G4int primary_index;
 
     G4String particle_name;
 
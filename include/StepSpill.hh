@@ -0,0 +1,59 @@
+/// \file StepSpill.hh
+/// \brief Definition of the StepSpill class
+
+#ifndef StepSpill_h
+#define StepSpill_h 1
+
+#include "globals.hh"
+#include "StepInfo.hh"
+
+#include <vector>
+#include <cstdio>
+
+/// Temporary file holding the steps of an event that do not fit in the per-event
+/// memory budget. Steps are appended in order and read back in chunks at the end of
+/// the event. The file is created in $TMPDIR (or /tmp) and unlinked right away, so
+/// nothing is left behind if the job dies.
+
+class StepSpill{
+
+public:
+
+    StepSpill();
+    ~StepSpill();
+
+    G4bool Write( std::vector<StepInfo>& steps );
+        // Append the steps. False if the file cannot be created or written.
+
+    void Rewind();
+        // Prepare to read back from the first step.
+
+    size_t Read( std::vector<StepInfo>& steps, size_t max );
+        // Replace the content of steps with the next max steps at most. Returns their number.
+
+    G4bool AtEnd() const { return nread>=nwritten; }
+
+    void Clear();
+        // Forget everything written, keeping the file for the next event.
+
+    size_t GetSize() const { return nwritten; }
+        // Number of steps in the file.
+
+    G4double GetBytes() const { return bytes; }
+        // Size of the file.
+
+private:
+
+    FILE* file;
+
+    size_t nwritten;
+    size_t nread;
+    G4double bytes;
+
+    void WriteString( const G4String& );
+    G4String ReadString();
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
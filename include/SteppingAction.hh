@@ -9,12 +9,20 @@
 
 class DetectorConstruction;
 class EventAction;
+class Trigger;
+class StepFilter;
+class XrayTally;
+class PointDetector;
+class ResponseMatrix;
+class ConvergenceMonitor;
+class ScoringMesh;
 
 /// Stepping action class.
 ///
-/// In UserSteppingAction() there are collected the energy deposit and track
-/// lengths of charged particles in Absober and Gap layers and
-/// updated in EventAction.
+/// Every step is passed to the trigger, the X-ray tally, the point detectors, the
+/// convergence tally and the scoring mesh, and the steps accepted
+/// by the /record/ filters are stored in the step collection of the EventAction. During
+/// /response/run the steps only feed the response matrices.
 
 class SteppingAction : public G4UserSteppingAction{
 
@@ -27,6 +35,13 @@ public:
 private:
     const DetectorConstruction* fDetConstruction;
     EventAction* fEventAction;
+    Trigger* fTrigger;
+    StepFilter* fStepFilter;
+    XrayTally* fXrayTally;
+    PointDetector* fPointDetector;
+    ResponseMatrix* fResponseMatrix;
+    ConvergenceMonitor* fConvergence;
+    ScoringMesh* fMesh;
 
 };
 
@@ -0,0 +1,136 @@
+/// \file Trigger.hh
+/// \brief Definition of the Trigger class
+
+#ifndef Trigger_h
+#define Trigger_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <utility>
+
+class G4Step;
+class G4VPhysicalVolume;
+class TriggerMessenger;
+
+/// Event selection on the energy deposited in the detectors.
+///
+/// A detector is a placement of a physical volume (volume and copy number). It fires
+/// when the energy deposited in it during the event reaches the threshold of the
+/// condition it is matched by, or on any step in it if the threshold is 0. Conditions
+/// select detectors by volume name, with a trailing '*' matching any suffix:
+///
+///   require  at least one matching detector must fire,
+///   majority at least M distinct matching detectors must fire (M-of-N),
+///   veto     the event is rejected if any matching detector fires.
+///
+/// With a coincidence window, the detectors satisfying the require and majority
+/// conditions must all have fired within the window, the time of a detector being the
+/// global time of its first step. Steps are added as they happen, so that a veto
+/// rejects the event, and optionally aborts it, as soon as it fires.
+///
+/// When an event holds several independent primaries (/generator/primaries), every
+/// primary is triggered on its own, with the steps of its tracks only, and counts as
+/// one event in the efficiency counters. A veto then rejects its primary only and
+/// never aborts the event.
+
+class Trigger{
+
+public:
+
+    Trigger();
+    ~Trigger();
+
+    enum Type { kRequire, kMajority, kVeto };
+
+    enum Decision { kUndecided, kAccepted, kRejected };
+
+    void AddCondition( Type type, G4String pattern, G4int multiplicity, G4double threshold );
+    void Clear();
+        // No conditions: every event is accepted.
+
+    void SetWindow( G4double w ){ window = w; }
+        // Coincidence window, 0 for none.
+
+    void SetAbortOnVeto( G4bool b ){ abort_on_veto = b; }
+
+    void BeginOfEvent( G4int nprimaries = 1 );
+
+    Decision AddStep( const G4Step* step, G4int primary = 0 );
+        // Account for one step of a track descending from the given primary. Returns
+        // kRejected once a veto has fired, kAccepted once the primary can no longer fail,
+        // kUndecided otherwise.
+
+    G4bool EndOfEvent();
+        // Final decision, updates the efficiency counters. True if any primary is accepted.
+    G4bool IsAccepted( G4int primary ) const { return accepted[primary]; }
+
+    void ResetCounters();
+
+    void Print() const;
+
+    std::vector<std::string> GetSummary() const;
+        // Conditions and efficiency counters, one line each.
+
+private:
+
+    TriggerMessenger* messenger;
+
+    struct Condition{
+        Type type;
+        G4String pattern;
+        G4int multiplicity;
+        G4double threshold;
+        long passed;
+            // events in which the condition was met, ignoring the window
+    };
+
+    std::vector<Condition> conditions;
+
+    G4double window;
+    G4bool abort_on_veto;
+
+    // Conditions matching each volume, resolved once per volume from its name.
+    std::map< const G4VPhysicalVolume*, std::vector<int> > volume_conditions;
+    const std::vector<int>& GetConditions( const G4VPhysicalVolume* );
+
+    // Detectors hit in the current event.
+    struct Detector{
+        G4int primary;
+        std::vector<int> conditions;
+        G4double energy;
+        G4double time;
+        std::vector<G4bool> fired;
+            // per entry of conditions
+    };
+
+    typedef std::pair< std::pair<const G4VPhysicalVolume*, G4int>, G4int > DetectorKey;
+        // volume, copy number and primary
+    std::map< DetectorKey, size_t > detector_index;
+    std::vector<Detector> detectors;
+
+    std::vector<Decision> decisions;
+    std::vector<G4bool> accepted;
+        // per primary of the event
+
+    G4bool Evaluate( G4double w, G4bool count, G4int primary );
+        // Whether the require and majority conditions are met by the detectors of the primary
+        // within a window w (0 for none). With count, the conditions met are added to their
+        // counters.
+
+    G4bool IsFinal() const;
+        // Whether an event meeting the conditions stays accepted whatever follows.
+
+    // Efficiency counters
+    long nevents;
+    long naccepted;
+    long nvetoed;
+    long nwindow;
+        // events meeting all conditions but not within the window
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,48 @@
+/// \file TriggerMessenger.hh
+/// \brief Definition of the TriggerMessenger class
+
+#ifndef TriggerMessenger_h
+#define TriggerMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class Trigger;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+
+class TriggerMessenger: public G4UImessenger{
+
+public:
+
+    TriggerMessenger( Trigger* );
+    virtual ~TriggerMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    Trigger* trigger;
+
+    G4UIdirectory* directory;
+
+    G4UIcommand* requireCmd;
+        // Detector that must fire: volume name and threshold.
+    G4UIcommand* majorityCmd;
+        // At least M of the matching detectors must fire.
+    G4UIcommand* vetoCmd;
+        // Detector rejecting the event when it fires.
+
+    G4UIcmdWithADoubleAndUnit* windowCmd;
+        // Coincidence window on the global time.
+    G4UIcmdWithABool* abortCmd;
+        // Abort the event as soon as a veto fires.
+
+    G4UIcmdWithoutParameter* clearCmd;
+    G4UIcmdWithoutParameter* printCmd;
+};
+
+#endif
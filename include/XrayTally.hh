@@ -0,0 +1,102 @@
+/// \file XrayTally.hh
+/// \brief Definition of the XrayTally class
+
+#ifndef XrayTally_h
+#define XrayTally_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+class G4Step;
+class G4VPhysicalVolume;
+class OutputSink;
+class XrayTallyMessenger;
+
+/// Tally of the photons created in the target foils, set up with the /xray/ commands.
+///
+/// The secondaries of every step taken in a target volume (target_* by default) are
+/// checked, and each photon is tallied by target and creator process: ionisation by
+/// the alpha (PIXE), photoelectric fluorescence, electron ionisation and
+/// bremsstrahlung are told apart by the process name. The process codes are fixed,
+/// creators outside the known ones are tallied together as "other". For every photon
+/// a row with its energy, direction, position and the parent's energy is added to the
+/// xrays table, and an energy spectrum is accumulated per target and process and
+/// written at the end of the run.
+///
+/// In yield-only mode no steps are recorded and the StackingAction kills every
+/// secondary once tallied, so only the primaries are tracked. The tally then counts
+/// the photons created by the primaries only.
+
+class XrayTally{
+
+public:
+
+    XrayTally();
+    ~XrayTally();
+
+    void SetEnabled( G4bool b ){ enabled = b; }
+    G4bool IsEnabled() const { return enabled; }
+
+    void SetYieldOnly( G4bool b ){ yield_only = b; }
+    G4bool IsYieldOnly() const { return enabled && yield_only; }
+
+    void SetVolume( G4String pattern ){ volume_pattern = pattern; volume_index.clear(); }
+        // Volume name of the targets, a trailing '*' matches any suffix.
+
+    void SetTable( G4bool b ){ write_table = b; }
+        // Write one row per photon in addition to the spectra.
+
+    void SetHistogram( G4int n, G4double min, G4double max );
+        // Binning of the energy spectra.
+
+    void BeginOfRun();
+    void SetSink( OutputSink* s ){ sink = s; }
+        // Output of the current run, 0 if nothing is written.
+    void EndOfRun( G4int nprimaries );
+        // Write the spectra and print the yields per primary.
+
+    void ProcessStep( const G4Step*, G4int eventID );
+        // Tally the photons created in the step, if it was taken in a target. eventID is
+        // written in the rows: the ID of the primary with several primaries per event.
+
+private:
+
+    XrayTallyMessenger* messenger;
+
+    G4bool enabled;
+    G4bool yield_only;
+    G4bool write_table;
+    G4String volume_pattern;
+
+    G4int nbins;
+    G4double emin;
+    G4double emax;
+
+    OutputSink* sink;
+
+    // Index of the target of each volume, -1 for other volumes.
+    std::unordered_map<const G4VPhysicalVolume*, G4int> volume_index;
+    G4int GetTarget( const G4VPhysicalVolume* );
+
+    std::vector<G4String> targets;
+    std::vector<G4String> processes;
+        // names in the order of their codes in the table, fixed so that jobs can be merged
+    std::set<G4String> other_processes;
+        // creators of the run tallied under "other"
+    G4int GetProcess( const G4String& );
+
+    // Spectrum per target and process, with underflow and overflow bins.
+    std::map< std::pair<G4int, G4int>, std::vector<G4double> > spectra;
+
+    std::vector<std::string> columns;
+    std::vector<G4double> row;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
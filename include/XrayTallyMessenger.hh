@@ -0,0 +1,42 @@
+/// \file XrayTallyMessenger.hh
+/// \brief Definition of the XrayTallyMessenger class
+
+#ifndef XrayTallyMessenger_h
+#define XrayTallyMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class XrayTally;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+
+class XrayTallyMessenger: public G4UImessenger{
+
+public:
+
+    XrayTallyMessenger( XrayTally* );
+    virtual ~XrayTallyMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+
+    XrayTally* tally;
+
+    G4UIdirectory* directory;
+
+    G4UIcmdWithABool* enableCmd;
+    G4UIcmdWithAString* volumeCmd;
+        // Target volume name, a trailing * matches any suffix.
+    G4UIcmdWithABool* yieldCmd;
+        // Track the primaries only and record nothing but the tally.
+    G4UIcmdWithABool* tableCmd;
+        // One row per photon in the xrays table.
+    G4UIcommand* histogramCmd;
+        // Binning of the spectra.
+};
+
+#endif
@@ -0,0 +1,82 @@
+/// \file AliasTable.cc
+/// \brief Implementation of the AliasTable class
+
+#include "AliasTable.hh"
+
+#include "Randomize.hh"
+
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AliasTable::Build( const std::vector<G4double>& weights ){
+
+    probability.clear();
+    alias.clear();
+
+    G4double sum = 0;
+    for( size_t i=0; i<weights.size(); i++ )
+        sum += std::max( weights[i], 0. );
+    if( sum<=0 )
+        return;
+
+    // Vose's method: pair every entry below the mean with one above it.
+    size_t n = weights.size();
+    probability.resize( n );
+    alias.resize( n );
+
+    std::vector<G4int> small, large;
+    for( size_t i=0; i<n; i++ ){
+        probability[i] = std::max( weights[i], 0. )*n/sum;
+        alias[i] = i;
+        if( probability[i]<1 )
+            small.push_back( i );
+        else
+            large.push_back( i );
+    }
+
+    while( !small.empty() && !large.empty() ){
+        G4int s = small.back();
+        G4int l = large.back();
+        small.pop_back();
+
+        alias[s] = l;
+        probability[l] -= 1-probability[s];
+        if( probability[l]<1 ){
+            large.pop_back();
+            small.push_back( l );
+        }
+    }
+
+    // Left-overs are 1 up to rounding.
+    for( size_t i=0; i<small.size(); i++ )
+        probability[ small[i] ] = 1;
+    for( size_t i=0; i<large.size(); i++ )
+        probability[ large[i] ] = 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int AliasTable::Sample() const {
+    G4double fraction;
+    return Sample( fraction );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int AliasTable::Sample( G4double& fraction ) const {
+
+    G4double x = G4UniformRand()*probability.size();
+    G4int i = std::min( G4int( x ), G4int( probability.size() )-1 );
+    G4double u = x-i;
+
+    // The part of u below or above the cut is itself uniform.
+    if( u<probability[i] ){
+        fraction = u/probability[i];
+        return i;
+    }
+    fraction = ( u-probability[i] )/( 1-probability[i] );
+    return alias[i];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
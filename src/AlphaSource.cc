@@ -0,0 +1,204 @@
+/// \file AlphaSource.cc
+/// \brief Implementation of the AlphaSource class
+
+#include "AlphaSource.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Alpha.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+    // Main alpha lines, energy and intensity per decay.
+    struct AlphaLine{
+        const char* nuclide;
+        G4double energy;
+        G4double intensity;
+    };
+
+    const AlphaLine alpha_lines[] = {
+        { "Am241", 5.4856*MeV, 0.848 },
+        { "Am241", 5.4429*MeV, 0.131 },
+        { "Am241", 5.5445*MeV, 0.0037 },
+        { "Am241", 5.5116*MeV, 0.00225 },
+        { "Am241", 5.3880*MeV, 0.0166 },
+        { "Po210", 5.3044*MeV, 1.0 },
+        { "Cm244", 5.8048*MeV, 0.769 },
+        { "Cm244", 5.7627*MeV, 0.231 }
+    };
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AlphaSource::AlphaSource() :
+    loss( 0 ),
+    sigma( 0 ),
+    tail( 0 ),
+    straggling_min( 0 ),
+    straggling_width( 0 ),
+    tables_ready( false ),
+    center( 0, 0, 0 ),
+    radius( 0 ),
+    max_theta( 90*deg ),
+    cosine_law( false )
+{
+    SetAxis( G4ThreeVector( 0, 0, 1 ) );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AlphaSource::~AlphaSource(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AlphaSource::AddNuclide( G4String name, G4double activity ){
+
+    G4bool found = false;
+    for( size_t i=0; i<sizeof( alpha_lines )/sizeof( alpha_lines[0] ); i++ ){
+        if( name==alpha_lines[i].nuclide ){
+            AddLine( alpha_lines[i].energy, activity*alpha_lines[i].intensity );
+            found = true;
+        }
+    }
+    return found;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::AddLine( G4double energy, G4double intensity ){
+    energies.push_back( energy );
+    intensities.push_back( intensity );
+    tables_ready = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::Clear(){
+    energies.clear();
+    intensities.clear();
+    tables_ready = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::SetEncapsulation( G4double l, G4double s, G4double t ){
+    loss = l;
+    sigma = s;
+    tail = t;
+    tables_ready = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::SetAxis( G4ThreeVector a ){
+
+    axis = a.unit();
+
+    GetTransverseAxes( axis, axis_u, axis_v );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::BuildTables(){
+
+    line_table.Build( intensities );
+
+    // Straggling profile of the energy change x (negative is a loss): Gaussian of width
+    // sigma convolved with an exponential tail of slope tail towards low energies.
+    // A tail much shorter than sigma is neglected, which also keeps the exponential finite.
+    straggling_table.Build( std::vector<G4double>() );
+    if( sigma<=0 && tail<=0 ){
+        tables_ready = true;
+        return;
+    }
+
+    G4bool gaussian = tail<0.05*sigma;
+    G4double low = gaussian ? -6*sigma : -( 6*sigma + 20*tail );
+    G4double high = 6*sigma;
+    straggling_min = low;
+    straggling_width = ( high-low )/nstraggling;
+
+    std::vector<G4double> profile( nstraggling );
+    for( G4int i=0; i<nstraggling; i++ ){
+        G4double x = low + ( i+0.5 )*straggling_width;
+        if( gaussian )
+            profile[i] = std::exp( -x*x/( 2*sigma*sigma ) );
+        else if( sigma<=0 )
+            profile[i] = x<=0 ? std::exp( x/tail ) : 0;
+        else
+            profile[i] = std::exp( x/tail + sigma*sigma/( 2*tail*tail ) )*std::erfc( ( x/sigma + sigma/tail )/std::sqrt( 2. ) );
+    }
+    straggling_table.Build( profile );
+
+    tables_ready = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::GeneratePrimaryVertex( G4Event* event ){
+
+    if( !tables_ready )
+        BuildTables();
+
+    G4double energy = energies[ line_table.Sample() ] - loss;
+    if( !straggling_table.IsEmpty() ){
+        G4double fraction;
+        G4int i = straggling_table.Sample( fraction );
+        energy += straggling_min + ( i+fraction )*straggling_width;
+    }
+    if( energy<0 )
+        energy = 0;
+
+    G4double r = radius*std::sqrt( G4UniformRand() );
+    G4double phi = twopi*G4UniformRand();
+    G4ThreeVector position = center + r*std::cos( phi )*axis_u + r*std::sin( phi )*axis_v;
+
+    // Uniform in cos(theta) for isotropic emission, in cos^2(theta) for the cosine law.
+    G4double cos_max = std::cos( max_theta );
+    G4double cos_theta = cosine_law ?
+        std::sqrt( 1 - G4UniformRand()*( 1-cos_max*cos_max ) ) :
+        1 - G4UniformRand()*( 1-cos_max );
+    G4double sin_theta = std::sqrt( std::max( 0., 1-cos_theta*cos_theta ) );
+    phi = twopi*G4UniformRand();
+    G4ThreeVector direction = sin_theta*std::cos( phi )*axis_u + sin_theta*std::sin( phi )*axis_v + cos_theta*axis;
+
+    G4PrimaryParticle* particle = new G4PrimaryParticle( G4Alpha::Definition() );
+    particle->SetKineticEnergy( energy );
+    particle->SetMomentumDirection( direction );
+
+    G4PrimaryVertex* vertex = new G4PrimaryVertex( position, 0 );
+    vertex->SetPrimary( particle );
+    event->AddPrimaryVertex( vertex );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AlphaSource::Print() const {
+
+    G4double total = 0;
+    for( size_t i=0; i<intensities.size(); i++ )
+        total += intensities[i];
+
+    G4cout << "Alpha source: " << energies.size() << " lines" << G4endl;
+    for( size_t i=0; i<energies.size(); i++ )
+        G4cout << "    " << G4BestUnit( energies[i], "Energy" ) << " " << intensities[i]/total << G4endl;
+    G4cout << "    encapsulation loss " << G4BestUnit( loss, "Energy" ) << ", sigma " << G4BestUnit( sigma, "Energy" )
+           << ", tail " << G4BestUnit( tail, "Energy" ) << G4endl;
+    G4cout << "    disk at " << G4BestUnit( center, "Length" ) << ", radius " << G4BestUnit( radius, "Length" )
+           << ", axis " << axis << ", " << ( cosine_law ? "cosine law" : "isotropic" ) << " up to "
+           << max_theta/deg << " deg" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,254 @@
+/// \file Application.cc
+/// \brief Implementation of the Application class
+
+#include "Application.hh"
+
+#include "G4RunManager.hh"
+
+#include "DetectorConstruction.hh"
+#include "GeneratorAction.hh"
+
+#include "RunAction.hh"
+#include "EventAction.hh"
+#include "TrackingAction.hh"
+#include "SteppingAction.hh"
+#include "StackingAction.hh"
+#include "GeometryProfiler.hh"
+#include "StartupTimer.hh"
+
+#include "G4UImanager.hh"
+#include "Shielding.hh"
+#include "G4EmParameters.hh"
+#include "G4HadronicProcessStore.hh"
+
+#include "Randomize.hh"
+
+#include <cstdlib>
+#include <ctime>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Application::Application( G4String name, G4bool b ) :
+    program( name ),
+    interactive( b ),
+    status( 0 ),
+    batch( false ),
+    quiet( false ),
+    macro( "" ),
+    filename( "" ),
+    replay_event( -1 ),
+    replay_run( -1 ),
+    resume( false ),
+    record( "full" ),
+    profile_geometry( false ),
+    startup_timer( 0 ),
+    geometry_profiler( 0 ),
+    run_manager( 0 ),
+    run_action( 0 )
+{
+    seeds[0] = seeds[1] = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Application::~Application(){
+
+    // Job termination
+    // Free the store: user actions, physics_list and detector_description are
+    // owned and deleted by the run manager, so they should not be deleted
+    // in the main() program !
+
+    delete startup_timer;
+    delete geometry_profiler;
+    delete run_manager;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Application::PrintUsage() const {
+    G4cerr << "\nUsage: " << program << " [-m macro.mac ] [-f output.root] [-r seed0 seed1] " << G4endl;
+    G4cerr << "\t-m, used to spefify the macro file to execute.\n";
+    G4cerr << "\t-f, spefify output ROOT file.\n";
+    G4cerr << "\t-r, spefify two random seeds to be used.\n";
+    G4cerr << "\t--replay-event N, simulate only event N (with the seeds given by -r) with step verbosity.\n";
+    G4cerr << "\t--replay-run R, run number of the event to replay (default is the current run).\n";
+    G4cerr << "\t--resume, continue into the output file given by -f from its last checkpoint.\n";
+    G4cerr << "\t--record NAME, fields of the recorded steps: full (default), calorimetric or xray.\n";
+    G4cerr << "\t--profile-geometry, time the navigation in each volume and report the costly solids and voxels.\n";
+    G4cerr << "\t-q, --quiet, do not print the material table nor the physics tables.\n";
+    G4cerr << "\t--timing, print the time spent in each phase of the startup.\n";
+    if( interactive )
+        G4cerr << "If no macro is specified, the program enters UI session.\n" << G4endl;
+    else
+        G4cerr << "The macro is required.\n" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Application::ParseArguments( int argc, char** argv ){
+
+    // Random engine.
+    // The seed is first set by the current time. Later it will be updated by the commandline parameter if provided.
+    G4Random::setTheEngine(new CLHEP::RanecuEngine);
+    time_t systime = time(NULL);
+    seeds[0] = (long) systime;
+    seeds[1] = (long) (systime*G4UniformRand());
+
+    G4bool timing = false;
+
+    // Loop over the commandline arguments.
+    //
+    for ( G4int i=1; i<argc; i++ ) {
+        if ( G4String( argv[i] ) == "-m" && i!=argc-1 ){
+            macro = argv[++i];
+            if( macro.find(".mac")!=std::string::npos ){
+                batch = true;
+            }
+        }
+        else if ( G4String(argv[i]) == "-f" && i!=argc-1 ){
+            filename = G4String(argv[++i]);
+                // output filename
+        }
+        else if ( G4String(argv[i]) == "-r" && i<argc-2 ){
+            seeds[0] = atol(argv[++i]);
+            seeds[1] = atol(argv[++i]);
+                // random seeds
+        }
+        else if ( G4String(argv[i]) == "--replay-event" && i!=argc-1 ){
+            replay_event = atoi(argv[++i]);
+        }
+        else if ( G4String(argv[i]) == "--replay-run" && i!=argc-1 ){
+            replay_run = atoi(argv[++i]);
+        }
+        else if ( G4String(argv[i]) == "--resume" ){
+            resume = true;
+        }
+        else if ( G4String(argv[i]) == "--record" && i!=argc-1 ){
+            record = argv[++i];
+        }
+        else if ( G4String(argv[i]) == "--profile-geometry" ){
+            profile_geometry = true;
+        }
+        else if ( G4String(argv[i]) == "-q" || G4String(argv[i]) == "--quiet" ){
+            quiet = true;
+        }
+        else if ( G4String(argv[i]) == "--timing" ){
+            timing = true;
+        }
+        else if( G4String(argv[i]) == "-h" ){
+            PrintUsage();
+            status = 0;
+            return false;
+        }
+    }
+
+    if( !interactive && !batch ){
+        G4cerr << program << " runs a macro only, give it with -m." << G4endl;
+        PrintUsage();
+        status = 1;
+        return false;
+    }
+
+    if( timing ){
+        startup_timer = new StartupTimer();
+        startup_timer->Mark( "command line" );
+    }
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Application::Construct(){
+
+    // Choose the Random engine
+    //
+    G4cout << "Seeds for random generator are " << seeds[0] << ", " << seeds[1] << G4endl;
+    G4Random::setTheSeeds(seeds);
+
+    // The navigator of the tracking is taken by the run manager when it is built,
+    // the profiling one must be in place before.
+    if( profile_geometry ){
+        geometry_profiler = new GeometryProfiler();
+        geometry_profiler->InstallNavigator();
+    }
+
+    // Construct the default run manager. At this step, don't consider multi-threading yet.
+    //
+    run_manager = new G4RunManager;
+    if( startup_timer!=0 )
+        startup_timer->Mark( "run manager" );
+
+    // Construct detector geometry
+    DetectorConstruction* detConstruction = new DetectorConstruction();
+    detConstruction->SetQuiet( quiet );
+    detConstruction->SetStartupTimer( startup_timer );
+    run_manager->SetUserInitialization( detConstruction );
+
+    // Physics list. Use a ready-to-use list.
+    G4VModularPhysicsList* physicsList = new Shielding( quiet ? 0 : 1 );
+    run_manager->SetUserInitialization( physicsList );
+    if( quiet ){
+        G4EmParameters::Instance()->SetVerbose( 0 );
+        G4HadronicProcessStore::Instance()->SetVerbose( 0 );
+    }
+    if( startup_timer!=0 )
+        startup_timer->Mark( "detector and physics list" );
+
+    // Primary generator
+    // Each event is reseeded from the master seeds, its run and event number, so any
+    // single event can be replayed and results do not depend on the order of events.
+    GeneratorAction* generator = new GeneratorAction();
+    generator->SetMasterSeeds( seeds, 2 );
+    if( replay_event>=0 ){
+        generator->SetReplayEvent( replay_event, replay_run );
+    }
+    run_manager->SetUserAction( generator );
+
+    // Run action
+    run_action = new RunAction;
+    run_action->SetOutputFileName( filename );
+    run_action->AddRandomSeeds( seeds, 2);
+    run_action->SetGeneratorAction( generator );
+    run_action->SetResume( resume );
+    run_manager->SetUserAction( run_action );
+    if( !run_action->SetRecord( record ) ){
+        status = 1;
+        return false;
+    }
+
+    // Event action
+    EventAction* eventAction = new EventAction( run_action );
+    run_manager->SetUserAction( eventAction );
+    run_action->SetTrigger( eventAction->GetTrigger() );
+    run_action->SetStepFilter( eventAction->GetStepFilter() );
+    run_action->SetXrayTally( eventAction->GetXrayTally() );
+    run_action->SetPointDetector( eventAction->GetPointDetector() );
+    run_action->SetResponseMatrix( eventAction->GetResponseMatrix() );
+    run_action->SetConvergenceMonitor( eventAction->GetConvergenceMonitor() );
+    run_action->SetScoringMesh( eventAction->GetScoringMesh() );
+    run_action->SetGeometryProfiler( geometry_profiler );
+    generator->SetResponseMatrix( eventAction->GetResponseMatrix() );
+    run_action->SetSphereScorer( detConstruction->GetSphereScorer() );
+
+    // Tracking, stepping and stacking
+    run_manager->SetUserAction( new TrackingAction( eventAction ) );
+    run_manager->SetUserAction( new SteppingAction( detConstruction, eventAction ) );
+    run_manager->SetUserAction( new StackingAction( eventAction->GetXrayTally(), generator->GetDecaySource() ) );
+
+    if( startup_timer!=0 )
+        startup_timer->Mark( "user actions" );
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Application::ExecuteMacro(){
+
+    run_action->AddMacro( macro );
+    G4String command = "/control/execute ";
+    G4UImanager::GetUIpointer()->ApplyCommand(command+macro);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,256 @@
+/// \file ConvergenceMonitor.cc
+/// \brief Implementation of the ConvergenceMonitor class
+
+#include "ConvergenceMonitor.hh"
+#include "ConvergenceMonitorMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "GeometryUtils.hh"
+#include "OutputSink.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Gamma.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ConvergenceMonitor::ConvergenceMonitor() :
+    messenger( 0 ),
+    active( false ),
+    type( "" ),
+    volume_pattern( "" ),
+    emin( 0 ),
+    emax( 0 ),
+    precision( 0 ),
+    time_limit( 0 ),
+    batch_size( 1000 ),
+    min_batches( 10 ),
+    sink( 0 ),
+    event_value( 0 ),
+    nevents( 0 ),
+    mean( 0 ),
+    m2( 0 ),
+    nbatches( 0 ),
+    batch_sum( 0 ),
+    batch_mean( 0 ),
+    batch_m2( 0 )
+{
+    messenger = new ConvergenceMonitorMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ConvergenceMonitor::~ConvergenceMonitor(){
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::SetTally( G4String t, G4String volume, G4double min, G4double max ){
+
+    if( t!="deposit" && t!="xray" ){
+        G4cerr << "Unknown convergence tally " << t << ", ignored." << G4endl;
+        return;
+    }
+
+    type = t;
+    volume_pattern = volume;
+    emin = min;
+    emax = max;
+    is_tallied.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ConvergenceMonitor::IsTallied( const G4VPhysicalVolume* pv ){
+
+    std::unordered_map<const G4VPhysicalVolume*, G4bool>::const_iterator it = is_tallied.find( pv );
+    if( it!=is_tallied.end() )
+        return it->second;
+
+    G4bool match = MatchesVolumePattern( volume_pattern, pv->GetName() );
+
+    is_tallied[pv] = match;
+    return match;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::BeginOfRun( G4bool a ){
+
+    active = a && IsEnabled();
+
+    event_value = 0;
+    deposits.clear();
+
+    nevents = 0;
+    mean = 0;
+    m2 = 0;
+
+    nbatches = 0;
+    batch_sum = 0;
+    batch_mean = 0;
+    batch_m2 = 0;
+
+    reason = "";
+    start = std::chrono::steady_clock::now();
+
+    if( active ){
+        G4cout << "The run stops";
+        if( precision>0 )
+            G4cout << " at a relative error of " << precision << " on the " << type << " tally in " << volume_pattern;
+        if( precision>0 && time_limit>0 )
+            G4cout << " or";
+        if( time_limit>0 )
+            G4cout << " after " << G4BestUnit( time_limit, "Time" );
+        G4cout << G4endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::ProcessStep( const G4Step* step ){
+
+    if( !active )
+        return;
+
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    const G4VPhysicalVolume* pv = pre->GetPhysicalVolume();
+    if( pv==0 || !IsTallied( pv ) )
+        return;
+
+    if( type=="deposit" ){
+        G4double edep = step->GetTotalEnergyDeposit();
+        if( edep>0 )
+            deposits[ std::make_pair( pv, DetectorConstruction::GetDetectorID( pre->GetTouchable() ) ) ] += edep;
+        return;
+    }
+
+    const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
+    if( secondaries==0 )
+        return;
+
+    const G4ParticleDefinition* gamma = G4Gamma::Definition();
+    for( size_t i=0; i<secondaries->size(); i++ ){
+        const G4Track* photon = (*secondaries)[i];
+        if( photon->GetDefinition()==gamma && photon->GetKineticEnergy()>=emin && photon->GetKineticEnergy()<emax )
+            event_value += 1;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ConvergenceMonitor::EndOfEvent(){
+
+    if( !active )
+        return false;
+
+    // Each detector with a deposit in the window is one count.
+    std::map< std::pair<const G4VPhysicalVolume*, G4int>, G4double >::const_iterator it;
+    for( it=deposits.begin(); it!=deposits.end(); ++it ){
+        if( it->second>=emin && it->second<emax )
+            event_value += 1;
+    }
+    deposits.clear();
+
+    G4double x = event_value;
+    event_value = 0;
+
+    nevents++;
+    G4double delta = x-mean;
+    mean += delta/nevents;
+    m2 += delta*( x-mean );
+
+    batch_sum += x;
+    if( nevents%batch_size==0 ){
+
+        G4double b = batch_sum/batch_size;
+        batch_sum = 0;
+
+        nbatches++;
+        delta = b-batch_mean;
+        batch_mean += delta/nbatches;
+        batch_m2 += delta*( b-batch_mean );
+
+        if( precision>0 && nbatches>=min_batches && mean>0 && GetRelativeError()<=precision ){
+            reason = "precision";
+            return true;
+        }
+    }
+
+    if( time_limit>0 && std::chrono::duration<double>( std::chrono::steady_clock::now()-start ).count()*s>=time_limit ){
+        reason = "time limit";
+        return true;
+    }
+
+    return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ConvergenceMonitor::GetEventError() const {
+    return nevents>1 && mean>0 ? std::sqrt( m2/( nevents-1 )/nevents )/mean : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ConvergenceMonitor::GetBatchError() const {
+    return nbatches>1 && batch_mean>0 ? std::sqrt( batch_m2/( nbatches-1 )/nbatches )/batch_mean : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ConvergenceMonitor::GetRelativeError() const {
+    // Batch means also catch correlations between events, the event estimate
+    // guards against the few batches of a short run.
+    return nbatches>0 ? std::max( GetEventError(), GetBatchError() ) : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::EndOfRun( G4double primaries_per_event ){
+
+    if( !active )
+        return;
+
+    active = false;
+
+    G4double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now()-start ).count();
+
+    G4cout << "Convergence of the " << type << " tally in " << volume_pattern << " from "
+           << G4BestUnit( emin, "Energy" ) << "to " << G4BestUnit( emax, "Energy" ) << ":" << G4endl;
+    G4cout << "    " << mean/primaries_per_event << " per primary, relative error " << GetEventError()
+           << " from " << nevents << " events, " << GetBatchError() << " from " << nbatches << " batches of " << batch_size << G4endl;
+    G4cout << "    " << ( reason!="" ? "stopped at the " + reason : G4String( "ran to the end" ) )
+           << " after " << elapsed << " s" << G4endl;
+
+    if( sink!=0 ){
+        std::vector<std::string> columns;
+        const char* names[] = { "nevents", "nbatches", "batch_size", "mean", "error_events", "error_batches",
+                                "precision", "time_limit", "elapsed", "stopped", "primaries_per_event" };
+        columns.assign( names, names+11 );
+
+        std::vector<G4double> row( columns.size() );
+        row[0] = nevents;
+        row[1] = nbatches;
+        row[2] = batch_size;
+        row[3] = mean/primaries_per_event;
+        row[4] = GetEventError();
+        row[5] = GetBatchError();
+        row[6] = precision;
+        row[7] = time_limit/s;
+        row[8] = elapsed;
+        row[9] = reason=="precision" ? 1 : reason=="time limit" ? 2 : 0;
+        row[10] = primaries_per_event;
+        sink->FillTable( "convergence", columns, row );
+    }
+
+    sink = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,112 @@
+// $Id: ConvergenceMonitorMessenger.cc $
+//
+/// \file ConvergenceMonitorMessenger.cc
+/// \brief Definition of the ConvergenceMonitorMessenger class
+
+#include "ConvergenceMonitorMessenger.hh"
+#include "ConvergenceMonitor.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+ConvergenceMonitorMessenger::ConvergenceMonitorMessenger( ConvergenceMonitor* m ) : G4UImessenger(), monitor( m ){
+
+    directory = new G4UIdirectory( "/convergence/" );
+    directory->SetGuidance( "Stop the run when a tally is precise enough or when the time is spent." );
+    directory->SetGuidance( "/run/beamOn then gives the maximum number of events." );
+
+    tallyCmd = new G4UIcommand( "/convergence/tally", this );
+    tallyCmd->SetGuidance( "Tally whose relative error is followed." );
+    tallyCmd->SetGuidance( "deposit: counts of a detector volume with a deposited energy in [min,max), e.g. a line in detector." );
+    tallyCmd->SetGuidance( "xray: photons created in the volume with an energy in [min,max), e.g. the yield of a target foil." );
+    tallyCmd->SetGuidance( "A trailing * in the volume name matches any suffix." );
+    tallyCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "type", 's', false );
+    param->SetParameterCandidates( "deposit xray" );
+    tallyCmd->SetParameter( param );
+    param = new G4UIparameter( "volume", 's', false );
+    tallyCmd->SetParameter( param );
+    param = new G4UIparameter( "min", 'd', false );
+    tallyCmd->SetParameter( param );
+    param = new G4UIparameter( "max", 'd', false );
+    tallyCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    tallyCmd->SetParameter( param );
+
+    precisionCmd = new G4UIcmdWithADouble( "/convergence/precision", this );
+    precisionCmd->SetGuidance( "Relative standard error of the mean of the tally at which the run stops, 0 to disable." );
+    precisionCmd->SetParameterName( "precision", false );
+    precisionCmd->SetRange( "precision>=0" );
+    precisionCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    timeCmd = new G4UIcmdWithADoubleAndUnit( "/convergence/timeLimit", this );
+    timeCmd->SetGuidance( "Wall time after which the run stops, 0 to disable." );
+    timeCmd->SetParameterName( "time", false );
+    timeCmd->SetRange( "time>=0" );
+    timeCmd->SetUnitCategory( "Time" );
+    timeCmd->SetDefaultUnit( "s" );
+    timeCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    batchCmd = new G4UIcmdWithAnInteger( "/convergence/batch", this );
+    batchCmd->SetGuidance( "Events per batch (default 1000). The precision is checked at the end of each batch," );
+    batchCmd->SetGuidance( "with the error estimated from the spread of the batch means." );
+    batchCmd->SetParameterName( "N", false );
+    batchCmd->SetRange( "N>0" );
+    batchCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    minBatchesCmd = new G4UIcmdWithAnInteger( "/convergence/minBatches", this );
+    minBatchesCmd->SetGuidance( "Batches to simulate before the run can stop on precision (default 10)." );
+    minBatchesCmd->SetParameterName( "N", false );
+    minBatchesCmd->SetRange( "N>=2" );
+    minBatchesCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+ConvergenceMonitorMessenger::~ConvergenceMonitorMessenger(){
+    delete tallyCmd;
+    delete precisionCmd;
+    delete timeCmd;
+    delete batchCmd;
+    delete minBatchesCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void ConvergenceMonitorMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==tallyCmd ){
+        std::istringstream is( newValue );
+        G4String type, volume, unit;
+        G4double min, max;
+        is >> type >> volume >> min >> max >> unit;
+        if( max<=min ){
+            G4cerr << "/convergence/tally: max must be larger than min." << G4endl;
+            return;
+        }
+        monitor->SetTally( type, volume, min*G4UIcommand::ValueOf( unit ), max*G4UIcommand::ValueOf( unit ) );
+    }
+    else if( command==precisionCmd ){
+        monitor->SetPrecision( precisionCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==timeCmd ){
+        monitor->SetTimeLimit( timeCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==batchCmd ){
+        monitor->SetBatchSize( batchCmd->GetNewIntValue( newValue ) );
+    }
+    else if( command==minBatchesCmd ){
+        monitor->SetMinBatches( minBatchesCmd->GetNewIntValue( newValue ) );
+    }
+    return;
+}
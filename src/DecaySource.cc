@@ -0,0 +1,360 @@
+/// \file DecaySource.cc
+/// \brief Implementation of the DecaySource class
+
+#include "DecaySource.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Event.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4IonTable.hh"
+#include "G4Ions.hh"
+#include "G4Alpha.hh"
+#include "G4NistManager.hh"
+#include "G4RunManager.hh"
+#include "G4Run.hh"
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
+#include "G4UImanager.hh"
+#include "G4EmParameters.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4RandomDirection.hh"
+#include "Randomize.hh"
+
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace{
+
+    // Version of Geant4 as written in the tables, without the surrounding blanks of
+    // GetVersionString() that the reading would not keep.
+    std::string GetGeant4Version(){
+        std::string version = G4RunManager::GetRunManager()->GetVersionString();
+        size_t first = version.find_first_not_of( " \t\r\n" );
+        if( first==std::string::npos )
+            return "";
+        return version.substr( first, version.find_last_not_of( " \t\r\n" )-first+1 );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecaySource::DecaySource() :
+    chain( false ),
+    ndecays( 100000 ),
+    cache_dir( "decay_cache" ),
+    tabulating( false ),
+    nucleus( 0 ),
+    center( 0, 0, 0 ),
+    radius( 0 )
+{
+    SetAxis( G4ThreeVector( 0, 0, 1 ) );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecaySource::~DecaySource(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecaySource::SetAxis( G4ThreeVector a ){
+
+    G4ThreeVector axis = a.unit();
+
+    GetTransverseAxes( axis, axis_u, axis_v );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecaySource::SetNuclide( G4String name ){
+
+    // Element symbol followed by the mass number, e.g. Cs137.
+    size_t digit = 0;
+    while( digit<name.size() && !isdigit( name[digit] ) )
+        digit++;
+    G4int Z = digit>0 && digit<name.size() ? G4NistManager::Instance()->GetZ( name.substr( 0, digit ) ) : 0;
+    G4int A = digit<name.size() ? atoi( name.c_str()+digit ) : 0;
+
+    nucleus = Z>0 && A>=Z ? G4IonTable::GetIonTable()->GetIon( Z, A, 0. ) : 0;
+    if( nucleus==0 ){
+        G4cerr << "/generator/decay/nuclide: unknown nuclide " << name << G4endl;
+        return;
+    }
+    nuclide = name;
+
+    if( ReadTable( CacheFile(), true ) ){
+        G4cout << "Decay table of " << nuclide << " read from " << CacheFile() << G4endl;
+        return;
+    }
+
+    Tabulate();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String DecaySource::GetDeexcitation() const {
+    G4EmParameters* em = G4EmParameters::Instance();
+    return G4String( em->Fluo() ? "fluo" : "nofluo" ) + ( em->Auger() ? "_auger" : "" );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String DecaySource::CacheFile() const {
+    return cache_dir + "/" + nuclide + ( chain ? "_chain" : "" ) + "_" + GetDeexcitation() + ".decay";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecaySource::Tabulate(){
+
+    offsets.clear();
+    pdg_codes.clear();
+    energies.clear();
+    delays.clear();
+    definitions.clear();
+
+    G4cout << "Tabulating " << ndecays << " decays of " << nuclide << ( chain ? " and its daughters" : "" ) << G4endl;
+
+    std::stringstream ss;
+    ss << "/run/beamOn " << ndecays;
+
+    tabulating = true;
+    G4UImanager::GetUIpointer()->ApplyCommand( ss.str() );
+    tabulating = false;
+    nucleus_delays.clear();
+
+    // The next run takes the number of the tabulation run, as if it had not been.
+    G4RunManager* run_manager = G4RunManager::GetRunManager();
+    if( run_manager->GetCurrentRun()!=0 )
+        run_manager->SetRunIDCounter( run_manager->GetCurrentRun()->GetRunID() );
+
+    offsets.push_back( pdg_codes.size() );
+    if( IsEmpty() ){
+        G4cerr << "No decay of " << nuclide << " was recorded, is radioactive decay in the physics list?" << G4endl;
+        offsets.clear();
+        return;
+    }
+
+    mkdir( cache_dir.c_str(), 0755 );
+    WriteTable( CacheFile() );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DecaySource::Record( const G4Track* track ){
+
+    // The nucleus of the event starts a new decay.
+    if( track->GetParentID()==0 ){
+        offsets.push_back( pdg_codes.size() );
+        nucleus_delays.clear();
+        return true;
+    }
+
+    const G4VProcess* creator = track->GetCreatorProcess();
+    if( creator==0 || creator->GetProcessType()!=fDecay )
+        return false;
+
+    // The secondaries are stacked once their parent nucleus has decayed at rest, so its
+    // local time is its lifetime. The global times are not used: after a long-lived
+    // parent they are too large to resolve short delays.
+    G4double delay = 0;
+    std::map<G4int, G4double>::const_iterator parent = nucleus_delays.find( track->GetParentID() );
+    if( parent!=nucleus_delays.end() ){
+        const G4Track* decayed = G4EventManager::GetEventManager()->GetTrackingManager()->GetTrack();
+        delay = parent->second + ( decayed!=0 && decayed->GetTrackID()==parent->first ? decayed->GetLocalTime() : 0. );
+    }
+
+    const G4ParticleDefinition* particle = track->GetDefinition();
+
+    // Daughter nuclei: excited states decay within the decay of their parent.
+    if( particle->GetParticleType()=="nucleus" && particle!=G4Alpha::Definition() ){
+        G4bool follow = chain || static_cast<const G4Ions*>( particle )->GetExcitationEnergy()>0;
+        if( follow )
+            nucleus_delays[track->GetTrackID()] = delay;
+        return follow;
+    }
+
+    // Neutrinos leave.
+    if( particle->GetParticleType()=="lepton" && particle->GetPDGCharge()==0 )
+        return false;
+
+    pdg_codes.push_back( particle->GetPDGEncoding() );
+    energies.push_back( track->GetKineticEnergy() );
+    delays.push_back( delay );
+
+    return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecaySource::WriteTable( G4String file ) const {
+
+    std::ofstream out( file.c_str() );
+    if( !out.good() ){
+        G4cerr << "Cannot write the decay table to " << file << G4endl;
+        return;
+    }
+
+    // One line per decay: number of emissions, then PDG code, kinetic energy (MeV)
+    // and delay (ns) of each.
+    out << "# apixs decay table\n"
+        << "nuclide " << nuclide << '\n'
+        << "chain " << chain << '\n'
+        << "decays " << offsets.size()-1 << '\n'
+        << "geant4 " << GetGeant4Version() << '\n'
+        << std::setprecision( 9 );
+
+    for( size_t i=0; i+1<offsets.size(); i++ ){
+        out << offsets[i+1]-offsets[i];
+        for( size_t k=offsets[i]; k<offsets[i+1]; k++ )
+            out << ' ' << pdg_codes[k] << ' ' << energies[k]/MeV << ' ' << delays[k]/ns;
+        out << '\n';
+    }
+
+    G4cout << "    " << offsets.size()-1 << " decays written to " << file << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DecaySource::ReadTable( G4String file, G4bool check ){
+
+    std::ifstream in( file.c_str() );
+    if( !in.good() ){
+        if( !check )
+            G4cerr << "Cannot open " << file << G4endl;
+        return false;
+    }
+
+    std::string line, word, name, version;
+    G4bool table_chain;
+    G4int n;
+    std::getline( in, line );
+    in >> word >> name >> word >> table_chain >> word >> n >> word;
+    std::getline( in, version );
+    version.erase( 0, version.find_first_not_of( " \t" ) );
+    version.erase( version.find_last_not_of( " \t\r" )+1 );
+
+    if( in.fail() || n<=0 ){
+        G4cerr << file << " is not a decay table." << G4endl;
+        return false;
+    }
+    if( check && ( name!=nuclide || table_chain!=chain || n<ndecays
+                   || version!=GetGeant4Version() ) )
+        return false;
+
+    std::vector<size_t> o( 1, 0 );
+    std::vector<G4int> p;
+    std::vector<G4double> e, t;
+
+    for( G4int i=0; i<n; i++ ){
+        G4int m;
+        in >> m;
+        for( G4int k=0; k<m; k++ ){
+            G4int code;
+            G4double energy, delay;
+            in >> code >> energy >> delay;
+            p.push_back( code );
+            e.push_back( energy*MeV );
+            t.push_back( delay*ns );
+        }
+        o.push_back( p.size() );
+    }
+
+    if( in.fail() ){
+        G4cerr << file << " is truncated." << G4endl;
+        return false;
+    }
+
+    nuclide = name;
+    chain = table_chain;
+    offsets.swap( o );
+    pdg_codes.swap( p );
+    energies.swap( e );
+    delays.swap( t );
+    definitions.clear();
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecaySource::GeneratePrimaryVertex( G4Event* event ){
+
+    // Tabulation: the nucleus at rest, decayed by the physics list.
+    if( tabulating ){
+        G4PrimaryParticle* particle = new G4PrimaryParticle( nucleus );
+        particle->SetKineticEnergy( 0 );
+        G4PrimaryVertex* vertex = new G4PrimaryVertex( center, 0 );
+        vertex->SetPrimary( particle );
+        event->AddPrimaryVertex( vertex );
+        return;
+    }
+
+    if( definitions.size()!=pdg_codes.size() ){
+        G4ParticleTable* table = G4ParticleTable::GetParticleTable();
+        definitions.resize( pdg_codes.size() );
+        for( size_t k=0; k<pdg_codes.size(); k++ )
+            definitions[k] = table->FindParticle( pdg_codes[k] );
+    }
+
+    G4int n = offsets.size()-1;
+    G4int i = std::min( G4int( G4UniformRand()*n ), n-1 );
+
+    G4double r = radius*std::sqrt( G4UniformRand() );
+    G4double phi = twopi*G4UniformRand();
+    G4ThreeVector position = center + r*std::cos( phi )*axis_u + r*std::sin( phi )*axis_v;
+
+    for( size_t k=offsets[i]; k<offsets[i+1]; k++ ){
+        if( definitions[k]==0 )
+            continue;
+
+        G4PrimaryParticle* particle = new G4PrimaryParticle( definitions[k] );
+        particle->SetKineticEnergy( energies[k] );
+        particle->SetMomentumDirection( G4RandomDirection() );
+
+        G4PrimaryVertex* vertex = new G4PrimaryVertex( position, delays[k] );
+        vertex->SetPrimary( particle );
+        event->AddPrimaryVertex( vertex );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecaySource::Print() const {
+
+    if( IsEmpty() ){
+        G4cout << "Decay source: no table" << G4endl;
+        return;
+    }
+
+    // Mean number of each particle per decay.
+    std::map<G4int, G4int> counts;
+    for( size_t k=0; k<pdg_codes.size(); k++ )
+        counts[ pdg_codes[k] ]++;
+
+    G4int n = offsets.size()-1;
+    G4cout << "Decay source: " << n << " decays of " << nuclide << ( chain ? " and its daughters" : "" ) << G4endl;
+    G4ParticleTable* table = G4ParticleTable::GetParticleTable();
+    for( std::map<G4int, G4int>::const_iterator it=counts.begin(); it!=counts.end(); ++it ){
+        G4ParticleDefinition* particle = table->FindParticle( it->first );
+        G4cout << "    " << ( particle!=0 ? particle->GetParticleName() : G4String( "unknown" ) ) << ": "
+               << G4double( it->second )/n << " per decay" << G4endl;
+    }
+    G4cout << "    disk at " << G4BestUnit( center, "Length" ) << ", radius " << G4BestUnit( radius, "Length" ) << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
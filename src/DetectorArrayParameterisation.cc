@@ -0,0 +1,33 @@
+/// \file DetectorArrayParameterisation.cc
+/// \brief Implementation of the DetectorArrayParameterisation class
+
+#include "DetectorArrayParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorArrayParameterisation::DetectorArrayParameterisation() : G4VPVParameterisation() {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorArrayParameterisation::~DetectorArrayParameterisation(){
+    for( size_t i=0; i<rotations.size(); i++ )
+        delete rotations[i];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorArrayParameterisation::AddElement( G4ThreeVector pos, const G4RotationMatrix& rot ){
+    positions.push_back( pos );
+    rotations.push_back( rot.isIdentity() ? 0 : new G4RotationMatrix( rot.inverse() ) );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorArrayParameterisation::ComputeTransformation( const G4int copyNo, G4VPhysicalVolume* pv ) const {
+    pv->SetTranslation( positions[copyNo] );
+    pv->SetRotation( rotations[copyNo] );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
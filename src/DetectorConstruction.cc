@@ -10,6 +10,12 @@
 #include "G4Material.hh"
 
 #include "DetectorConstructionMessenger.hh"
+#include "SphereScorer.hh"
+#include "DetectorArrayParameterisation.hh"
+#include "StartupTimer.hh"
+#include "GeometryUtils.hh"
+
+#include "G4SDManager.hh"
 
 #include "G4Box.hh"
 #include "G4Tubs.hh"
@@ -20,6 +26,8 @@
 #include "G4SubtractionSolid.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4VTouchable.hh"
 #include "G4GlobalMagFieldMessenger.hh"
 #include "G4AutoDelete.hh"
 #include "G4VisExtent.hh"
@@ -43,6 +51,7 @@
 #include "G4SystemOfUnits.hh"
 
 #include<sstream>
+#include<algorithm>
 using std::stringstream;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -50,6 +59,8 @@ using std::stringstream;
 
 DetectorConstruction::DetectorConstruction() : G4VUserDetectorConstruction() {
     fCheckOverlaps = true;
+    quiet = false;
+    startup_timer = 0;
     fDetectorMessenger = new DetectorConstructionMessenger(this);
     
     mat_man = G4NistManager::Instance(); //material mananger
@@ -75,6 +86,10 @@ DetectorConstruction::DetectorConstruction() : G4VUserDetectorConstruction() {
 
     farside_rot = new G4RotationMatrix();
     fs_count = 0;
+    array_count = 0;
+
+    sphere_scorer = new SphereScorer( "scoring_sphere" );
+    sphere_placed = false;
 }
 
 
@@ -83,6 +98,10 @@ DetectorConstruction::DetectorConstruction() : G4VUserDetectorConstruction() {
 
 DetectorConstruction::~DetectorConstruction(){
     delete fDetectorMessenger;
+
+    // Once placed, the scorer belongs to the G4SDManager.
+    if( !sphere_placed )
+        delete sphere_scorer;
 }
 
 
@@ -91,7 +110,14 @@ DetectorConstruction::~DetectorConstruction(){
 
 G4VPhysicalVolume* DetectorConstruction::Construct(){
     DefineMaterials();
-    return DefineVolumes();
+    if( startup_timer!=0 )
+        startup_timer->Mark( "materials" );
+
+    G4VPhysicalVolume* world = DefineVolumes();
+    if( startup_timer!=0 )
+        startup_timer->Mark( "volumes" );
+
+    return world;
 }
 
 
@@ -197,36 +223,55 @@ void DetectorConstruction::DefineMaterials(){
     */
 
     // Print materials
-    G4cout << *(G4Material::GetMaterialTable()) << G4endl;
+    if( !quiet )
+        G4cout << *(G4Material::GetMaterialTable()) << G4endl;
 }
 
 
-void DetectorConstruction::PlaceFarSideDetector(){
+void DetectorConstruction::GetFarSideCaseSize( G4double& radius, G4double& half_length ){
+    G4double NaI_thickness = 2*2.54*cm;
+    G4double NaI_dia = 2*2.54*cm;
+    G4double Al_thickness = 1*mm;
+
+    radius = NaI_dia/2+Al_thickness;
+    half_length = (2*Al_thickness+NaI_thickness)/2;
+}
 
-    // Use stringstream to parameterize the farside detector name with count number
-    stringstream ss;
-    ss << "farside_" << fs_count;
+
+G4LogicalVolume* DetectorConstruction::BuildFarSideCase( G4String crystal_name ){
 
     G4Material* NaI_material = mat_man->FindOrBuildMaterial("NaI");
     G4Material* Al_material = mat_man->FindOrBuildMaterial("G4_Al");
 
-    // Place the far-side detector.
-
     G4double NaI_thickness = 2*2.54*cm;
     G4double NaI_dia = 2*2.54*cm;
-    G4double Al_thickness = 1*mm;
 
-    G4Tubs* case_solid = new G4Tubs( "case_solid", 0, NaI_dia/2+Al_thickness, (2*Al_thickness+NaI_thickness)/2, 0, CLHEP::twopi);
-    G4LogicalVolume* case_lv = new G4LogicalVolume( case_solid, Al_material, "case_lv");
-
-    G4RotationMatrix* rot = new G4RotationMatrix( *farside_rot );
-    new G4PVPlacement( rot, farside_position, case_lv, "case", world_lv, false, 0, fCheckOverlaps);
+    G4double case_radius, case_half_length;
+    GetFarSideCaseSize( case_radius, case_half_length );
 
+    G4Tubs* case_solid = new G4Tubs( "case_solid", 0, case_radius, case_half_length, 0, CLHEP::twopi);
+    G4LogicalVolume* case_lv = new G4LogicalVolume( case_solid, Al_material, "case_lv");
 
     G4Tubs* farside_solid = new G4Tubs( "fs_solid", 0, NaI_dia/2, NaI_thickness/2, 0, CLHEP::twopi);
     G4LogicalVolume* farside_lv = new G4LogicalVolume( farside_solid, NaI_material, "fs_lv");
 
-    new G4PVPlacement( 0, G4ThreeVector(0,0,0), farside_lv, ss.str(), case_lv, false, 0, fCheckOverlaps);
+    new G4PVPlacement( 0, G4ThreeVector(0,0,0), farside_lv, crystal_name, case_lv, false, 0, fCheckOverlaps);
+
+    return case_lv;
+}
+
+
+void DetectorConstruction::PlaceFarSideDetector(){
+
+    // Use stringstream to parameterize the farside detector name with count number
+    stringstream ss;
+    ss << "farside_" << fs_count;
+
+    // Place the far-side detector.
+    G4LogicalVolume* case_lv = BuildFarSideCase( ss.str() );
+
+    G4RotationMatrix* rot = new G4RotationMatrix( *farside_rot );
+    new G4PVPlacement( rot, farside_position, case_lv, "case", world_lv, false, 0, fCheckOverlaps);
 
     // Inform run manager about geometry change.
     G4RunManager::GetRunManager()->GeometryHasBeenModified();
@@ -237,6 +282,164 @@ void DetectorConstruction::PlaceFarSideDetector(){
 }
 
 
+G4int DetectorConstruction::GetDetectorID( const G4VTouchable* touchable ){
+    if( touchable->GetHistoryDepth()>0 && touchable->GetVolume( 1 )->IsParameterised() )
+        return touchable->GetReplicaNumber( 1 );
+    return touchable->GetCopyNumber();
+}
+
+
+void DetectorConstruction::PlaceRing( G4int n, G4double radius, G4double z, G4double phi0, G4double dphi ){
+
+    stringstream ss;
+    ss << "array_" << array_count;
+    G4String name = ss.str();
+
+    G4double a, h;
+    GetFarSideCaseSize( a, h );
+    G4double tolerance = 1*um;
+
+    if( radius-h<=a ){
+        G4cerr << "/placement/ring: the radius is too small for the detectors." << G4endl;
+        return;
+    }
+    if( n>1 && ( 2*( radius-h )*std::sin( std::min( std::fabs( dphi ), CLHEP::pi )/2 ) < 2*a || n*std::fabs( dphi ) > CLHEP::twopi*( 1+1e-9 ) ) ){
+        G4cerr << "/placement/ring: neighbouring detectors would overlap." << G4endl;
+        return;
+    }
+
+    G4LogicalVolume* case_lv = BuildFarSideCase( "farside_" + name );
+
+    // Each detector faces the z axis.
+    DetectorArrayParameterisation* param = new DetectorArrayParameterisation();
+    for( G4int i=0; i<n; i++ ){
+        G4double phi = phi0 + i*dphi;
+        G4RotationMatrix rot;
+        rot.rotateY( 90*deg );
+        rot.rotateZ( phi );
+        param->AddElement( G4ThreeVector( radius*std::cos( phi ), radius*std::sin( phi ), 0 ), rot );
+    }
+
+    // Envelope: the sector of annulus holding the detectors, the only daughter of the world
+    // added by the array.
+    G4double margin = std::atan2( a+tolerance, radius-h-tolerance );
+    G4double start = std::min( phi0, phi0+( n-1 )*dphi ) - margin;
+    G4double span = std::fabs( dphi )*( n-1 ) + 2*margin;
+    if( span>=CLHEP::twopi ){
+        start = 0;
+        span = CLHEP::twopi;
+    }
+
+    G4Material* vacuum_material = mat_man->FindOrBuildMaterial("G4_Galactic");
+    G4Tubs* envelope_solid = new G4Tubs( name+"_solid", radius-h-tolerance, std::sqrt( (radius+h)*(radius+h) + a*a )+tolerance, a+tolerance, start, span );
+    G4LogicalVolume* envelope_lv = new G4LogicalVolume( envelope_solid, vacuum_material, name+"_lv" );
+    envelope_lv->SetVisAttributes( G4VisAttributes::Invisible );
+
+    new G4PVPlacement( 0, G4ThreeVector( 0, 0, z ), envelope_lv, name, world_lv, false, 0, fCheckOverlaps );
+    new G4PVParameterised( name+"_case", case_lv, envelope_lv, kUndefined, n, param, fCheckOverlaps );
+
+    G4cout << "Placed " << name << ": ring of " << n << " detectors farside_" << name << ", detector IDs 0 to " << n-1 << G4endl;
+
+    // Inform run manager about geometry change.
+    G4RunManager::GetRunManager()->GeometryHasBeenModified();
+
+    array_count++;
+}
+
+
+void DetectorConstruction::PlaceGrid( G4int nx, G4int ny, G4double pitch, G4ThreeVector center ){
+
+    stringstream ss;
+    ss << "array_" << array_count;
+    G4String name = ss.str();
+
+    if( center.mag()==0 ){
+        G4cerr << "/placement/grid: the grid cannot be centered on the origin." << G4endl;
+        return;
+    }
+
+    G4double a, h;
+    GetFarSideCaseSize( a, h );
+    G4double tolerance = 1*um;
+
+    if( pitch<2*a ){
+        G4cerr << "/placement/grid: the pitch is smaller than the detector diameter." << G4endl;
+        return;
+    }
+
+    G4LogicalVolume* case_lv = BuildFarSideCase( "farside_" + name );
+
+    // Axes of the grid: w towards the center of the grid, u horizontal if possible.
+    G4ThreeVector w = center.unit();
+    G4ThreeVector u, v;
+    GetTransverseAxes( w, u, v );
+
+    // Detectors along the z axis of the envelope, which is along w.
+    DetectorArrayParameterisation* param = new DetectorArrayParameterisation();
+    for( G4int j=0; j<ny; j++ ){
+        for( G4int i=0; i<nx; i++ )
+            param->AddElement( G4ThreeVector( ( i-( nx-1 )/2. )*pitch, ( j-( ny-1 )/2. )*pitch, 0 ), G4RotationMatrix() );
+    }
+
+    G4Material* vacuum_material = mat_man->FindOrBuildMaterial("G4_Galactic");
+    G4Box* envelope_solid = new G4Box( name+"_solid", ( nx-1 )*pitch/2+a+tolerance, ( ny-1 )*pitch/2+a+tolerance, h+tolerance );
+    G4LogicalVolume* envelope_lv = new G4LogicalVolume( envelope_solid, vacuum_material, name+"_lv" );
+    envelope_lv->SetVisAttributes( G4VisAttributes::Invisible );
+
+    new G4PVPlacement( G4Transform3D( G4RotationMatrix( u, v, w ), center ), envelope_lv, name, world_lv, false, 0, fCheckOverlaps );
+    new G4PVParameterised( name+"_case", case_lv, envelope_lv, kUndefined, nx*ny, param, fCheckOverlaps );
+
+    G4cout << "Placed " << name << ": " << nx << "x" << ny << " grid of detectors farside_" << name
+           << ", detector ID i+" << nx << "*j" << G4endl;
+
+    // Inform run manager about geometry change.
+    G4RunManager::GetRunManager()->GeometryHasBeenModified();
+
+    array_count++;
+}
+
+
+void DetectorConstruction::PlaceScoringSphere( G4double radius, G4double thickness ){
+
+    if( sphere_placed ){
+        G4cerr << "The scoring sphere has already been placed." << G4endl;
+        return;
+    }
+
+    if( radius+thickness > std::min( world_x, std::min( world_y, world_z ) )/2 ){
+        G4cerr << "The scoring sphere does not fit in the world." << G4endl;
+        return;
+    }
+
+    G4Material* vacuum_material = mat_man->FindOrBuildMaterial("G4_Galactic");
+
+    G4Sphere* sphere_solid = new G4Sphere( "sphere_solid", radius, radius+thickness, 0, CLHEP::twopi, 0, CLHEP::pi);
+    G4LogicalVolume* sphere_lv = new G4LogicalVolume( sphere_solid, vacuum_material, "sphere_lv");
+    G4VPhysicalVolume* sphere_pv = new G4PVPlacement( 0, G4ThreeVector(0,0,0), sphere_lv, "scoring_sphere", world_lv, false, 0, false);
+
+    // The shell must pass around the setup, not through it: a sphere cutting the other
+    // volumes would score particles that are still inside them.
+    if( sphere_pv->CheckOverlaps() ){
+        G4cerr << "The scoring sphere of radius " << radius/mm << " mm overlaps other volumes, it is not placed." << G4endl;
+        world_lv->RemoveDaughter( sphere_pv );
+        delete sphere_pv;
+        delete sphere_lv;
+        delete sphere_solid;
+        return;
+    }
+
+    G4SDManager::GetSDMpointer()->AddNewDetector( sphere_scorer );
+    sphere_lv->SetSensitiveDetector( sphere_scorer );
+    sphere_scorer->SetPlaced();
+    sphere_lv->SetVisAttributes( G4VisAttributes( G4Colour( 0, 1., 0, 0.1 ) ) );
+
+    // Inform run manager about geometry change.
+    G4RunManager::GetRunManager()->GeometryHasBeenModified();
+
+    sphere_placed = true;
+}
+
+
 void DetectorConstruction::PlaceFilter( G4ThreeVector a ){
 
     G4double filter_id = a.x();
@@ -9,6 +9,10 @@
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIparameter.hh"
+#include "SphereScorer.hh"
+
+#include <sstream>
 
 DetectorConstructionMessenger::DetectorConstructionMessenger( DetectorConstruction* placement) : G4UImessenger(), detector( placement ){
 
@@ -56,6 +60,36 @@ DetectorConstructionMessenger::DetectorConstructionMessenger( DetectorConstructi
     place_detector->SetGuidance( "Place a far-side detector based on the previously specified positions and angles." );
     place_detector->AvailableForStates( G4State_Idle );
 
+    ringCmd = new G4UIcommand( "/placement/ring", this );
+    ringCmd->SetGuidance( "Place N far-side detectors on a circle of radius r in the x-y plane at height z, at the azimuths phi0+i*dphi, all facing the z axis." );
+    ringCmd->SetGuidance( "The detectors are one parameterised volume, the detector ID of the i-th one is i." );
+    ringCmd->SetGuidance( "This command does not accept user input unit and the internal unit for distance is cm and that for angle is degree." );
+    ringCmd->AvailableForStates( G4State_Idle );
+
+    G4UIparameter* ring_param = new G4UIparameter( "N", 'i', false );
+    ring_param->SetParameterRange( "N>0" );
+    ringCmd->SetParameter( ring_param );
+    const char* ring_names[] = { "r", "z", "phi0", "dphi" };
+    for( int i=0; i<4; i++ )
+        ringCmd->SetParameter( new G4UIparameter( ring_names[i], 'd', false ) );
+
+    gridCmd = new G4UIcommand( "/placement/grid", this );
+    gridCmd->SetGuidance( "Place nx x ny far-side detectors on a square grid of the given pitch centered on (x,y,z)," );
+    gridCmd->SetGuidance( "in the plane perpendicular to the direction of the center, all facing the origin." );
+    gridCmd->SetGuidance( "The detectors are one parameterised volume, the detector ID of the detector (i,j) is i+nx*j." );
+    gridCmd->SetGuidance( "This command does not accept user input unit and the internal unit for distance is cm." );
+    gridCmd->AvailableForStates( G4State_Idle );
+
+    const char* grid_names[] = { "nx", "ny" };
+    for( int i=0; i<2; i++ ){
+        G4UIparameter* grid_param = new G4UIparameter( grid_names[i], 'i', false );
+        grid_param->SetParameterRange( G4String( grid_names[i] )+">0" );
+        gridCmd->SetParameter( grid_param );
+    }
+    const char* grid_lengths[] = { "pitch", "x", "y", "z" };
+    for( int i=0; i<4; i++ )
+        gridCmd->SetParameter( new G4UIparameter( grid_lengths[i], 'd', false ) );
+
 
     filterPosCmd = new G4UIcmdWith3VectorAndUnit( "/placement/filter_pos", this );
     filterPosCmd->SetGuidance( "Set the position of the filter.\nUnit is in cm by default.");
@@ -100,6 +134,42 @@ DetectorConstructionMessenger::DetectorConstructionMessenger( DetectorConstructi
     place_filter->AvailableForStates( G4State_Idle );
     place_filter->SetDefaultValue( G4ThreeVector( 0.635*CLHEP::cm, 10*CLHEP::cm, 0) );
     place_filter->SetDefaultUnit( "cm" );
+
+
+    sphereCmd = new G4UIcommand( "/placement/scoringSphere", this );
+    sphereCmd->SetGuidance( "Place a thin vacuum shell centered on the origin, scoring the angle and energy of every particle crossing it outwards." );
+    sphereCmd->SetGuidance( "It replaces a ring of far-side detectors: every emitted particle contributes to the angular distribution." );
+    sphereCmd->SetGuidance( "The sphere must enclose the setup, a sphere overlapping other volumes is not placed." );
+    sphereCmd->AvailableForStates( G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "radius", 'd', false );
+    param->SetParameterRange( "radius>0" );
+    sphereCmd->SetParameter( param );
+    param = new G4UIparameter( "thickness", 'd', true );
+    param->SetDefaultValue( 0.1 );
+    param->SetParameterRange( "thickness>0" );
+    sphereCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "mm" );
+    sphereCmd->SetParameter( param );
+
+    sphereBinCmd = new G4UIcommand( "/placement/scoringSphereBinning", this );
+    sphereBinCmd->SetGuidance( "Number of bins in theta (0 to pi) and phi (-pi to pi), and energy binning of the scoring sphere." );
+    sphereBinCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    const char* names[] = { "ntheta", "nphi", "nE" };
+    for( int i=0; i<3; i++ ){
+        param = new G4UIparameter( names[i], 'i', false );
+        param->SetParameterRange( G4String( names[i] )+">0" );
+        sphereBinCmd->SetParameter( param );
+    }
+    param = new G4UIparameter( "Emin", 'd', false );
+    sphereBinCmd->SetParameter( param );
+    param = new G4UIparameter( "Emax", 'd', false );
+    sphereBinCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    sphereBinCmd->SetParameter( param );
 }
 
 
@@ -135,6 +205,20 @@ void DetectorConstructionMessenger::SetNewValue( G4UIcommand* command, G4String
     else if( command==place_detector ){
         detector->PlaceFarSideDetector();
     }
+    else if( command==ringCmd ){
+        std::istringstream is( newValue );
+        G4int n;
+        G4double r, z, phi0, dphi;
+        is >> n >> r >> z >> phi0 >> dphi;
+        detector->PlaceRing( n, r*CLHEP::cm, z*CLHEP::cm, phi0*CLHEP::deg, dphi*CLHEP::deg );
+    }
+    else if( command==gridCmd ){
+        std::istringstream is( newValue );
+        G4int nx, ny;
+        G4double pitch, x, y, z;
+        is >> nx >> ny >> pitch >> x >> y >> z;
+        detector->PlaceGrid( nx, ny, pitch*CLHEP::cm, G4ThreeVector( x, y, z )*CLHEP::cm );
+    }
     else if( command==filterPosCmd ){
         detector->SetFilterPosition( filterPosCmd->GetNew3VectorValue( newValue ) );
     }
@@ -157,5 +241,24 @@ void DetectorConstructionMessenger::SetNewValue( G4UIcommand* command, G4String
     else if( command==place_filter ){
         detector->PlaceFilter( place_filter->GetNew3VectorValue( newValue) );
     }
+    else if( command==sphereCmd ){
+        std::istringstream is( newValue );
+        G4double r, t;
+        G4String unit;
+        is >> r >> t >> unit;
+        detector->PlaceScoringSphere( r*G4UIcommand::ValueOf( unit ), t*G4UIcommand::ValueOf( unit ) );
+    }
+    else if( command==sphereBinCmd ){
+        std::istringstream is( newValue );
+        G4int nt, np, ne;
+        G4double emin, emax;
+        G4String unit;
+        is >> nt >> np >> ne >> emin >> emax >> unit;
+        if( emax<=emin ){
+            G4cerr << "/placement/scoringSphereBinning: Emax must be larger than Emin." << G4endl;
+            return;
+        }
+        detector->GetSphereScorer()->SetBinning( nt, np, ne, emin*G4UIcommand::ValueOf( unit ), emax*G4UIcommand::ValueOf( unit ) );
+    }
     return;
 }
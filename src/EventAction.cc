@@ -1,59 +1,92 @@
-
 /// \file EventAction.cc
 /// \brief Implementation of the EventAction class
 
 #include "EventAction.hh"
 #include "RunAction.hh"
+#include "OutputSink.hh"
+#include "Trigger.hh"
+#include "StepFilter.hh"
+#include "StepSpill.hh"
+#include "XrayTally.hh"
+#include "PointDetector.hh"
+#include "ResponseMatrix.hh"
+#include "ConvergenceMonitor.hh"
+#include "ScoringMesh.hh"
+#include "GeneratorAction.hh"
+#include "RunMetrics.hh"
 
-#include "G4RunManager.hh"
 #include "G4Event.hh"
+#include "G4Track.hh"
 #include "G4UnitsTable.hh"
 
 #include "Randomize.hh"
 #include <iomanip>
+#include <algorithm>
 
 #include "StepInfo.hh"
 #include "G4ThreeVector.hh"
 
-#include "TTree.h"
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+    bool ByPrimary( const StepInfo& a, const StepInfo& b ){
+        return a.GetPrimaryIndex()<b.GetPrimaryIndex();
+    }
+
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EventAction::EventAction( RunAction* input_run_action )
  : G4UserEventAction(),
    run_action(input_run_action),
-   eventID(0),
-   trackID(0),
-   stepID(0),
-   parentID(0),
-   tmp_particle_name(""),
-   tmp_volume_name(""),
-   tmp_process_name(""),
-   position(0),
-   momentum(0),
-   x(0),
-   y(0),
-   z(0),
-   theta(0),
-   phi(0),
-   px(0),
-   py(0),
-   pz(0),
-   global_time(0),
-   Eki(0),
-   Ekf(0),
-   edep(0),
-   stepCollection()
+   trigger(0),
+   step_filter(0),
+   xray_tally(0),
+   point_detector(0),
+   response_matrix(0),
+   convergence(0),
+   mesh(0),
+   stepCollection(),
+   record_type(StepInfo::GetRecordType( "full" )),
+   nsteps(0),
+   event_id(0),
+   tabulating(false),
+   nprimaries(1),
+   max_bytes(0),
+   max_steps(0),
+   name_bytes(0),
+   spill_enabled(false),
+   spill(0),
+   spilled(false),
+   truncated(false),
+   peak_bytes(0)
 {
-    max_char_len = 15;
-    data_tree = 0;
+    trigger = new Trigger();
+    step_filter = new StepFilter();
+    xray_tally = new XrayTally();
+    point_detector = new PointDetector();
+    response_matrix = new ResponseMatrix();
+    convergence = new ConvergenceMonitor();
+    mesh = new ScoringMesh();
+    spill = new StepSpill();
 }
 
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 
-EventAction::~EventAction(){}
+EventAction::~EventAction(){
+    delete trigger;
+    delete step_filter;
+    delete xray_tally;
+    delete point_detector;
+    delete response_matrix;
+    delete convergence;
+    delete mesh;
+    delete spill;
+}
 
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -65,123 +98,170 @@ void EventAction::PrintEventStatistics() const {}
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 
-void EventAction::BeginOfEventAction(const G4Event*){
-    
-    // If pointer to ROOT tree is empty, then ask RunAction to create the ROOT tree
-    // and assign address of variables for output.
-    if( data_tree==0 ){
-
-        data_tree = run_action->GetDataTree();
-
-        // Proceed only if data output is enabled.
-        if( data_tree!=0 ){
-            // information about its order in the event/run sequence
-            data_tree->Branch("eventID", &eventID, "eventID/I");
-            data_tree->Branch("trackID", &trackID, "trackID/I");
-            data_tree->Branch("stepID", &stepID, "stepID/I");
-
-            // information about its idenity
-            data_tree->Branch("particle", particle_name, "particle[16]/C");
-            data_tree->Branch("parentID", &parentID, "parentID/I");
-
-            // geometric information
-            data_tree->Branch("volume", volume_name, "volume[16]/C");
-            //data_tree->Branch("copy_n", &volume_copy_number, "copy_n/I");
-            data_tree->Branch("x", &x, "x/D");
-            data_tree->Branch("y", &y, "y/D");
-            data_tree->Branch("z", &z, "z/D");
-            data_tree->Branch("theta", &theta, "theta/D");
-            data_tree->Branch("phi", &phi, "phi/D");
-            data_tree->Branch("px", &px, "px/D");
-            data_tree->Branch("py", &py, "py/D");
-            data_tree->Branch("pz", &pz, "pz/D");
-
-            // dynamic information
-            data_tree->Branch("t", &global_time, "t/D");
-            data_tree->Branch("Eki", &Eki, "Eki/D"); // initial kinetic energy before the step
-            data_tree->Branch("Ekf", &Ekf, "Ekf/D"); // final kinetic energy after the step
-            data_tree->Branch("Edep", &edep, "Edep/D"); // energy deposit calculated by Geant4
-            data_tree->Branch("process", process_name, "process[16]/C");
-        }
+void EventAction::BeginOfEventAction(const G4Event* event){
+
+    tabulating = run_action->IsTabulating();
+    if( tabulating )
+        return;
+
+    GeneratorAction* generator = run_action->GetGeneratorAction();
+    nprimaries = generator!=0 ? generator->GetEventPrimaries() : 1;
+    event_id = event->GetEventID();
+    track_primary.clear();
+    nsteps = 0;
+    record_type = run_action->GetRecordType();
+
+    trigger->BeginOfEvent( nprimaries );
+
+    max_bytes = run_action->GetMaxEventMemory();
+    max_steps = max_bytes>0 ? std::max( size_t( max_bytes/sizeof( StepInfo ) ), size_t( 1 ) ) : 0;
+        // upper bound, lowered in Grow() once the size of the names is known
+
+    // The steps of a spilled event cannot be sorted by primary: they are truncated instead.
+    OutputSink* sink = run_action->GetSink();
+    spill_enabled = run_action->GetOverflowMode()=="spill" && sink!=0 && sink->SupportsPartialEvents() && nprimaries==1;
+
+    // A buffer grown by an earlier event without limit is released.
+    if( max_steps>0 && stepCollection.capacity()>max_steps )
+        vector<StepInfo>().swap( stepCollection );
+
+    spilled = false;
+    truncated = false;
+    name_bytes = 0;
+    peak_bytes = stepCollection.capacity()*sizeof( StepInfo );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool EventAction::Grow(){
+
+    if( truncated )
+        return false;
+
+    // The steps allowed by the limit, with the names taking as much per step as
+    // they did so far.
+    size_t size = stepCollection.size();
+    G4double step_bytes = sizeof( StepInfo ) + ( size>0 ? name_bytes/size : 0 );
+    size_t allowed = std::min( std::max( size_t( max_bytes/step_bytes ), size_t( 1 ) ), max_steps );
+    peak_bytes = std::max( peak_bytes, stepCollection.capacity()*sizeof( StepInfo )+name_bytes );
+
+    if( size<allowed ){
+        // Grow as vector would, but not past the limit.
+        size_t n = std::min( std::max( 2*stepCollection.capacity(), size_t( 64 ) ), allowed );
+        stepCollection.reserve( n );
+        peak_bytes = std::max( peak_bytes, n*sizeof( StepInfo )+name_bytes );
+        return true;
+    }
+
+    if( spill_enabled && spill->Write( stepCollection ) ){
+        spilled = true;
+        stepCollection.clear();
+        name_bytes = 0;
+        return true;
     }
+
+    truncated = true;
+    return false;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void EventAction::EndOfEventAction(const G4Event* event){
 
-    // Print per event modulo n
+    if( tabulating ){
+        stepCollection.clear();
+        return;
+    }
+
+    // Print per event modulo n, at most once per /metrics/printInterval
     G4int evtID = event->GetEventID();
-    G4int printModulo = G4RunManager::GetRunManager()->GetPrintProgress();
-    if ( ( printModulo > 0 ) && ( evtID % printModulo == 0 ) ) {
-        G4cout << "---> End of event: " << evtID << G4endl;
+    run_action->GetMetrics()->PrintProgress( evtID );
+
+    OutputSink* sink = run_action->GetSink();
+
+    mesh->EndOfEvent();
+
+    peak_bytes = std::max( peak_bytes, stepCollection.capacity()*sizeof( StepInfo )+name_bytes );
+
+    // Write the event if it passes the trigger
+    G4bool accepted = trigger->EndOfEvent();
+    if( sink!=0 && accepted && spilled ){
+        // Stream the event back from the spill file, one buffer at a time.
+        spill->Write( stepCollection );
+        spill->Rewind();
+        G4bool first = true;
+        // Read back in buffers of the size the limit allowed when spilling.
+        size_t nread = std::max( stepCollection.capacity(), size_t( 1 ) );
+        while( spill->Read( stepCollection, nread )>0 ){
+            sink->WriteEventPart( stepCollection, first, spill->AtEnd() );
+            first = false;
+        }
+    }
+    else if( sink!=0 && accepted && nprimaries>1 ){
+        WritePrimaries( sink );
+    }
+    else if( sink!=0 && accepted && !stepCollection.empty() ){
+        // As for the primaries of a multi-primary event, nothing is written for an
+        // event without recorded steps.
+        sink->WriteEvent( stepCollection );
     }
 
-    if( data_tree!=0 ){
+    point_detector->EndOfEvent();
+    response_matrix->EndOfEvent( evtID );
 
-        if_center  = false;
-        if_farside = false;
+    run_action->EventBuffered( evtID, peak_bytes, spill->GetBytes(), truncated );
+    if( spilled )
+        spill->Clear();
 
-        // Select the tracks of interest
-        for( size_t i=0; i < stepCollection.size(); ++i ){
+    stepCollection.clear();
+    name_bytes = 0;
 
-            trackID = stepCollection[i].GetTrackID();
-            tmp_volume_name = stepCollection[i].GetVolumeName();
-            edep = stepCollection[i].GetDepositedEnergy();
-            tmp_particle_name = stepCollection[i].GetParticleName();
+    run_action->EventCompleted( event, nsteps, accepted );
+}
 
-            if( tmp_volume_name=="detector" ){
-                if_center = true;
-                if_farside = true;
-                break;
-            }
-        }
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-        // There is coincidence. Fill the wanted tracks
-        if( if_farside && if_center ){
+void EventAction::TagTrack( const G4Track* track ){
 
-            for( size_t i=0; i < stepCollection.size(); ++i ){
-                eventID = stepCollection[i].GetEventID();
-                trackID = stepCollection[i].GetTrackID();
-                stepID = stepCollection[i].GetStepID();
-                parentID = stepCollection[i].GetParentID();
+    if( nprimaries<=1 )
+        return;
 
-                tmp_particle_name = stepCollection[i].GetParticleName();
-                strncpy( particle_name, tmp_particle_name.c_str(), max_char_len);
+    G4int id = track->GetTrackID();
+    if( id>=G4int( track_primary.size() ) )
+        track_primary.resize( std::max( 2*track_primary.size(), size_t( id+1 ) ), 0 );
 
-                tmp_volume_name = stepCollection[i].GetVolumeName();
-                strncpy( volume_name, tmp_volume_name.c_str(), max_char_len);
+    if( track->GetParentID()==0 )
+        track_primary[id] = run_action->GetGeneratorAction()->GetPrimaryTag( id );
+    else
+        track_primary[id] = GetPrimaryIndex( track->GetParentID() );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-                tmp_process_name = stepCollection[i].GetProcessName();
-                strncpy( process_name, tmp_process_name.c_str(), max_char_len);
-                //volume_copy_number = stepCollection[i].GetVolumeCopyNumber();
-                position = stepCollection[i].GetPosition();
-                x = position.x();
-                y = position.y();
-                z = position.z();
-                theta = position.theta();
-                phi = position.phi();
+void EventAction::WritePrimaries( OutputSink* sink ){
 
-                momentum = stepCollection[i].GetMomentumDirection();
-                px = momentum.x();
-                py = momentum.y();
-                pz = momentum.z();
+    // Steps grouped by primary, in their original order within each primary.
+    std::stable_sort( stepCollection.begin(), stepCollection.end(), ByPrimary );
 
-                global_time = stepCollection[i].GetGlobalTime();
+    size_t begin = 0;
+    while( begin<stepCollection.size() ){
 
-                Eki = stepCollection[i].GetEki();
-                Ekf = stepCollection[i].GetEkf();
-                edep = stepCollection[i].GetDepositedEnergy();
+        G4int k = stepCollection[begin].GetPrimaryIndex();
+        size_t end = begin;
+        while( end<stepCollection.size() && stepCollection[end].GetPrimaryIndex()==k )
+            end++;
 
-                data_tree->Fill();
-            }
+        if( trigger->IsAccepted( k ) ){
+            primary_steps.assign( stepCollection.begin()+begin, stepCollection.begin()+end );
+            for( size_t i=0; i<primary_steps.size(); i++ )
+                primary_steps[i].SetEventID( GetOutputEventID( primary_steps[i].GetTrackID() ) );
+            sink->WriteEvent( primary_steps );
         }
 
-        if_center = false;
-        if_farside = false;
+        begin = end;
     }
 
-    stepCollection.clear();
+    primary_steps.clear();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,460 @@
+/// \file FlatSink.cc
+/// \brief Implementation of the FlatSink class
+
+#include "FlatSink.hh"
+
+#include <cstring>
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FlatSink::FlatSink() : OutputSink(), file( 0 ){
+    memset( &header, 0, sizeof( header ) );
+    BuildFields();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FlatSink::~FlatSink(){
+    Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::BuildFields(){
+
+    fields.clear();
+
+    flat::FlatField f;
+    memset( &f, 0, sizeof( f ) );
+
+    const char* int_names[4] = { "eventID", "trackID", "stepID", "parentID" };
+    for( int i=0; i<4; i++ ){
+        strncpy( f.name, int_names[i], 15 );
+        f.type = 'i';
+        f.count = 1;
+        f.offset = offsetof( flat::FlatStepRecord, eventID ) + i*sizeof( int32_t );
+        fields.push_back( f );
+    }
+
+    if( record_fields & StepFields::kCopyNumber ){
+        memset( f.name, 0, sizeof( f.name ) );
+        strncpy( f.name, "copy_n", 15 );
+        f.type = 'i';
+        f.count = 1;
+        f.offset = offsetof( flat::FlatStepRecord, copy_n );
+        fields.push_back( f );
+    }
+
+    // The records keep their fixed layout, the fields outside the step record are zero
+    // and left out of the field table.
+    const char* char_names[3] = { "particle", "volume", "process" };
+    size_t char_offsets[3] = { offsetof( flat::FlatStepRecord, particle ), offsetof( flat::FlatStepRecord, volume ), offsetof( flat::FlatStepRecord, process ) };
+    unsigned char_fields[3] = { StepFields::kParticle, StepFields::kVolume, StepFields::kProcess };
+    for( int i=0; i<3; i++ ){
+        if( !( record_fields & char_fields[i] ) )
+            continue;
+        memset( f.name, 0, sizeof( f.name ) );
+        strncpy( f.name, char_names[i], 15 );
+        f.type = 'c';
+        f.count = 16;
+        f.offset = char_offsets[i];
+        fields.push_back( f );
+    }
+
+    for( int i=0; i<kNumKinematics; i++ ){
+        kinematics_enabled[i] = ( record_fields & GetKinematicsField( i ) )!=0;
+        if( !kinematics_enabled[i] )
+            continue;
+        memset( f.name, 0, sizeof( f.name ) );
+        strncpy( f.name, kinematics_names[i], 15 );
+        f.type = 'd';
+        f.count = 1;
+        f.offset = offsetof( flat::FlatStepRecord, kinematics ) + i*sizeof( double );
+        fields.push_back( f );
+    }
+
+    memcpy( header.magic, flat::kMagic, sizeof( header.magic ) );
+    header.version = flat::kVersion;
+    header.nfields = fields.size();
+    header.header_size = flat::HeaderSize( header.nfields );
+    header.record_size = sizeof( flat::FlatStepRecord );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteHeader(){
+
+    // The header and field table are rewritten in place, the records follow them.
+    vector<char> buffer( header.header_size, 0 );
+    memcpy( &buffer[0], &header, sizeof( header ) );
+    memcpy( &buffer[sizeof( header )], &fields[0], fields.size()*sizeof( flat::FlatField ) );
+
+    long position = ftell( file );
+    fseek( file, 0, SEEK_SET );
+    fwrite( &buffer[0], 1, buffer.size(), file );
+    if( position>0 )
+        fseek( file, position, SEEK_SET );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool FlatSink::Open( G4String name, G4bool resume ){
+
+    BuildFields();
+    file_name = name;
+
+    if( resume ){
+        file = fopen( name.c_str(), "r+b" );
+        if( file && Recover() && RecoverTables() ){
+            G4cout << "Resuming flat output file " << name << " after " << header.completed_events << " events." << G4endl;
+            return true;
+        }
+        // An existing file that cannot be recovered is never overwritten, only a
+        // missing one is created.
+        if( file ){
+            fclose( file );
+            file = 0;
+            for( std::map< std::string, FILE* >::iterator it=tables.begin(); it!=tables.end(); ++it )
+                fclose( it->second );
+            tables.clear();
+            G4cerr << "Cannot resume " << name << ": not a flat output file with the same record layout, or damaged." << G4endl;
+            return false;
+        }
+        G4cout << "No flat output to resume in " << name << ", starting from the first event." << G4endl;
+    }
+    else{
+        // Do not overwrite existing output, as for ROOT files.
+        FILE* existing = fopen( name.c_str(), "rb" );
+        if( existing ){
+            fclose( existing );
+            G4cerr << "Output file " << name << " already exists." << G4endl;
+            return false;
+        }
+    }
+
+    file = fopen( name.c_str(), "w+b" );
+    if( file==0 ){
+        G4cerr << "Cannot open flat output file " << name << G4endl;
+        return false;
+    }
+    setvbuf( file, 0, _IOFBF, 1<<22 );
+
+    // Table sizes of an earlier job writing to the same name.
+    remove( GetTableListPath().c_str() );
+
+    header.nrecords = 0;
+    header.completed_events = 0;
+    WriteHeader();
+    fseek( file, header.header_size, SEEK_SET );
+
+    G4cout << "Output flat file " << name << " created." << G4endl;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool FlatSink::Recover(){
+
+    flat::FlatHeader old;
+    if( fread( &old, sizeof( old ), 1, file )!=1 || memcmp( old.magic, flat::kMagic, sizeof( old.magic ) )!=0 )
+        return false;
+    if( old.version!=header.version || old.record_size!=header.record_size || old.header_size!=header.header_size )
+        return false;
+
+    header.nrecords = old.nrecords;
+    header.completed_events = old.completed_events;
+
+    // Drop whatever was written after the checkpoint, including an index from a closed file.
+    long end = header.header_size + header.nrecords*header.record_size;
+    fflush( file );
+    if( ftruncate( fileno( file ), end )!=0 )
+        return false;
+
+    // Rebuild the event index from the records.
+    index.clear();
+    fseek( file, header.header_size, SEEK_SET );
+    flat::FlatStepRecord rec;
+    for( uint64_t i=0; i<header.nrecords; i++ ){
+        if( fread( &rec, sizeof( rec ), 1, file )!=1 )
+            return false;
+        if( index.empty() || index.back().eventID!=rec.eventID ){
+            flat::FlatEventEntry e = { rec.eventID, i, 0 };
+            index.push_back( e );
+        }
+        index.back().nrecords++;
+    }
+
+    setvbuf( file, 0, _IOFBF, 1<<22 );
+    fseek( file, end, SEEK_SET );
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteEvent( vector<StepInfo>& steps ){
+    WriteEventPart( steps, true, true );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteEventPart( vector<StepInfo>& steps, G4bool first, G4bool /*last*/ ){
+
+    if( file==0 || steps.empty() )
+        return;
+
+    records.resize( steps.size() );
+    for( size_t i=0; i<steps.size(); ++i ){
+        StepInfo& step = steps[i];
+        flat::FlatStepRecord& rec = records[i];
+        memset( &rec, 0, sizeof( rec ) );
+
+        rec.eventID = step.GetEventID();
+        rec.trackID = step.GetTrackID();
+        rec.stepID = step.GetStepID();
+        rec.parentID = step.GetParentID();
+        if( record_fields & StepFields::kCopyNumber )
+            rec.copy_n = step.GetVolumeCopyNumber();
+
+        if( record_fields & StepFields::kParticle )
+            strncpy( rec.particle, step.GetParticleName().c_str(), 15 );
+        if( record_fields & StepFields::kVolume )
+            strncpy( rec.volume, step.GetVolumeName().c_str(), 15 );
+        if( record_fields & StepFields::kProcess )
+            strncpy( rec.process, step.GetProcessName().c_str(), 15 );
+
+        GetKinematics( step, rec.kinematics, kinematics_enabled );
+    }
+
+    // Parts of an event follow each other, they share one index entry.
+    if( first || index.empty() || index.back().eventID!=records[0].eventID ){
+        flat::FlatEventEntry e = { records[0].eventID, header.nrecords, 0 };
+        index.push_back( e );
+    }
+    index.back().nrecords += records.size();
+
+    fwrite( &records[0], sizeof( flat::FlatStepRecord ), records.size(), file );
+    header.nrecords += records.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteText( G4String name, const vector<std::string>& lines ){
+
+    std::string text;
+    for( size_t i=0; i<lines.size(); i++ )
+        text += lines[i] + '\n';
+
+    for( size_t i=0; i<text_names.size(); i++ ){
+        if( text_names[i]==name ){
+            text_blocks[i] = text;
+            return;
+        }
+    }
+    text_names.push_back( name );
+    text_blocks.push_back( text );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::FillTable( G4String name, const vector<std::string>& columns, const vector<G4double>& row ){
+
+    if( file==0 )
+        return;
+
+    std::stringstream ss;
+    ss.precision( 10 );
+
+    FILE*& table = tables[name];
+    if( table==0 ){
+        table = fopen( GetTablePath( name ).c_str(), "w+b" );
+        if( table==0 ){
+            G4cerr << "Cannot open " << GetTablePath( name ) << ", the " << name << " table is not written." << G4endl;
+            tables.erase( name );
+            return;
+        }
+        for( size_t i=0; i<columns.size(); i++ )
+            ss << ( i ? "\t" : "" ) << columns[i];
+        ss << '\n';
+    }
+    for( size_t i=0; i<row.size(); i++ )
+        ss << ( i ? "\t" : "" ) << row[i];
+    ss << '\n';
+
+    const std::string text = ss.str();
+    fwrite( text.data(), 1, text.size(), table );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteTableList(){
+
+    // Written aside and renamed, so that a crash leaves the list of the previous checkpoint.
+    G4String path = GetTableListPath();
+    std::ofstream list( ( path+".tmp" ).c_str() );
+    for( std::map< std::string, FILE* >::iterator it=tables.begin(); it!=tables.end(); ++it ){
+        fflush( it->second );
+        list << it->first << '\t' << ftell( it->second ) << '\n';
+    }
+    list.close();
+    rename( ( path+".tmp" ).c_str(), path.c_str() );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool FlatSink::RecoverTables(){
+
+    // No list: no table had been written at the last checkpoint.
+    std::ifstream list( GetTableListPath().c_str() );
+    std::string name;
+    long size;
+    while( list >> name >> size ){
+        FILE* table = fopen( GetTablePath( name ).c_str(), "r+b" );
+        if( table==0 ){
+            G4cerr << "Table file " << GetTablePath( name ) << " of the checkpoint is missing." << G4endl;
+            return false;
+        }
+        fflush( table );
+        if( ftruncate( fileno( table ), size )!=0 ){
+            fclose( table );
+            return false;
+        }
+        fseek( table, size, SEEK_SET );
+        tables[name] = table;
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::CopyTable( const std::string& name, FILE* table ){
+
+    fflush( table );
+    fseek( table, 0, SEEK_END );
+    long size = ftell( table );
+    if( size<0 || uint64_t( size )>UINT32_MAX ){
+        // Too large for a text block, the table is left beside the output.
+        G4cerr << "The " << name << " table is too large for the flat file, it is kept in " << GetTablePath( name ) << G4endl;
+        fclose( table );
+        return;
+    }
+
+    uint32_t n = name.size();
+    fwrite( &n, sizeof( n ), 1, file );
+    fwrite( name.data(), 1, n, file );
+    n = size;
+    fwrite( &n, sizeof( n ), 1, file );
+
+    vector<char> buffer( 1<<20 );
+    fseek( table, 0, SEEK_SET );
+    size_t nread;
+    while( ( nread = fread( &buffer[0], 1, buffer.size(), table ) )>0 )
+        fwrite( &buffer[0], 1, nread, file );
+
+    fclose( table );
+    remove( GetTablePath( name ).c_str() );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteHistogram( G4String name, G4String title, G4double min, G4double max, const vector<G4double>& contents ){
+
+    // Title, then "min max nbins", then underflow, bins and overflow, one per line.
+    vector<std::string> lines;
+    lines.push_back( title );
+
+    std::stringstream ss;
+    ss << min << ' ' << max << ' ' << ( contents.size()>=2 ? contents.size()-2 : 0 );
+    lines.push_back( ss.str() );
+
+    for( size_t i=0; i<contents.size(); i++ ){
+        ss.str("");
+        ss << contents[i];
+        lines.push_back( ss.str() );
+    }
+    WriteText( name, lines );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::WriteHistogram2D( G4String name, G4String title, G4int nx, G4double xmin, G4double xmax,
+                                 G4int ny, G4double ymin, G4double ymax, const vector<G4double>& contents ){
+
+    // Title, "xmin xmax nx", "ymin ymax ny", then one line per y bin with the x bins,
+    // underflows and overflows included.
+    vector<std::string> lines;
+    lines.push_back( title );
+
+    std::stringstream ss;
+    ss << xmin << ' ' << xmax << ' ' << nx;
+    lines.push_back( ss.str() );
+    ss.str("");
+    ss << ymin << ' ' << ymax << ' ' << ny;
+    lines.push_back( ss.str() );
+
+    for( G4int iy=0; iy<ny+2; iy++ ){
+        ss.str("");
+        for( G4int ix=0; ix<nx+2; ix++ ){
+            size_t i = ix + size_t( nx+2 )*iy;
+            ss << ( ix ? " " : "" ) << ( i<contents.size() ? contents[i] : 0. );
+        }
+        lines.push_back( ss.str() );
+    }
+    WriteText( name, lines );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::Checkpoint( G4int completed_events, const vector<std::string>& lines ){
+
+    if( file==0 )
+        return;
+
+    WriteText( "checkpoint", lines );
+    WriteTableList();
+
+    // Records first, then the header that makes them visible.
+    fflush( file );
+    header.completed_events = completed_events;
+    WriteHeader();
+    fflush( file );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FlatSink::Close(){
+
+    if( file==0 )
+        return;
+
+    fseek( file, 0, SEEK_END );
+
+    header.index_offset = ftell( file );
+    header.nindex = index.size();
+    if( !index.empty() )
+        fwrite( &index[0], sizeof( flat::FlatEventEntry ), index.size(), file );
+
+    header.text_offset = ftell( file );
+    for( size_t i=0; i<text_names.size(); i++ ){
+        uint32_t n = text_names[i].size();
+        fwrite( &n, sizeof( n ), 1, file );
+        fwrite( text_names[i].data(), 1, n, file );
+        n = text_blocks[i].size();
+        fwrite( &n, sizeof( n ), 1, file );
+        fwrite( text_blocks[i].data(), 1, n, file );
+    }
+    for( std::map< std::string, FILE* >::iterator it=tables.begin(); it!=tables.end(); ++it )
+        CopyTable( it->first, it->second );
+    tables.clear();
+    remove( GetTableListPath().c_str() );
+    header.text_size = ftell( file ) - header.text_offset;
+
+    WriteHeader();
+    fclose( file );
+    file = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -4,29 +4,74 @@
 
 #include "GeneratorAction.hh"
 #include "GeneratorMessenger.hh"
+#include "ResponseMatrix.hh"
+#include "AlphaSource.hh"
+#include "DecaySource.hh"
 
 #include "G4RunManager.hh"
+#include "G4Run.hh"
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4GeneralParticleSource.hh"
+#include "G4SingleParticleSource.hh"
+#include "G4SPSEneDistribution.hh"
+#include "G4SPSPosDistribution.hh"
+#include "G4SPSAngDistribution.hh"
+#include "G4Gamma.hh"
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
 #include "G4ThreeVector.hh"
 #include "G4RandomDirection.hh"
 #include "G4IonTable.hh"
 
+#include <stdint.h>
+#include <sstream>
+#include <iomanip>
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+namespace {
+
+    // SplitMix64 finalizer, used to turn (seeds, run, event) into well-separated engine seeds.
+    inline uint64_t Mix64( uint64_t x ){
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+}
+
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 
-GeneratorAction::GeneratorAction() : G4VUserPrimaryGeneratorAction() {
+GeneratorAction::GeneratorAction() : G4VUserPrimaryGeneratorAction(),
+    generator_mode( "gps" ),
+    primaries_per_event( 1 ),
+    event_primaries( 1 ),
+    replay_event( -1 ),
+    replay_run( -1 ),
+    first_event_id( 0 ),
+    response_matrix( 0 )
+{
     //fParticleSource = new G4ParticleGun();
     fgps = new G4GeneralParticleSource();
         // GPS must be initialized here.
+    alpha_source = new AlphaSource();
+    decay_source = new DecaySource();
 
     primaryGeneratorMessenger = new GeneratorMessenger(this);
+
+    master_seeds[0] = 0;
+    master_seeds[1] = 0;
 }
 
 
@@ -35,6 +80,8 @@ GeneratorAction::GeneratorAction() : G4VUserPrimaryGeneratorAction() {
 
 GeneratorAction::~GeneratorAction(){
     //delete fParticleSource;
+    delete alpha_source;
+    delete decay_source;
     delete primaryGeneratorMessenger;
 }
 
@@ -42,6 +89,191 @@ GeneratorAction::~GeneratorAction(){
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 
+void GeneratorAction::SetMasterSeeds( long seeds[], int len ){
+    for( int i=0; i<2 && i<len; i++ )
+        master_seeds[i] = seeds[i];
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+void GeneratorAction::SetReplayEvent( G4int evt, G4int run ){
+    replay_event = evt;
+    replay_run = run;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+void GeneratorAction::ReseedForEvent( G4int runID, G4int eventID ){
+
+    uint64_t h = Mix64( uint64_t(master_seeds[0]) );
+    h = Mix64( h ^ uint64_t(master_seeds[1]) );
+    h = Mix64( h ^ uint64_t(uint32_t(runID)) );
+    h = Mix64( h ^ uint64_t(uint32_t(eventID)) );
+
+    // RanecuEngine takes two positive seeds below its moduli.
+    long seeds[3];
+    seeds[0] = long( (h & 0xffffffffULL) % 2147483562ULL ) + 1;
+    seeds[1] = long( (h >> 32) % 2147483398ULL ) + 1;
+    seeds[2] = 0;
+
+    G4Random::setTheSeeds( seeds );
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
 void GeneratorAction::GeneratePrimaries(G4Event* anEvent){
-    fgps->GeneratePrimaryVertex(anEvent);
+
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    G4int runID = runManager->GetCurrentRun()->GetRunID();
+
+    if( replay_event>=0 ){
+        // Take over the identity of the requested event and stop the run after it.
+        anEvent->SetEventID( replay_event );
+        if( replay_run>=0 )
+            runID = replay_run;
+
+        G4EventManager::GetEventManager()->GetTrackingManager()->SetVerboseLevel( 1 );
+        runManager->AbortRun( true );
+
+        G4cout << "Replaying event " << replay_event << " of run " << runID << G4endl;
+    }
+    else if( first_event_id>0 ){
+        // Resumed run: continue the numbering and stop once the original number of events is done.
+        G4int nevents = runManager->GetCurrentRun()->GetNumberOfEventToBeProcessed();
+        anEvent->SetEventID( anEvent->GetEventID() + first_event_id );
+
+        if( anEvent->GetEventID() >= nevents-1 )
+            runManager->AbortRun( true );
+
+        if( anEvent->GetEventID() >= nevents ){
+            G4cout << "All " << nevents << " events were already completed." << G4endl;
+            return;
+        }
+    }
+
+    ReseedForEvent( runID, anEvent->GetEventID() );
+
+    event_primaries = 1;
+    primary_tags.clear();
+
+    if( decay_source->IsTabulating() ){
+        decay_source->GeneratePrimaryVertex( anEvent );
+        return;
+    }
+
+    if( response_matrix!=0 && response_matrix->IsActive() ){
+        // Photon of the sweep energy from the GPS position and direction distributions.
+        // The particle and energy of the macro are restored right after.
+        G4SingleParticleSource* source = fgps->GetCurrentSource();
+        G4SPSEneDistribution* energy = source->GetEneDist();
+
+        G4ParticleDefinition* particle = source->GetParticleDefinition();
+        G4String type = energy->GetEnergyDisType();
+        G4double mono = energy->GetMonoEnergy();
+
+        source->SetParticleDefinition( G4Gamma::Definition() );
+        energy->SetEnergyDisType( "Mono" );
+        energy->SetMonoEnergy( response_matrix->GetIncidentEnergy( anEvent->GetEventID() ) );
+
+        fgps->GeneratePrimaryVertex( anEvent );
+
+        source->SetParticleDefinition( particle );
+        energy->SetEnergyDisType( type );
+        energy->SetMonoEnergy( mono );
+        return;
+    }
+
+    if( generator_mode=="alpha" && alpha_source->IsEmpty() ){
+        G4cerr << "No alpha line is defined, use /generator/alpha/nuclide or /generator/alpha/line." << G4endl;
+        runManager->AbortRun( true );
+        return;
+    }
+
+    if( generator_mode=="decay" && decay_source->IsEmpty() ){
+        G4cerr << "No decay table is loaded, use /generator/decay/nuclide or /generator/decay/file." << G4endl;
+        runManager->AbortRun( true );
+        return;
+    }
+
+    // Independent primaries one after the other.
+    event_primaries = primaries_per_event;
+    vertex_end.resize( primaries_per_event );
+
+    for( G4int k=0; k<primaries_per_event; k++ ){
+        if( generator_mode=="alpha" )
+            alpha_source->GeneratePrimaryVertex( anEvent );
+        else if( generator_mode=="decay" )
+            decay_source->GeneratePrimaryVertex( anEvent );
+        else
+            fgps->GeneratePrimaryVertex( anEvent );
+        vertex_end[k] = anEvent->GetNumberOfPrimaryVertex();
+    }
+
+    // Tag the primary particles, in the order in which they get their track IDs.
+    if( primaries_per_event>1 ){
+        G4int k = 0;
+        G4int v = 0;
+        for( G4PrimaryVertex* vertex = anEvent->GetPrimaryVertex(); vertex!=0; vertex = vertex->GetNext(), v++ ){
+            while( v>=vertex_end[k] )
+                k++;
+            for( G4int i=0; i<vertex->GetNumberOfParticle(); i++ )
+                primary_tags.push_back( k );
+        }
+    }
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+std::vector<std::string> GeneratorAction::DescribeSource() const {
+
+    std::vector<std::string> lines;
+    std::stringstream ss;
+    ss << std::setprecision( 12 );
+
+    G4SingleParticleSource* source = fgps->GetCurrentSource();
+    G4SPSPosDistribution* pos = source->GetPosDist();
+    G4SPSAngDistribution* ang = source->GetAngDist();
+
+    ss << "gps sources " << fgps->GetNumberofSource() << " particle "
+       << ( source->GetParticleDefinition() ? source->GetParticleDefinition()->GetParticleName() : G4String( "none" ) );
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "gps position " << pos->GetPosDisType() << ' ' << pos->GetPosDisShape() << ' ' << pos->GetCentreCoords()
+       << ' ' << pos->GetRotx() << ' ' << pos->GetRoty() << ' ' << pos->GetRotz()
+       << ' ' << pos->GetHalfX() << ' ' << pos->GetHalfY() << ' ' << pos->GetHalfZ() << ' ' << pos->GetRadius();
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "gps direction " << ang->GetDistType() << ' ' << ang->GetDirection();
+    lines.push_back( ss.str() );
+
+    // The angular limits, beam spreads and histograms have no getters: the same sample
+    // of points and directions is drawn from fixed seeds, with the engine state restored.
+    std::stringstream state;
+    G4Random::getTheEngine()->put( state );
+
+    long seeds[3] = { 12345, 67890, 0 };
+    G4Random::setTheSeeds( seeds );
+
+    ss << std::setprecision( 6 );
+    for( G4int i=0; i<64; i++ ){
+        G4ThreeVector position = pos->GenerateOne();
+        G4ThreeVector direction = ang->GenerateOne();
+        ss.str("");
+        ss << "gps sample " << position << ' ' << direction;
+        lines.push_back( ss.str() );
+    }
+
+    G4Random::getTheEngine()->get( state );
+
+    return lines;
 }
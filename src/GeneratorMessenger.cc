@@ -6,76 +6,311 @@
 #include "GeneratorMessenger.hh"
 
 #include "GeneratorAction.hh"
+#include "AlphaSource.hh"
+#include "DecaySource.hh"
 #include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWith3Vector.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include <sstream>
 
 GeneratorMessenger::GeneratorMessenger( GeneratorAction* generator )
   : G4UImessenger(),
     primaryGenerator(generator),
     primaryGeneratorDir(0)
 {
-/*
-	primaryGeneratorDir = new G4UIdirectory("/generator/");
-	primaryGeneratorDir->SetGuidance("Generator position control.");
-
-	generatorDistanceCmd = new G4UIcmdWithADouble("/generator/setDistance", this);
-	generatorDistanceCmd->SetGuidance("Set distance between the target helium and  generator in unit of cm");
-	generatorDistanceCmd->SetParameterName("distance", false);
-	generatorDistanceCmd->SetDefaultValue(60);
-	generatorDistanceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-
-  generatorAngleCmd = new G4UIcmdWithADouble("/generator/setAngle", this);
-  generatorAngleCmd->SetGuidance("Set azimuth angle of the generator");
-	generatorAngleCmd->SetParameterName("pmt_angle", false);
-	generatorAngleCmd->SetDefaultValue(45);
-	generatorAngleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-
-  generatorModeCmd = new G4UIcmdWithAString("/generator/setMode", this);
-  generatorModeCmd->SetGuidance("Select gammas or neutrons");
-  generatorModeCmd->SetParameterName("mode", true);
-  generatorModeCmd->SetDefaultValue("neutrons");
-  generatorModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
-*/
+    primaryGeneratorDir = new G4UIdirectory( "/generator/" );
+    primaryGeneratorDir->SetGuidance( "Primary generator control." );
+
+    generatorModeCmd = new G4UIcmdWithAString( "/generator/mode", this );
+    generatorModeCmd->SetGuidance( "Source of the primaries: gps for the general particle source (default)," );
+    generatorModeCmd->SetGuidance( "alpha for the tabulated alpha source of the /generator/alpha/ commands," );
+    generatorModeCmd->SetGuidance( "decay for the tabulated radioactive source of the /generator/decay/ commands." );
+    generatorModeCmd->SetParameterName( "mode", false );
+    generatorModeCmd->SetCandidates( "gps alpha decay" );
+    generatorModeCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    primariesCmd = new G4UIcmdWithAnInteger( "/generator/primaries", this );
+    primariesCmd->SetGuidance( "Number of independent primaries generated in every event (default 1)." );
+    primariesCmd->SetGuidance( "The fixed cost of an event is shared by all of them. Every track is tagged with the primary" );
+    primariesCmd->SetGuidance( "it descends from, the trigger decides for each primary on its own, and each primary is" );
+    primariesCmd->SetGuidance( "written as a separate event numbered event*N+index. Events are never spilled to disk." );
+    primariesCmd->SetGuidance( "The rows of the xrays table carry the same numbers, and primaries without recorded steps are not written." );
+    primariesCmd->SetParameterName( "N", false );
+    primariesCmd->SetRange( "N>0" );
+    primariesCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaDir = new G4UIdirectory( "/generator/alpha/" );
+    alphaDir->SetGuidance( "Alpha source of tabulated lines on a disk." );
+
+    alphaNuclideCmd = new G4UIcommand( "/generator/alpha/nuclide", this );
+    alphaNuclideCmd->SetGuidance( "Add the alpha lines of a nuclide, with its activity relative to the other lines." );
+    alphaNuclideCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "nuclide", 's', false );
+    param->SetParameterCandidates( "Am241 Po210 Cm244" );
+    alphaNuclideCmd->SetParameter( param );
+    param = new G4UIparameter( "activity", 'd', true );
+    param->SetDefaultValue( 1. );
+    param->SetParameterRange( "activity>0" );
+    alphaNuclideCmd->SetParameter( param );
+
+    alphaLineCmd = new G4UIcommand( "/generator/alpha/line", this );
+    alphaLineCmd->SetGuidance( "Add an alpha line: energy, intensity relative to the other lines and energy unit." );
+    alphaLineCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    param = new G4UIparameter( "energy", 'd', false );
+    param->SetParameterRange( "energy>0" );
+    alphaLineCmd->SetParameter( param );
+    param = new G4UIparameter( "intensity", 'd', false );
+    param->SetParameterRange( "intensity>0" );
+    alphaLineCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "MeV" );
+    alphaLineCmd->SetParameter( param );
+
+    alphaClearCmd = new G4UIcmdWithoutParameter( "/generator/alpha/clear", this );
+    alphaClearCmd->SetGuidance( "Remove all alpha lines." );
+    alphaClearCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaEncapsulationCmd = new G4UIcommand( "/generator/alpha/encapsulation", this );
+    alphaEncapsulationCmd->SetGuidance( "Energy lost in the encapsulation of the source: mean loss, Gaussian straggling sigma" );
+    alphaEncapsulationCmd->SetGuidance( "and length of the exponential low-energy tail (default all 0)." );
+    alphaEncapsulationCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    const char* names[] = { "loss", "sigma", "tail" };
+    for( int i=0; i<3; i++ ){
+        param = new G4UIparameter( names[i], 'd', false );
+        param->SetParameterRange( G4String( names[i] )+">=0" );
+        alphaEncapsulationCmd->SetParameter( param );
+    }
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    alphaEncapsulationCmd->SetParameter( param );
+
+    alphaPositionCmd = new G4UIcmdWith3VectorAndUnit( "/generator/alpha/position", this );
+    alphaPositionCmd->SetGuidance( "Center of the source disk." );
+    alphaPositionCmd->SetParameterName( "x", "y", "z", false );
+    alphaPositionCmd->SetDefaultUnit( "cm" );
+    alphaPositionCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaRadiusCmd = new G4UIcmdWithADoubleAndUnit( "/generator/alpha/radius", this );
+    alphaRadiusCmd->SetGuidance( "Radius of the source disk (default 0, a point source)." );
+    alphaRadiusCmd->SetParameterName( "radius", false );
+    alphaRadiusCmd->SetRange( "radius>=0" );
+    alphaRadiusCmd->SetDefaultUnit( "mm" );
+    alphaRadiusCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaAxisCmd = new G4UIcmdWith3Vector( "/generator/alpha/axis", this );
+    alphaAxisCmd->SetGuidance( "Normal of the source disk, the alphas are emitted around it (default 0 0 1)." );
+    alphaAxisCmd->SetParameterName( "x", "y", "z", false );
+    alphaAxisCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaMaxThetaCmd = new G4UIcmdWithADoubleAndUnit( "/generator/alpha/maxTheta", this );
+    alphaMaxThetaCmd->SetGuidance( "Largest angle of emission to the axis (default 90 deg)." );
+    alphaMaxThetaCmd->SetParameterName( "theta", false );
+    alphaMaxThetaCmd->SetRange( "theta>0" );
+    alphaMaxThetaCmd->SetDefaultUnit( "deg" );
+    alphaMaxThetaCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaAngularCmd = new G4UIcmdWithAString( "/generator/alpha/angular", this );
+    alphaAngularCmd->SetGuidance( "Angular distribution: iso (default) or cosine law." );
+    alphaAngularCmd->SetParameterName( "type", false );
+    alphaAngularCmd->SetCandidates( "iso cosine" );
+    alphaAngularCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    alphaPrintCmd = new G4UIcmdWithoutParameter( "/generator/alpha/print", this );
+    alphaPrintCmd->SetGuidance( "Print the lines and the geometry of the alpha source." );
+    alphaPrintCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayDir = new G4UIdirectory( "/generator/decay/" );
+    decayDir->SetGuidance( "Radioactive source sampled from a table of decays." );
+
+    decayNuclideCmd = new G4UIcmdWithAString( "/generator/decay/nuclide", this );
+    decayNuclideCmd->SetGuidance( "Nuclide of the source, e.g. Cs137. Its decay table is read from the cache directory," );
+    decayNuclideCmd->SetGuidance( "or tabulated with a run of decays of the nucleus at rest if it is not there." );
+    decayNuclideCmd->SetGuidance( "The physics list must include radioactive decay for the tabulation only." );
+    decayNuclideCmd->SetParameterName( "nuclide", false );
+    decayNuclideCmd->AvailableForStates( G4State_Idle );
+
+    decayChainCmd = new G4UIcmdWithABool( "/generator/decay/chain", this );
+    decayChainCmd->SetGuidance( "Include the decays of the daughters down to a stable nucleus in every decay (default false)." );
+    decayChainCmd->SetGuidance( "Excited daughters are always included." );
+    decayChainCmd->SetParameterName( "chain", true );
+    decayChainCmd->SetDefaultValue( true );
+    decayChainCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayDecaysCmd = new G4UIcmdWithAnInteger( "/generator/decay/decays", this );
+    decayDecaysCmd->SetGuidance( "Number of decays of a tabulation (default 100000)." );
+    decayDecaysCmd->SetParameterName( "n", false );
+    decayDecaysCmd->SetRange( "n>0" );
+    decayDecaysCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayCacheCmd = new G4UIcmdWithAString( "/generator/decay/cache", this );
+    decayCacheCmd->SetGuidance( "Directory of the decay tables (default decay_cache)." );
+    decayCacheCmd->SetParameterName( "dir", false );
+    decayCacheCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayFileCmd = new G4UIcmdWithAString( "/generator/decay/file", this );
+    decayFileCmd->SetGuidance( "Read a decay table from a file." );
+    decayFileCmd->SetParameterName( "file", false );
+    decayFileCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayPositionCmd = new G4UIcmdWith3VectorAndUnit( "/generator/decay/position", this );
+    decayPositionCmd->SetGuidance( "Center of the source disk." );
+    decayPositionCmd->SetParameterName( "x", "y", "z", false );
+    decayPositionCmd->SetDefaultUnit( "cm" );
+    decayPositionCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayRadiusCmd = new G4UIcmdWithADoubleAndUnit( "/generator/decay/radius", this );
+    decayRadiusCmd->SetGuidance( "Radius of the source disk (default 0, a point source)." );
+    decayRadiusCmd->SetParameterName( "radius", false );
+    decayRadiusCmd->SetRange( "radius>=0" );
+    decayRadiusCmd->SetDefaultUnit( "mm" );
+    decayRadiusCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayAxisCmd = new G4UIcmdWith3Vector( "/generator/decay/axis", this );
+    decayAxisCmd->SetGuidance( "Normal of the source disk (default 0 0 1)." );
+    decayAxisCmd->SetParameterName( "x", "y", "z", false );
+    decayAxisCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    decayPrintCmd = new G4UIcmdWithoutParameter( "/generator/decay/print", this );
+    decayPrintCmd->SetGuidance( "Print the particles emitted per decay and the geometry of the source." );
+    decayPrintCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
 
 GeneratorMessenger::~GeneratorMessenger(){
-/*
-    delete generatorDistanceCmd;
     delete generatorModeCmd;
+    delete primariesCmd;
+    delete alphaNuclideCmd;
+    delete alphaLineCmd;
+    delete alphaClearCmd;
+    delete alphaEncapsulationCmd;
+    delete alphaPositionCmd;
+    delete alphaRadiusCmd;
+    delete alphaAxisCmd;
+    delete alphaMaxThetaCmd;
+    delete alphaAngularCmd;
+    delete alphaPrintCmd;
+    delete alphaDir;
+    delete decayNuclideCmd;
+    delete decayChainCmd;
+    delete decayDecaysCmd;
+    delete decayCacheCmd;
+    delete decayFileCmd;
+    delete decayPositionCmd;
+    delete decayRadiusCmd;
+    delete decayAxisCmd;
+    delete decayPrintCmd;
+    delete decayDir;
     delete primaryGeneratorDir;
-*/
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
 
 void GeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newValue){
-/*
-	if( command == generatorDistanceCmd )
-	{
-		G4cout << "Setting generator distance to " << newValue << G4endl;
-		primaryGenerator->setGeneratorDistance(generatorDistanceCmd->GetNewDoubleValue(newValue));
-	}
-
-  if( command == generatorAngleCmd )
-  {
-    G4cout << "Setting generator azimuth angle to " << newValue << G4endl;
-    primaryGenerator->setGeneratorAngle(generatorAngleCmd->GetNewDoubleValue(newValue));
-  }
-
-  if( command == generatorModeCmd )
-  {
-    if(newValue != "gammas" && newValue != "neutrons")
-    {
-      G4cout << "\n ERROR! Bad generator mode definition: " << newValue << G4endl;
-      return;
-    }
-    G4cout << "Setting generator mode to " << newValue << G4endl;
-    primaryGenerator->SetGeneratorMode(newValue);
-  }
-*/
+
+    AlphaSource* alpha = primaryGenerator->GetAlphaSource();
+    DecaySource* decay = primaryGenerator->GetDecaySource();
+
+    if( command==generatorModeCmd ){
+        G4cout << "Setting generator mode to " << newValue << G4endl;
+        primaryGenerator->SetGeneratorMode( newValue );
+    }
+    else if( command==primariesCmd ){
+        primaryGenerator->SetPrimariesPerEvent( primariesCmd->GetNewIntValue( newValue ) );
+    }
+    else if( command==alphaNuclideCmd ){
+        std::istringstream is( newValue );
+        G4String nuclide;
+        G4double activity;
+        is >> nuclide >> activity;
+        if( !alpha->AddNuclide( nuclide, activity ) )
+            G4cerr << "/generator/alpha/nuclide: no alpha line is known for " << nuclide << G4endl;
+    }
+    else if( command==alphaLineCmd ){
+        std::istringstream is( newValue );
+        G4double energy, intensity;
+        G4String unit;
+        is >> energy >> intensity >> unit;
+        alpha->AddLine( energy*G4UIcommand::ValueOf( unit ), intensity );
+    }
+    else if( command==alphaClearCmd ){
+        alpha->Clear();
+    }
+    else if( command==alphaEncapsulationCmd ){
+        std::istringstream is( newValue );
+        G4double loss, sigma, tail;
+        G4String unit;
+        is >> loss >> sigma >> tail >> unit;
+        G4double u = G4UIcommand::ValueOf( unit );
+        alpha->SetEncapsulation( loss*u, sigma*u, tail*u );
+    }
+    else if( command==alphaPositionCmd ){
+        alpha->SetPosition( alphaPositionCmd->GetNew3VectorValue( newValue ) );
+    }
+    else if( command==alphaRadiusCmd ){
+        alpha->SetRadius( alphaRadiusCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==alphaAxisCmd ){
+        G4ThreeVector axis = alphaAxisCmd->GetNew3VectorValue( newValue );
+        if( axis.mag()==0 ){
+            G4cerr << "/generator/alpha/axis: the axis cannot be zero." << G4endl;
+            return;
+        }
+        alpha->SetAxis( axis );
+    }
+    else if( command==alphaMaxThetaCmd ){
+        alpha->SetMaxTheta( alphaMaxThetaCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==alphaAngularCmd ){
+        alpha->SetCosineLaw( newValue=="cosine" );
+    }
+    else if( command==alphaPrintCmd ){
+        alpha->Print();
+    }
+    else if( command==decayNuclideCmd ){
+        decay->SetNuclide( newValue );
+    }
+    else if( command==decayChainCmd ){
+        decay->SetChain( decayChainCmd->GetNewBoolValue( newValue ) );
+    }
+    else if( command==decayDecaysCmd ){
+        decay->SetDecays( decayDecaysCmd->GetNewIntValue( newValue ) );
+    }
+    else if( command==decayCacheCmd ){
+        decay->SetCacheDirectory( newValue );
+    }
+    else if( command==decayFileCmd ){
+        decay->ReadTable( newValue );
+    }
+    else if( command==decayPositionCmd ){
+        decay->SetPosition( decayPositionCmd->GetNew3VectorValue( newValue ) );
+    }
+    else if( command==decayRadiusCmd ){
+        decay->SetRadius( decayRadiusCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==decayAxisCmd ){
+        G4ThreeVector axis = decayAxisCmd->GetNew3VectorValue( newValue );
+        if( axis.mag()==0 ){
+            G4cerr << "/generator/decay/axis: the axis cannot be zero." << G4endl;
+            return;
+        }
+        decay->SetAxis( axis );
+    }
+    else if( command==decayPrintCmd ){
+        decay->Print();
+    }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
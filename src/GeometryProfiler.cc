@@ -0,0 +1,384 @@
+/// \file GeometryProfiler.cc
+/// \brief Implementation of the GeometryProfiler class
+
+#include "GeometryProfiler.hh"
+#include "ProfiledSolid.hh"
+#include "ProfiledNavigator.hh"
+#include "OutputSink.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4TransportationManager.hh"
+#include "G4SmartVoxelHeader.hh"
+#include "G4SmartVoxelProxy.hh"
+#include "G4SmartVoxelNode.hh"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace{
+
+    const char* query_names[GeometryProfiler::kNumQueries] = { "ComputeStep", "ComputeSafety", "Locate" };
+
+    const char* axis_names[] = { "x", "y", "z", "rho", "rad", "phi", "none" };
+
+    G4bool IsBoolean( const G4String& type ){
+        return type=="G4SubtractionSolid" || type=="G4UnionSolid" || type=="G4IntersectionSolid" || type=="G4MultiUnion";
+    }
+
+    // A volume with more daughters per voxel than this is worth restructuring.
+    const G4int kManyCandidates = 8;
+
+    // Share of the solid time from which a Boolean solid is reported.
+    const G4double kBooleanShare = 0.05;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GeometryProfiler::GeometryProfiler() :
+    installed( false ),
+    active( false ),
+    sink( 0 ),
+    timer_overhead( 0 )
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GeometryProfiler::~GeometryProfiler(){
+    active = false;
+    for( unsigned int i=0; i<wrapped.size(); i++ ){
+        wrapped[i].first->SetSolid( wrapped[i].second->GetSolid() );
+        delete wrapped[i].second;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryProfiler::InstallNavigator(){
+
+    if( installed )
+        return;
+
+    // The navigator replaced is left alone, other services may still point to it.
+    G4TransportationManager::GetTransportationManager()->SetNavigatorForTracking( new ProfiledNavigator( this ) );
+    installed = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryProfiler::MeasureTimerOverhead(){
+
+    // Smallest of a few estimates of the time between two consecutive readings.
+    const G4int n = 10000;
+    timer_overhead = DBL_MAX;
+
+    for( G4int k=0; k<5; k++ ){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point t = start;
+        for( G4int i=0; i<n; i++ )
+            t = std::chrono::steady_clock::now();
+        timer_overhead = std::min( timer_overhead, std::chrono::duration<double, std::nano>( t-start ).count()/n );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryProfiler::BeginOfRun(){
+
+    MeasureTimerOverhead();
+    navigation.clear();
+
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    for( unsigned int i=0; i<store->size(); i++ ){
+        G4LogicalVolume* lv = ( *store )[i];
+        if( lv->GetSolid()==0 || dynamic_cast<ProfiledSolid*>( lv->GetSolid() )!=0 )
+            continue;
+        ProfiledSolid* solid = new ProfiledSolid( lv->GetSolid() );
+        lv->SetSolid( solid );
+        wrapped.push_back( std::make_pair( lv, solid ) );
+    }
+
+    G4cout << "Profiling the geometry: " << wrapped.size() << " solids wrapped";
+    if( !installed )
+        G4cout << ", the navigator is not (it must be installed before the run manager is built)";
+    G4cout << ", timer overhead " << timer_overhead << " ns." << G4endl;
+
+    active = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryProfiler::AddNavigation( const G4LogicalVolume* lv, G4int query, const std::chrono::steady_clock::time_point& start,
+                                      long long first_solid_call ){
+
+    G4double t = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now()-start ).count();
+
+    // Each solid call inside the query read the clock twice, the query once.
+    t -= ( 2*( ProfiledSolid::GetTotalCalls()-first_solid_call ) + 1 )*timer_overhead;
+
+    Queries& q = navigation[lv];
+    q.calls[query] += 1;
+    q.time[query] += t;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double GeometryProfiler::GetCalls( const ProfiledSolid* solid ) const {
+    G4double calls = 0;
+    for( G4int m=0; m<ProfiledSolid::kNumMethods; m++ )
+        calls += solid->GetCalls( m );
+    return calls;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double GeometryProfiler::GetTime( const ProfiledSolid* solid ) const {
+    G4double time = 0;
+    for( G4int m=0; m<ProfiledSolid::kNumMethods; m++ )
+        time += solid->GetTime( m );
+    return std::max( time - GetCalls( solid )*timer_overhead, 0. );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryProfiler::CountVoxels( const G4SmartVoxelHeader* header, Voxels& voxels ) const {
+
+    voxels.headers++;
+
+    // Equal neighbouring slices share their proxy, each slice is counted.
+    for( size_t i=0; i<header->GetNoSlices(); i++ ){
+        const G4SmartVoxelProxy* proxy = header->GetSlice( i );
+        if( proxy->IsHeader() ){
+            CountVoxels( proxy->GetHeader(), voxels );
+        }
+        else{
+            G4int n = proxy->GetNode()->GetNoContained();
+            voxels.nodes++;
+            voxels.candidates += n;
+            voxels.max_candidates = std::max( voxels.max_candidates, n );
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryProfiler::EndOfRun(){
+
+    if( !active )
+        return;
+
+    active = false;
+
+    // Solids, from the most expensive.
+    std::vector< std::pair<G4double, unsigned int> > order;
+    G4double total_time = 0;
+    G4double total_calls = 0;
+    for( unsigned int i=0; i<wrapped.size(); i++ ){
+        G4double t = GetTime( wrapped[i].second );
+        order.push_back( std::make_pair( t, i ) );
+        total_time += t;
+        total_calls += GetCalls( wrapped[i].second );
+    }
+    std::sort( order.rbegin(), order.rend() );
+
+    G4cout << "Geometry profile, " << total_calls << " solid calls in " << total_time*1e-6 << " ms:" << G4endl;
+    G4cout << "    " << std::left << std::setw( 20 ) << "volume" << std::setw( 22 ) << "solid" << std::right
+           << std::setw( 12 ) << "calls" << std::setw( 12 ) << "ms" << std::setw( 10 ) << "ns/call" << std::setw( 8 ) << "share";
+    for( G4int m=0; m<ProfiledSolid::kNumMethods; m++ )
+        G4cout << std::setw( 20 ) << ProfiledSolid::method_names[m];
+    G4cout << G4endl;
+
+    std::vector<std::string> columns;
+    columns.push_back( "volume" );
+    columns.push_back( "calls" );
+    columns.push_back( "time_ns" );
+    for( G4int m=0; m<ProfiledSolid::kNumMethods; m++ )
+        columns.push_back( std::string( "calls_" ) + ProfiledSolid::method_names[m] );
+    for( G4int q=0; q<kNumQueries; q++ ){
+        columns.push_back( std::string( "calls_" ) + query_names[q] );
+        columns.push_back( std::string( "time_ns_" ) + query_names[q] );
+    }
+
+    std::vector<std::string> names;
+
+    for( unsigned int k=0; k<order.size(); k++ ){
+
+        const ProfiledSolid* solid = wrapped[order[k].second].second;
+        const G4LogicalVolume* lv = wrapped[order[k].second].first;
+        G4double calls = GetCalls( solid );
+        G4double time = order[k].first;
+
+        if( calls>0 ){
+            G4cout << "    " << std::left << std::setw( 20 ) << lv->GetName() << std::setw( 22 ) << solid->GetEntityType() << std::right
+                   << std::setw( 12 ) << calls << std::setw( 12 ) << time*1e-6 << std::setw( 10 ) << time/calls
+                   << std::setw( 8 ) << ( total_time>0 ? time/total_time : 0 );
+            for( G4int m=0; m<ProfiledSolid::kNumMethods; m++ )
+                G4cout << std::setw( 20 ) << solid->GetCalls( m );
+            G4cout << G4endl;
+        }
+
+        if( sink!=0 ){
+            std::vector<G4double> row;
+            row.push_back( names.size() );
+            row.push_back( calls );
+            row.push_back( time );
+            for( G4int m=0; m<ProfiledSolid::kNumMethods; m++ )
+                row.push_back( solid->GetCalls( m ) );
+            std::unordered_map<const G4LogicalVolume*, Queries>::const_iterator it = navigation.find( lv );
+            for( G4int q=0; q<kNumQueries; q++ ){
+                row.push_back( it!=navigation.end() ? it->second.calls[q] : 0 );
+                row.push_back( it!=navigation.end() ? it->second.time[q] : 0 );
+            }
+            sink->FillTable( "geometry_profile", columns, row );
+            names.push_back( lv->GetName() + " " + solid->GetEntityType() );
+        }
+    }
+
+    // Navigator queries, booked to the volume they were made in.
+    std::vector< std::pair<G4double, const G4LogicalVolume*> > nav_order;
+    G4double nav_time = 0;
+    for( std::unordered_map<const G4LogicalVolume*, Queries>::const_iterator it = navigation.begin(); it!=navigation.end(); it++ ){
+        G4double t = 0;
+        for( G4int q=0; q<kNumQueries; q++ )
+            t += it->second.time[q];
+        nav_order.push_back( std::make_pair( t, it->first ) );
+        nav_time += t;
+    }
+    std::sort( nav_order.rbegin(), nav_order.rend() );
+
+    if( !nav_order.empty() ){
+        G4cout << "    Navigator, " << nav_time*1e-6 << " ms:" << G4endl;
+        G4cout << "    " << std::left << std::setw( 20 ) << "volume" << std::right << std::setw( 12 ) << "ms" << std::setw( 8 ) << "share";
+        for( G4int q=0; q<kNumQueries; q++ )
+            G4cout << std::setw( 14 ) << query_names[q] << std::setw( 10 ) << "ns/call";
+        G4cout << G4endl;
+
+        for( unsigned int k=0; k<nav_order.size(); k++ ){
+            const Queries& q = navigation[nav_order[k].second];
+            G4cout << "    " << std::left << std::setw( 20 ) << ( nav_order[k].second!=0 ? nav_order[k].second->GetName() : G4String( "(outside)" ) )
+                   << std::right << std::setw( 12 ) << nav_order[k].first*1e-6 << std::setw( 8 ) << ( nav_time>0 ? nav_order[k].first/nav_time : 0 );
+            for( G4int i=0; i<kNumQueries; i++ )
+                G4cout << std::setw( 14 ) << q.calls[i] << std::setw( 10 ) << ( q.calls[i]>0 ? q.time[i]/q.calls[i] : 0 );
+            G4cout << G4endl;
+        }
+    }
+
+    std::vector<std::string> findings;
+
+    // Voxels of the volumes with daughters, the world first.
+    G4LogicalVolume* world = 0;
+    G4VPhysicalVolume* world_pv = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+    if( world_pv!=0 )
+        world = world_pv->GetLogicalVolume();
+
+    std::vector<G4LogicalVolume*> mothers;
+    if( world!=0 )
+        mothers.push_back( world );
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    for( unsigned int i=0; i<store->size(); i++ )
+        if( ( *store )[i]!=world && ( *store )[i]->GetNoDaughters()>1 )
+            mothers.push_back( ( *store )[i] );
+
+    G4cout << "    Smart voxels:" << G4endl;
+    for( unsigned int i=0; i<mothers.size(); i++ ){
+
+        G4LogicalVolume* lv = mothers[i];
+        G4int ndaughters = lv->GetNoDaughters();
+        const G4SmartVoxelHeader* header = lv->GetVoxelHeader();
+
+        std::stringstream ss;
+        ss << lv->GetName() << ", " << ndaughters << " daughters: ";
+
+        if( header==0 ){
+            ss << "not voxelised";
+            if( ndaughters>1 ){
+                std::stringstream f;
+                f << lv->GetName() << " holds " << ndaughters << " daughters without voxels: every step in it tests all of them.";
+                findings.push_back( f.str() );
+            }
+        }
+        else{
+            Voxels voxels;
+            CountVoxels( header, voxels );
+            G4int axis = std::min( G4int( header->GetAxis() ), 6 );
+            ss << header->GetNoSlices() << " slices along " << axis_names[axis] << ", " << voxels.headers << " headers, "
+               << voxels.nodes << " nodes, " << ( voxels.nodes>0 ? voxels.candidates/voxels.nodes : 0 )
+               << " daughters per node on average, " << voxels.max_candidates << " at most";
+
+            if( voxels.max_candidates>=kManyCandidates ){
+                std::stringstream f;
+                f << "Up to " << voxels.max_candidates << " of the " << ndaughters << " daughters of " << lv->GetName()
+                  << " share a voxel: grouping neighbouring daughters in mother volumes would cut the candidates tested per step.";
+                findings.push_back( f.str() );
+            }
+        }
+        G4cout << "        " << ss.str() << G4endl;
+    }
+
+    // Findings on the solids.
+    if( !order.empty() && total_time>0 ){
+
+        const ProfiledSolid* top = wrapped[order[0].second].second;
+        std::stringstream f;
+        f << wrapped[order[0].second].first->GetName() << " (" << top->GetEntityType() << ") takes "
+          << std::setprecision( 3 ) << 100*order[0].first/total_time << "% of the solid time";
+        if( order.size()>1 && order[1].first>0 )
+            f << ", followed by " << wrapped[order[1].second].first->GetName() << " with " << 100*order[1].first/total_time << "%";
+        f << ".";
+        findings.push_back( f.str() );
+
+        // Cost per call of the Boolean solids against the others.
+        G4double other_time = 0, other_calls = 0;
+        for( unsigned int k=0; k<wrapped.size(); k++ ){
+            if( !IsBoolean( wrapped[k].second->GetEntityType() ) ){
+                other_time += GetTime( wrapped[k].second );
+                other_calls += GetCalls( wrapped[k].second );
+            }
+        }
+
+        for( unsigned int k=0; k<order.size(); k++ ){
+            const ProfiledSolid* solid = wrapped[order[k].second].second;
+            G4double calls = GetCalls( solid );
+            if( !IsBoolean( solid->GetEntityType() ) || calls==0 || order[k].first<kBooleanShare*total_time )
+                continue;
+            std::stringstream b;
+            b << wrapped[order[k].second].first->GetName() << " is a " << solid->GetEntityType() << " taking "
+              << std::setprecision( 3 ) << 100*order[k].first/total_time << "% of the solid time at " << order[k].first/calls
+              << " ns per call";
+            if( other_calls>0 )
+                b << " against " << other_time/other_calls << " ns for the other solids";
+            b << ": an equivalent single solid, e.g. a polycone, would be cheaper.";
+            findings.push_back( b.str() );
+        }
+    }
+
+    if( !nav_order.empty() && nav_time>0 && nav_order[0].second!=0 ){
+        std::stringstream f;
+        f << "Steps in " << nav_order[0].second->GetName() << " take " << std::setprecision( 3 )
+          << 100*nav_order[0].first/nav_time << "% of the navigation time.";
+        findings.push_back( f.str() );
+    }
+
+    G4cout << "    Findings:" << G4endl;
+    for( unsigned int i=0; i<findings.size(); i++ )
+        G4cout << "        " << findings[i] << G4endl;
+
+    if( sink!=0 ){
+        sink->WriteText( "geometry_profile_volumes", names );
+        sink->WriteText( "geometry_findings", findings );
+    }
+    sink = 0;
+
+    // Back to the original solids.
+    for( unsigned int i=0; i<wrapped.size(); i++ ){
+        wrapped[i].first->SetSolid( wrapped[i].second->GetSolid() );
+        delete wrapped[i].second;
+    }
+    wrapped.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,92 @@
+/// \file OutputSink.cc
+/// \brief Implementation of the OutputSink class
+
+#include "OutputSink.hh"
+
+#include <fstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* OutputSink::kinematics_names[OutputSink::kNumKinematics] = {
+    "x", "y", "z", "theta", "phi",      // position of the post-step point
+    "px", "py", "pz",                   // momentum direction
+    "t",                                // global time
+    "Eki", "Ekf",                       // kinetic energy before and after the step
+    "Edep"                              // energy deposit calculated by Geant4
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputSink::WriteMacroFile( G4String path ){
+
+    vector<std::string> lines;
+    std::ifstream file( path.c_str() );
+    std::string line;
+    while( std::getline( file, line ) )
+        lines.push_back( line );
+
+    // Same naming as TMacro: file name without directory and extension.
+    std::string name = path;
+    size_t slash = name.rfind( '/' );
+    if( slash!=std::string::npos )
+        name = name.substr( slash+1 );
+    size_t dot = name.find( '.' );
+    if( dot!=std::string::npos )
+        name = name.substr( 0, dot );
+
+    WriteText( name, lines );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputSink::GetKinematics( StepInfo& step, double* values, const G4bool* enabled ){
+
+    if( enabled==0 || enabled[kX] || enabled[kY] || enabled[kZ] || enabled[kTheta] || enabled[kPhi] ){
+        G4ThreeVector position = step.GetPosition();
+        values[kX] = position.x();
+        values[kY] = position.y();
+        values[kZ] = position.z();
+        if( enabled==0 || enabled[kTheta] )
+            values[kTheta] = position.theta();
+        if( enabled==0 || enabled[kPhi] )
+            values[kPhi] = position.phi();
+    }
+
+    if( enabled==0 || enabled[kPx] || enabled[kPy] || enabled[kPz] ){
+        G4ThreeVector momentum = step.GetMomentumDirection();
+        values[kPx] = momentum.x();
+        values[kPy] = momentum.y();
+        values[kPz] = momentum.z();
+    }
+
+    if( enabled==0 || enabled[kT] )
+        values[kT] = step.GetGlobalTime();
+
+    if( enabled==0 || enabled[kEki] )
+        values[kEki] = step.GetEki();
+    if( enabled==0 || enabled[kEkf] )
+        values[kEkf] = step.GetEkf();
+    if( enabled==0 || enabled[kEdep] )
+        values[kEdep] = step.GetDepositedEnergy();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+unsigned OutputSink::GetKinematicsField( G4int k ){
+    switch( k ){
+        case kX: case kY: case kZ: case kTheta: case kPhi:
+            return StepFields::kPosition;
+        case kPx: case kPy: case kPz:
+            return StepFields::kDirection;
+        case kT:
+            return StepFields::kTime;
+        case kEki:
+            return StepFields::kEki;
+        case kEkf:
+            return StepFields::kEkf;
+        default:
+            return StepFields::kEdep;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,395 @@
+/// \file PointDetector.cc
+/// \brief Implementation of the PointDetector class
+
+#include "PointDetector.hh"
+#include "PointDetectorMessenger.hh"
+#include "OutputSink.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Material.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4EmCalculator.hh"
+#include "G4Gamma.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+const G4double PointDetector::table_emin = 1*keV;
+const G4double PointDetector::table_emax = 10*MeV;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PointDetector::PointDetector() :
+    messenger( 0 ),
+    exclusion_radius( 1*mm ),
+    nbins( 1000 ),
+    emin( 0 ),
+    emax( 100*keV ),
+    sink( 0 ),
+    navigator( 0 )
+{
+    SetVolumes( "target_* wheel" );
+    messenger = new PointDetectorMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PointDetector::~PointDetector(){
+    delete messenger;
+    delete navigator;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::AddPoint( G4ThreeVector pos, G4String name ){
+
+    if( name=="" ){
+        std::stringstream ss;
+        ss << "point_" << points.size();
+        name = ss.str();
+    }
+
+    Point p;
+    p.name = name;
+    p.position = pos;
+    p.event_score = 0;
+    p.sum = 0;
+    p.sum2 = 0;
+    p.contributions = 0;
+    points.push_back( p );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::Clear(){
+    points.clear();
+    scored.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::SetVolumes( G4String patterns ){
+
+    volume_patterns.clear();
+    is_source.clear();
+
+    std::istringstream is( patterns );
+    std::string pattern;
+    while( is >> pattern )
+        volume_patterns.push_back( pattern );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::SetHistogram( G4int n, G4double min, G4double max ){
+    nbins = n;
+    emin = min;
+    emax = max;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PointDetector::IsSource( const G4VPhysicalVolume* pv ){
+
+    std::unordered_map<const G4VPhysicalVolume*, G4bool>::const_iterator it = is_source.find( pv );
+    if( it!=is_source.end() )
+        return it->second;
+
+    const G4String& name = pv->GetName();
+    G4bool match = false;
+    for( size_t i=0; i<volume_patterns.size() && !match; i++ )
+        match = MatchesVolumePattern( volume_patterns[i], name );
+
+    is_source[pv] = match;
+    return match;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::BeginOfRun(){
+
+    sink = 0;
+    is_source.clear();
+    scored.clear();
+
+    for( size_t i=0; i<points.size(); i++ ){
+        points[i].event_score = 0;
+        points[i].sum = 0;
+        points[i].sum2 = 0;
+        points[i].contributions = 0;
+        points[i].spectrum.assign( nbins+2, 0. );
+    }
+
+    if( points.empty() )
+        return;
+
+    // A navigator of our own, so that the tracking is not disturbed.
+    if( navigator==0 )
+        navigator = new G4Navigator();
+    navigator->SetWorldVolume( G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume() );
+
+    // Attenuation coefficients of the materials of the geometry, from the cross
+    // sections of the processes of the physics list.
+    mu_table.clear();
+    G4EmCalculator calculator;
+    const char* processes[] = { "phot", "compt", "conv", "Rayl" };
+
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    for( size_t i=0; i<store->size(); i++ ){
+
+        const G4Material* material = (*store)[i]->GetMaterial();
+        if( material==0 || mu_table.find( material )!=mu_table.end() )
+            continue;
+
+        std::vector<G4double>& mu = mu_table[material];
+        mu.resize( ntable );
+        for( G4int j=0; j<ntable; j++ ){
+            G4double energy = table_emin*std::pow( table_emax/table_emin, G4double( j )/( ntable-1 ) );
+            mu[j] = 0;
+            for( G4int k=0; k<4; k++ )
+                mu[j] += calculator.ComputeCrossSectionPerVolume( energy, G4Gamma::Definition(), processes[k], material );
+        }
+    }
+
+    G4cout << "Point detectors: " << points.size() << " points, sources in";
+    for( size_t i=0; i<volume_patterns.size(); i++ )
+        G4cout << ' ' << volume_patterns[i];
+    G4cout << ", attenuation of " << mu_table.size() << " materials tabulated" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PointDetector::GetAttenuationCoefficient( const G4Material* material, G4double energy ){
+
+    std::map<const G4Material*, std::vector<G4double> >::const_iterator it = mu_table.find( material );
+    if( it==mu_table.end() )
+        return 0;
+
+    const std::vector<G4double>& mu = it->second;
+
+    // Linear interpolation on the logarithmic grid, constant outside of it.
+    G4double x = std::log( energy/table_emin )/std::log( table_emax/table_emin )*( ntable-1 );
+    if( x<=0 )
+        return mu[0];
+    if( x>=ntable-1 )
+        return mu[ntable-1];
+
+    G4int j = G4int( x );
+    G4double f = x-j;
+    return ( 1-f )*mu[j] + f*mu[j+1];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PointDetector::GetOpticalDepth( const G4ThreeVector& from, const G4ThreeVector& dir, G4double distance, G4double energy ){
+
+    G4double tau = 0;
+    G4ThreeVector pos = from;
+    G4double remaining = distance;
+
+    G4VPhysicalVolume* pv = navigator->LocateGlobalPointAndSetup( pos, &dir, false, false );
+
+    // Walk along the straight line, volume by volume. The loop is bounded in case
+    // the navigator gets stuck on a boundary.
+    for( G4int i=0; i<1000 && pv!=0 && remaining>0; i++ ){
+
+        G4double safety;
+        G4double step = std::min( navigator->ComputeStep( pos, dir, remaining, safety ), remaining );
+
+        tau += GetAttenuationCoefficient( pv->GetLogicalVolume()->GetMaterial(), energy )*step;
+        if( tau>50 )
+            break;
+
+        remaining -= step;
+        pos += step*dir;
+
+        navigator->SetGeometricallyLimitedStep();
+        pv = navigator->LocateGlobalPointAndSetup( pos, &dir, true );
+    }
+
+    return tau;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::Score( const G4ThreeVector& pos, const G4ThreeVector& dir, G4double energy, G4double weight, G4int type ){
+
+    for( size_t i=0; i<points.size(); i++ ){
+
+        Point& p = points[i];
+
+        G4ThreeVector d = p.position - pos;
+        G4double R = d.mag();
+        if( R>0 )
+            d /= R;
+
+        // Probability per steradian of going towards the point, and the energy then.
+        G4double e = energy;
+        G4double pdf = 1/( 4*pi );
+        G4double c = dir.dot( d );
+
+        if( type==1 ){
+            G4double k = energy/electron_mass_c2;
+            G4double eps = 1/( 1+k*( 1-c ) );
+            e = energy*eps;
+
+            // Klein-Nishina, normalised to the total cross section (Thomson at low energy).
+            G4double dsigma = 0.5*eps*eps*( eps + 1/eps - ( 1-c*c ) );
+            G4double sigma = 8*pi/3;
+            if( k>1e-4 ){
+                G4double l = std::log( 1+2*k );
+                sigma = 2*pi*( ( 1+k )/( k*k )*( 2*( 1+k )/( 1+2*k ) - l/k ) + l/( 2*k ) - ( 1+3*k )/( ( 1+2*k )*( 1+2*k ) ) );
+            }
+            pdf = dsigma/sigma;
+        }
+        else if( type==2 ){
+            pdf = 3/( 16*pi )*( 1+c*c );
+        }
+
+        G4double tau = GetOpticalDepth( pos, d, R, e );
+        if( tau>50 )
+            continue;
+
+        G4double r = std::max( R, exclusion_radius );
+        G4double score = weight*pdf*std::exp( -tau )/( r*r );
+        if( score<=0 )
+            continue;
+
+        if( p.event_score==0 )
+            scored.push_back( i );
+        p.event_score += score;
+        p.contributions += 1;
+
+        G4int bin = e<emin ? 0 : e>=emax ? nbins+1 : 1 + G4int( ( e-emin )/( emax-emin )*nbins );
+        p.spectrum[bin] += score;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::ProcessStep( const G4Step* step ){
+
+    if( points.empty() )
+        return;
+
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    if( pre->GetPhysicalVolume()==0 || !IsSource( pre->GetPhysicalVolume() ) )
+        return;
+
+    const G4ParticleDefinition* gamma = G4Gamma::Definition();
+
+    // Photons created in the step, emitted isotropically.
+    const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
+    if( secondaries!=0 ){
+        for( size_t i=0; i<secondaries->size(); i++ ){
+            const G4Track* photon = (*secondaries)[i];
+            if( photon->GetDefinition()==gamma )
+                Score( photon->GetPosition(), photon->GetMomentumDirection(), photon->GetKineticEnergy(), photon->GetWeight(), 0 );
+        }
+    }
+
+    // Scattering of the photon at the end of the step.
+    if( step->GetTrack()->GetDefinition()!=gamma )
+        return;
+
+    const G4StepPoint* post = step->GetPostStepPoint();
+    const G4VProcess* process = post->GetProcessDefinedStep();
+    if( process==0 )
+        return;
+
+    const G4String& name = process->GetProcessName();
+    if( name=="compt" )
+        Score( post->GetPosition(), pre->GetMomentumDirection(), pre->GetKineticEnergy(), pre->GetWeight(), 1 );
+    else if( name=="Rayl" )
+        Score( post->GetPosition(), pre->GetMomentumDirection(), pre->GetKineticEnergy(), pre->GetWeight(), 2 );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::EndOfEvent(){
+
+    for( size_t i=0; i<scored.size(); i++ ){
+        Point& p = points[ scored[i] ];
+        p.sum += p.event_score;
+        p.sum2 += p.event_score*p.event_score;
+        p.event_score = 0;
+    }
+    scored.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PointDetector::EndOfRun( G4int nevents, G4double primaries_per_event ){
+
+    if( points.empty() )
+        return;
+
+    G4cout << "Point detector fluence per primary (" << nevents << " events of " << primaries_per_event << " primaries):" << G4endl;
+
+    std::vector<std::string> columns;
+    const char* names[] = { "point", "x", "y", "z", "nevents", "sum", "sum2", "contributions", "fluence", "error", "primaries_per_event" };
+    columns.assign( names, names+11 );
+    std::vector<G4double> row( columns.size() );
+
+    for( size_t i=0; i<points.size(); i++ ){
+
+        const Point& p = points[i];
+
+        // Mean per event and its standard error, from the sums over events, then per primary:
+        // the primaries of an event are independent, so the events are too.
+        G4double mean = nevents>0 ? p.sum/nevents : 0;
+        G4double error = nevents>1 ? std::sqrt( std::max( p.sum2/nevents - mean*mean, 0. )/( nevents-1 ) ) : 0;
+        mean /= primaries_per_event;
+        error /= primaries_per_event;
+
+        G4cout << "    " << p.name << " at " << p.position/cm << " cm: "
+               << mean*cm2 << " +- " << error*cm2 << " /cm2";
+        if( mean>0 )
+            G4cout << " (" << 100*error/mean << "%)";
+        G4cout << ", " << p.contributions << " contributions" << G4endl;
+
+        if( sink==0 )
+            continue;
+
+        row[0] = i;
+        row[1] = p.position.x();
+        row[2] = p.position.y();
+        row[3] = p.position.z();
+        row[4] = nevents;
+        row[5] = p.sum;
+        row[6] = p.sum2;
+        row[7] = p.contributions;
+        row[8] = mean;
+        row[9] = error;
+        row[10] = primaries_per_event;
+        sink->FillTable( "point_detectors", columns, row );
+
+        G4String title = "Fluence at " + p.name + " summed over events;E (MeV);fluence (mm^{-2})";
+        sink->WriteHistogram( "point_" + p.name + "_E", title, emin, emax, p.spectrum );
+    }
+
+    // Names of the points of the table.
+    if( sink!=0 ){
+        std::vector<std::string> lines;
+        for( size_t i=0; i<points.size(); i++ ){
+            std::stringstream ss;
+            ss << "point " << i << ' ' << points[i].name;
+            lines.push_back( ss.str() );
+        }
+        sink->WriteText( "point_detector_names", lines );
+    }
+
+    sink = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
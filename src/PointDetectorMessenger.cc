@@ -0,0 +1,119 @@
+// $Id: PointDetectorMessenger.cc $
+//
+/// \file PointDetectorMessenger.cc
+/// \brief Definition of the PointDetectorMessenger class
+
+#include "PointDetectorMessenger.hh"
+#include "PointDetector.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+PointDetectorMessenger::PointDetectorMessenger( PointDetector* p ) : G4UImessenger(), estimator( p ){
+
+    directory = new G4UIdirectory( "/pointDetector/" );
+    directory->SetGuidance( "Next-event estimator of the photon fluence at points, e.g. at far-side detector positions." );
+    directory->SetGuidance( "Photons created or scattered in the source volumes score their probability of reaching each point." );
+
+    addCmd = new G4UIcommand( "/pointDetector/add", this );
+    addCmd->SetGuidance( "Add a point: x y z unit [name]." );
+    addCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    const char* axes[] = { "x", "y", "z" };
+    for( int i=0; i<3; i++ ){
+        G4UIparameter* param = new G4UIparameter( axes[i], 'd', false );
+        addCmd->SetParameter( param );
+    }
+    G4UIparameter* param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "cm" );
+    addCmd->SetParameter( param );
+    param = new G4UIparameter( "name", 's', true );
+    param->SetDefaultValue( "" );
+    addCmd->SetParameter( param );
+
+    clearCmd = new G4UIcmdWithoutParameter( "/pointDetector/clear", this );
+    clearCmd->SetGuidance( "Remove all points, which disables the estimator." );
+    clearCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    volumeCmd = new G4UIcmdWithAString( "/pointDetector/volume", this );
+    volumeCmd->SetGuidance( "Physical volume names of the sources, separated by spaces (default \"target_* wheel\")." );
+    volumeCmd->SetGuidance( "A trailing * matches any suffix." );
+    volumeCmd->SetParameterName( "volumes", false );
+    volumeCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    exclusionCmd = new G4UIcmdWithADoubleAndUnit( "/pointDetector/exclusionRadius", this );
+    exclusionCmd->SetGuidance( "Contributions from closer than this radius are scored at this radius (default 1 mm)." );
+    exclusionCmd->SetParameterName( "radius", false );
+    exclusionCmd->SetRange( "radius>=0" );
+    exclusionCmd->SetDefaultUnit( "mm" );
+    exclusionCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    histogramCmd = new G4UIcommand( "/pointDetector/histogram", this );
+    histogramCmd->SetGuidance( "Binning of the fluence spectra: number of bins, minimum and maximum energy." );
+    histogramCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    param = new G4UIparameter( "nbins", 'i', false );
+    param->SetParameterRange( "nbins>0" );
+    histogramCmd->SetParameter( param );
+    param = new G4UIparameter( "min", 'd', false );
+    histogramCmd->SetParameter( param );
+    param = new G4UIparameter( "max", 'd', false );
+    histogramCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    histogramCmd->SetParameter( param );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+PointDetectorMessenger::~PointDetectorMessenger(){
+    delete addCmd;
+    delete clearCmd;
+    delete volumeCmd;
+    delete exclusionCmd;
+    delete histogramCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void PointDetectorMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==addCmd ){
+        std::istringstream is( newValue );
+        G4double x, y, z;
+        G4String unit, name;
+        is >> x >> y >> z >> unit >> name;
+        G4double u = G4UIcommand::ValueOf( unit );
+        estimator->AddPoint( G4ThreeVector( x*u, y*u, z*u ), name );
+    }
+    else if( command==clearCmd ){
+        estimator->Clear();
+    }
+    else if( command==volumeCmd ){
+        estimator->SetVolumes( newValue );
+    }
+    else if( command==exclusionCmd ){
+        estimator->SetExclusionRadius( exclusionCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==histogramCmd ){
+        std::istringstream is( newValue );
+        G4int n;
+        G4double min, max;
+        G4String unit;
+        is >> n >> min >> max >> unit;
+        if( max<=min ){
+            G4cerr << "/pointDetector/histogram: max must be larger than min." << G4endl;
+            return;
+        }
+        estimator->SetHistogram( n, min*G4UIcommand::ValueOf( unit ), max*G4UIcommand::ValueOf( unit ) );
+    }
+    return;
+}
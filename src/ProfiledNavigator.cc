@@ -0,0 +1,76 @@
+/// \file ProfiledNavigator.cc
+/// \brief Implementation of the ProfiledNavigator class
+
+#include "ProfiledNavigator.hh"
+#include "GeometryProfiler.hh"
+#include "ProfiledSolid.hh"
+
+#include "G4VPhysicalVolume.hh"
+
+#include <chrono>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ProfiledNavigator::ProfiledNavigator( GeometryProfiler* p ) : G4Navigator(), profiler( p ){
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ProfiledNavigator::~ProfiledNavigator(){
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const G4LogicalVolume* ProfiledNavigator::GetCurrentVolume() const {
+    G4VPhysicalVolume* pv = fHistory.GetTopVolume();
+    return pv!=0 ? pv->GetLogicalVolume() : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledNavigator::ComputeStep( const G4ThreeVector& pGlobalPoint, const G4ThreeVector& pDirection,
+                                         const G4double pCurrentProposedStepLength, G4double& pNewSafety ){
+
+    if( !profiler->IsActive() )
+        return G4Navigator::ComputeStep( pGlobalPoint, pDirection, pCurrentProposedStepLength, pNewSafety );
+
+    const G4LogicalVolume* lv = GetCurrentVolume();
+    long long nested = ProfiledSolid::GetTotalCalls();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    G4double step = G4Navigator::ComputeStep( pGlobalPoint, pDirection, pCurrentProposedStepLength, pNewSafety );
+    profiler->AddNavigation( lv, GeometryProfiler::kComputeStep, start, nested );
+    return step;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledNavigator::ComputeSafety( const G4ThreeVector& globalPoint, const G4double pProposedMaxLength,
+                                           const G4bool keepState ){
+
+    if( !profiler->IsActive() )
+        return G4Navigator::ComputeSafety( globalPoint, pProposedMaxLength, keepState );
+
+    const G4LogicalVolume* lv = GetCurrentVolume();
+    long long nested = ProfiledSolid::GetTotalCalls();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    G4double safety = G4Navigator::ComputeSafety( globalPoint, pProposedMaxLength, keepState );
+    profiler->AddNavigation( lv, GeometryProfiler::kComputeSafety, start, nested );
+    return safety;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VPhysicalVolume* ProfiledNavigator::LocateGlobalPointAndSetup( const G4ThreeVector& point, const G4ThreeVector* direction,
+                                                                 const G4bool pRelativeSearch, const G4bool ignoreDirection ){
+
+    if( !profiler->IsActive() )
+        return G4Navigator::LocateGlobalPointAndSetup( point, direction, pRelativeSearch, ignoreDirection );
+
+    long long nested = ProfiledSolid::GetTotalCalls();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    G4VPhysicalVolume* pv = G4Navigator::LocateGlobalPointAndSetup( point, direction, pRelativeSearch, ignoreDirection );
+    profiler->AddNavigation( pv!=0 ? pv->GetLogicalVolume() : 0, GeometryProfiler::kLocate, start, nested );
+    return pv;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,194 @@
+/// \file ProfiledSolid.cc
+/// \brief Implementation of the ProfiledSolid class
+
+#include "ProfiledSolid.hh"
+
+#include "G4VisExtent.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* ProfiledSolid::method_names[ProfiledSolid::kNumMethods] = {
+    "Inside", "SurfaceNormal", "DistanceToIn(p,v)", "DistanceToIn(p)", "DistanceToOut(p,v)", "DistanceToOut(p)"
+};
+
+long long ProfiledSolid::total_calls = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ProfiledSolid::ProfiledSolid( G4VSolid* s ) : G4VSolid( s->GetName() ), solid( s ){
+    Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ProfiledSolid::~ProfiledSolid(){
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProfiledSolid::Reset(){
+    for( G4int i=0; i<kNumMethods; i++ ){
+        calls[i] = 0;
+        time[i] = 0;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EInside ProfiledSolid::Inside( const G4ThreeVector& p ) const {
+    Clock::time_point start = Clock::now();
+    EInside in = solid->Inside( p );
+    Count( kInside, start );
+    return in;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector ProfiledSolid::SurfaceNormal( const G4ThreeVector& p ) const {
+    Clock::time_point start = Clock::now();
+    G4ThreeVector n = solid->SurfaceNormal( p );
+    Count( kSurfaceNormal, start );
+    return n;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledSolid::DistanceToIn( const G4ThreeVector& p, const G4ThreeVector& v ) const {
+    Clock::time_point start = Clock::now();
+    G4double d = solid->DistanceToIn( p, v );
+    Count( kDistanceToInPV, start );
+    return d;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledSolid::DistanceToIn( const G4ThreeVector& p ) const {
+    Clock::time_point start = Clock::now();
+    G4double d = solid->DistanceToIn( p );
+    Count( kDistanceToInP, start );
+    return d;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledSolid::DistanceToOut( const G4ThreeVector& p, const G4ThreeVector& v, const G4bool calcNorm,
+                                       G4bool* validNorm, G4ThreeVector* n ) const {
+    Clock::time_point start = Clock::now();
+    G4double d = solid->DistanceToOut( p, v, calcNorm, validNorm, n );
+    Count( kDistanceToOutPV, start );
+    return d;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledSolid::DistanceToOut( const G4ThreeVector& p ) const {
+    Clock::time_point start = Clock::now();
+    G4double d = solid->DistanceToOut( p );
+    Count( kDistanceToOutP, start );
+    return d;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProfiledSolid::ComputeDimensions( G4VPVParameterisation* p, const G4int n, const G4VPhysicalVolume* pRep ){
+    solid->ComputeDimensions( p, n, pRep );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProfiledSolid::BoundingLimits( G4ThreeVector& pMin, G4ThreeVector& pMax ) const {
+    solid->BoundingLimits( pMin, pMax );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ProfiledSolid::CalculateExtent( const EAxis pAxis, const G4VoxelLimits& pVoxelLimit, const G4AffineTransform& pTransform,
+                                       G4double& pMin, G4double& pMax ) const {
+    return solid->CalculateExtent( pAxis, pVoxelLimit, pTransform, pMin, pMax );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledSolid::GetCubicVolume(){
+    return solid->GetCubicVolume();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ProfiledSolid::GetSurfaceArea(){
+    return solid->GetSurfaceArea();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4GeometryType ProfiledSolid::GetEntityType() const {
+    return solid->GetEntityType();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector ProfiledSolid::GetPointOnSurface() const {
+    return solid->GetPointOnSurface();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* ProfiledSolid::Clone() const {
+    return solid->Clone();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::ostream& ProfiledSolid::StreamInfo( std::ostream& os ) const {
+    return solid->StreamInfo( os );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProfiledSolid::DescribeYourselfTo( G4VGraphicsScene& scene ) const {
+    solid->DescribeYourselfTo( scene );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VisExtent ProfiledSolid::GetExtent() const {
+    return solid->GetExtent();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4Polyhedron* ProfiledSolid::CreatePolyhedron() const {
+    return solid->CreatePolyhedron();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4Polyhedron* ProfiledSolid::GetPolyhedron() const {
+    return solid->GetPolyhedron();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const G4VSolid* ProfiledSolid::GetConstituentSolid( G4int no ) const {
+    return const_cast<const G4VSolid*>( solid )->GetConstituentSolid( no );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VSolid* ProfiledSolid::GetConstituentSolid( G4int no ){
+    return solid->GetConstituentSolid( no );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const G4DisplacedSolid* ProfiledSolid::GetDisplacedSolidPtr() const {
+    return const_cast<const G4VSolid*>( solid )->GetDisplacedSolidPtr();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4DisplacedSolid* ProfiledSolid::GetDisplacedSolidPtr(){
+    return solid->GetDisplacedSolidPtr();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
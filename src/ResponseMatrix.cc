@@ -0,0 +1,332 @@
+/// \file ResponseMatrix.cc
+/// \brief Implementation of the ResponseMatrix class
+
+#include "ResponseMatrix.hh"
+#include "ResponseMatrixMessenger.hh"
+#include "OutputSink.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Step.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4UImanager.hh"
+#include "G4EmParameters.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "TMD5.h"
+
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseMatrix::ResponseMatrix() :
+    messenger( 0 ),
+    active( false ),
+    cached( false ),
+    force( false ),
+    nincident( 100 ),
+    incident_min( 0 ),
+    incident_max( 100*keV ),
+    ndeposit( 1000 ),
+    deposit_max( 100*keV ),
+    photons( 10000 ),
+    cache_dir( "response_cache" ),
+    sink( 0 )
+{
+    SetDetectors( "detector" );
+    messenger = new ResponseMatrixMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseMatrix::~ResponseMatrix(){
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::SetDetectors( G4String patterns ){
+
+    detector_patterns.clear();
+
+    std::istringstream is( patterns );
+    std::string pattern;
+    while( is >> pattern )
+        detector_patterns.push_back( pattern );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::SetIncident( G4int n, G4double min, G4double max ){
+    nincident = n;
+    incident_min = min;
+    incident_max = max;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::SetDeposit( G4int n, G4double max ){
+    ndeposit = n;
+    deposit_max = max;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::Run(){
+
+    if( detector_patterns.empty() ){
+        G4cerr << "/response/run: no detector volume given." << G4endl;
+        return;
+    }
+
+    std::stringstream ss;
+    ss << "/run/beamOn " << nincident*photons;
+
+    G4cout << "Response matrices: " << nincident << " energies from " << G4BestUnit( incident_min, "Energy" )
+           << "to " << G4BestUnit( incident_max, "Energy" ) << ", " << photons << " photons each" << G4endl;
+
+    active = true;
+    G4UImanager::GetUIpointer()->ApplyCommand( ss.str() );
+    active = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ResponseMatrix::GetIncidentEnergy( G4int eventID ) const {
+    G4int i = ( eventID/photons ) % nincident;
+    return incident_min + ( i+0.5 )*( incident_max-incident_min )/nincident;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int ResponseMatrix::GetDetector( const G4VPhysicalVolume* pv ){
+
+    std::unordered_map<const G4VPhysicalVolume*, G4int>::const_iterator it = detector_index.find( pv );
+    if( it!=detector_index.end() )
+        return it->second;
+
+    const G4String& name = pv->GetName();
+    G4bool match = false;
+    for( size_t i=0; i<detector_patterns.size() && !match; i++ )
+        match = MatchesVolumePattern( detector_patterns[i], name );
+
+    G4int index = -1;
+    if( match ){
+        for( size_t i=0; i<detectors.size(); i++ ){
+            if( detectors[i]==name )
+                index = i;
+        }
+        if( index<0 ){
+            detectors.push_back( name );
+            index = detectors.size()-1;
+        }
+    }
+
+    detector_index[pv] = index;
+    return index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ResponseMatrix::BeginOfRun( const std::vector<std::string>& geometry, const std::vector<std::string>& source ){
+
+    sink = 0;
+    cached = false;
+    detectors.clear();
+    detector_index.clear();
+
+    // Detectors are numbered in the order of the volume store.
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( size_t i=0; i<store->size(); i++ )
+        GetDetector( (*store)[i] );
+
+    if( detectors.empty() )
+        G4cerr << "No detector volume matches the /response/detector names." << G4endl;
+
+    // Cache key: everything the matrices depend on, taken from the live state rather
+    // than from the macros, which may set it in any way.
+    std::vector<std::string> lines( geometry );
+    lines.insert( lines.end(), source.begin(), source.end() );
+
+    std::stringstream ss;
+    G4EmParameters* em = G4EmParameters::Instance();
+    ss << "em fluo " << em->Fluo() << " auger " << em->Auger() << " pixe " << em->Pixe();
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << std::setprecision( 12 ) << "incident " << nincident << ' ' << incident_min << ' ' << incident_max
+       << " deposit " << ndeposit << ' ' << deposit_max << " photons " << photons;
+    lines.push_back( ss.str() );
+
+    TMD5 md5;
+    for( size_t i=0; i<lines.size(); i++ ){
+        md5.Update( (const UChar_t*)lines[i].data(), lines[i].size() );
+        md5.Update( (const UChar_t*)"\n", 1 );
+    }
+    md5.Final();
+    key = md5.AsString();
+
+    counts.assign( detectors.size(), std::vector<G4double>( ( nincident+2 )*( ndeposit+2 ), 0. ) );
+    edep.assign( detectors.size(), 0. );
+
+    if( force || detectors.empty() )
+        return false;
+
+    for( size_t d=0; d<detectors.size(); d++ ){
+        if( !ReadCache( d ) ){
+            counts.assign( detectors.size(), std::vector<G4double>( ( nincident+2 )*( ndeposit+2 ), 0. ) );
+            return false;
+        }
+    }
+
+    G4cout << "Response matrices read from " << cache_dir << ", key " << key << G4endl;
+    cached = true;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::ProcessStep( const G4Step* step ){
+
+    if( !active || cached )
+        return;
+
+    const G4VPhysicalVolume* pv = step->GetPreStepPoint()->GetPhysicalVolume();
+    if( pv==0 )
+        return;
+
+    G4int d = GetDetector( pv );
+    if( d>=0 )
+        edep[d] += step->GetTotalEnergyDeposit();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::EndOfEvent( G4int eventID ){
+
+    if( !active || cached )
+        return;
+
+    G4int i = eventID/photons;
+
+    for( size_t d=0; d<edep.size(); d++ ){
+        if( i<nincident ){
+            G4int j = edep[d]<=0 ? 0 : edep[d]>=deposit_max ? ndeposit+1 : 1 + G4int( edep[d]/deposit_max*ndeposit );
+            counts[d][ ( i+1 ) + ( nincident+2 )*j ] += 1;
+        }
+        edep[d] = 0;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::EndOfRun( G4int nevents ){
+
+    if( !active )
+        return;
+
+    for( size_t d=0; d<detectors.size(); d++ ){
+
+        // Fraction of the photons depositing energy, over all incident energies.
+        G4double detected = 0;
+        for( G4int i=1; i<=nincident; i++ ){
+            for( G4int j=1; j<ndeposit+2; j++ )
+                detected += counts[d][ i + ( nincident+2 )*j ];
+        }
+        G4cout << "    " << detectors[d] << ": " << detected/( G4double( nincident )*photons ) << " of the photons deposit energy" << G4endl;
+
+        // A run cut short would leave the last energies empty.
+        if( !cached && nevents==nincident*photons )
+            WriteCache( d );
+
+        if( sink!=0 ){
+            std::stringstream title;
+            title << "Response of " << detectors[d] << ", " << photons << " photons per energy;incident E (MeV);deposited E (MeV)";
+            sink->WriteHistogram2D( "response_"+detectors[d], title.str(), nincident, incident_min, incident_max,
+                                    ndeposit, 0, deposit_max, counts[d] );
+        }
+    }
+
+    if( sink!=0 ){
+        std::vector<std::string> lines;
+        lines.push_back( "key " + key );
+        sink->WriteText( "response_key", lines );
+    }
+
+    sink = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String ResponseMatrix::CacheFile( size_t d ) const {
+    return cache_dir + "/" + key.substr( 0, 16 ) + "_" + detectors[d] + ".resp";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ResponseMatrix::ReadCache( size_t d ){
+
+    std::ifstream file( CacheFile( d ).c_str() );
+    if( !file.good() )
+        return false;
+
+    // The header is checked in full, the file name holds a part of the key only.
+    std::string line, word, value;
+    std::getline( file, line );
+    file >> word >> value;
+    if( word!="key" || value!=key )
+        return false;
+
+    G4int n, m, p;
+    G4double min, max, dmax;
+    file >> word >> value;
+    file >> word >> n >> min >> max;
+    file >> word >> m >> dmax;
+    file >> word >> p;
+    if( !file.good() || n!=nincident || m!=ndeposit || p!=photons )
+        return false;
+
+    for( G4int i=0; i<nincident+2; i++ ){
+        for( G4int j=0; j<ndeposit+2; j++ )
+            file >> counts[d][ i + ( nincident+2 )*j ];
+    }
+
+    return !file.fail();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMatrix::WriteCache( size_t d ) const {
+
+    mkdir( cache_dir.c_str(), 0755 );
+
+    std::ofstream file( CacheFile( d ).c_str() );
+    if( !file.good() ){
+        G4cerr << "Cannot write the response matrix to " << CacheFile( d ) << G4endl;
+        return;
+    }
+
+    // Energies in MeV. One line per incident energy bin, under- and overflow included,
+    // with the counts per deposited energy bin, bin 0 for no deposit.
+    file << "# apixs response matrix\n"
+         << "key " << key << '\n'
+         << "detector " << detectors[d] << '\n'
+         << std::setprecision( 12 )
+         << "incident " << nincident << ' ' << incident_min/MeV << ' ' << incident_max/MeV << '\n'
+         << "deposit " << ndeposit << ' ' << deposit_max/MeV << '\n'
+         << "photons " << photons << '\n';
+
+    for( G4int i=0; i<nincident+2; i++ ){
+        for( G4int j=0; j<ndeposit+2; j++ )
+            file << ( j>0 ? " " : "" ) << counts[d][ i + ( nincident+2 )*j ];
+        file << '\n';
+    }
+
+    G4cout << "    written to " << CacheFile( d ) << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
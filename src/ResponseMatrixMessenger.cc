@@ -0,0 +1,136 @@
+// $Id: ResponseMatrixMessenger.cc $
+//
+/// \file ResponseMatrixMessenger.cc
+/// \brief Definition of the ResponseMatrixMessenger class
+
+#include "ResponseMatrixMessenger.hh"
+#include "ResponseMatrix.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+ResponseMatrixMessenger::ResponseMatrixMessenger( ResponseMatrix* r ) : G4UImessenger(), response( r ){
+
+    directory = new G4UIdirectory( "/response/" );
+    directory->SetGuidance( "Detector response matrices from monochromatic photon sweeps, cached on disk." );
+    directory->SetGuidance( "The photons start from the GPS position and direction distributions; the GPS particle and energy are overridden." );
+
+    detectorCmd = new G4UIcmdWithAString( "/response/detector", this );
+    detectorCmd->SetGuidance( "Physical volume names of the detectors, separated by spaces (default detector)." );
+    detectorCmd->SetGuidance( "A trailing * matches any suffix, e.g. farside_*." );
+    detectorCmd->SetParameterName( "volumes", false );
+    detectorCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    incidentCmd = new G4UIcommand( "/response/incident", this );
+    incidentCmd->SetGuidance( "Incident energies: the centers of n bins between min and max." );
+    incidentCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "n", 'i', false );
+    param->SetParameterRange( "n>0" );
+    incidentCmd->SetParameter( param );
+    param = new G4UIparameter( "min", 'd', false );
+    incidentCmd->SetParameter( param );
+    param = new G4UIparameter( "max", 'd', false );
+    incidentCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    incidentCmd->SetParameter( param );
+
+    depositCmd = new G4UIcommand( "/response/deposit", this );
+    depositCmd->SetGuidance( "Deposited energy histogram: number of bins from 0 to max." );
+    depositCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    param = new G4UIparameter( "n", 'i', false );
+    param->SetParameterRange( "n>0" );
+    depositCmd->SetParameter( param );
+    param = new G4UIparameter( "max", 'd', false );
+    param->SetParameterRange( "max>0" );
+    depositCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    depositCmd->SetParameter( param );
+
+    photonsCmd = new G4UIcmdWithAnInteger( "/response/photons", this );
+    photonsCmd->SetGuidance( "Photons simulated per incident energy (default 10000)." );
+    photonsCmd->SetParameterName( "photons", false );
+    photonsCmd->SetRange( "photons>0" );
+    photonsCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    cacheCmd = new G4UIcmdWithAString( "/response/cache", this );
+    cacheCmd->SetGuidance( "Directory of the cached matrices (default response_cache)." );
+    cacheCmd->SetParameterName( "dir", false );
+    cacheCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    forceCmd = new G4UIcmdWithABool( "/response/force", this );
+    forceCmd->SetGuidance( "Simulate the matrices even if they are in the cache." );
+    forceCmd->SetParameterName( "force", true );
+    forceCmd->SetDefaultValue( true );
+    forceCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    runCmd = new G4UIcmdWithoutParameter( "/response/run", this );
+    runCmd->SetGuidance( "Generate the matrices, or read them from the cache: a run of photons times energies events." );
+    runCmd->AvailableForStates( G4State_Idle );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+ResponseMatrixMessenger::~ResponseMatrixMessenger(){
+    delete detectorCmd;
+    delete incidentCmd;
+    delete depositCmd;
+    delete photonsCmd;
+    delete cacheCmd;
+    delete forceCmd;
+    delete runCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void ResponseMatrixMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==detectorCmd ){
+        response->SetDetectors( newValue );
+    }
+    else if( command==incidentCmd ){
+        std::istringstream is( newValue );
+        G4int n;
+        G4double min, max;
+        G4String unit;
+        is >> n >> min >> max >> unit;
+        if( max<=min || min<0 ){
+            G4cerr << "/response/incident: max must be larger than min, and min positive." << G4endl;
+            return;
+        }
+        response->SetIncident( n, min*G4UIcommand::ValueOf( unit ), max*G4UIcommand::ValueOf( unit ) );
+    }
+    else if( command==depositCmd ){
+        std::istringstream is( newValue );
+        G4int n;
+        G4double max;
+        G4String unit;
+        is >> n >> max >> unit;
+        response->SetDeposit( n, max*G4UIcommand::ValueOf( unit ) );
+    }
+    else if( command==photonsCmd ){
+        response->SetPhotons( photonsCmd->GetNewIntValue( newValue ) );
+    }
+    else if( command==cacheCmd ){
+        response->SetCacheDirectory( newValue );
+    }
+    else if( command==forceCmd ){
+        response->SetForce( forceCmd->GetNewBoolValue( newValue ) );
+    }
+    else if( command==runCmd ){
+        response->Run();
+    }
+    return;
+}
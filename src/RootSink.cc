@@ -0,0 +1,581 @@
+/// \file RootSink.cc
+/// \brief Implementation of the RootSink class
+
+#include "RootSink.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TMacro.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TObjString.h"
+
+#include <sstream>
+#include <set>
+#include <cstring>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RootSink::RootSink( G4String s, const std::map< G4String, G4String >& types )
+ : OutputSink(),
+   schema( s ),
+   leaf_types( types ),
+   output_file( 0 ),
+   data_tree( 0 ),
+   track_tree( 0 ),
+   step_tree( 0 ),
+   index_tree( 0 ),
+   columnar( false ),
+   eventID(0),
+   trackID(0),
+   stepID(0),
+   parentID(0),
+   nsteps(0),
+   volume_copy_number(0),
+   tmp_particle_name(""),
+   tmp_volume_name(""),
+   tmp_process_name("")
+{
+    max_char_len = 15;
+
+    for( int i=0; i<kNumKinematics; i++ ){
+        kinematics[i] = 0;
+        kinematics_enabled[i] = GetLeafType( kinematics_names[i] )!="";
+        kinematics_branches[i] = 0;
+    }
+
+    particle_column_ptr = &particle_column;
+    volume_column_ptr = &volume_column;
+    process_column_ptr = &process_column;
+    copy_branch = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RootSink::~RootSink(){
+    Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String RootSink::GetLeafType( G4String field ) const {
+    std::map< G4String, G4String >::const_iterator it = leaf_types.find( field );
+    return it==leaf_types.end() ? G4String("D") : it->second;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RootSink::Open( G4String name, G4bool resume ){
+
+    if( resume ){
+        // ROOT recovers the file up to the last AutoSave, which is written together with the checkpoint.
+        output_file = new TFile(name, "UPDATE");
+        data_tree = (TTree*)output_file->Get("events");
+        track_tree = (TTree*)output_file->Get("tracks");
+        step_tree = (TTree*)output_file->Get("steps");
+        index_tree = (TTree*)output_file->Get("event_index");
+    }
+    else{
+        output_file = new TFile(name, "NEW");
+        G4cout << "Output ROOT file " << name << " created." << G4endl;
+    }
+
+    if( output_file->IsZombie() ){
+        G4cerr << "Cannot open output ROOT file " << name << G4endl;
+        delete output_file;
+        output_file = 0;
+        return false;
+    }
+
+    if( data_tree==0 && track_tree==0 ){
+        if( schema=="track" ){
+            track_tree = new TTree("tracks", "Per-track info for the run, followed by nsteps entries in steps");
+            step_tree = new TTree("steps", "Step-level kinematics of the tracks");
+            G4cout << "Output TTree objects for tracks and steps created." << G4endl;
+        }
+        else{
+            data_tree = new TTree("events", schema=="event" ? "Step-level info for the run, one entry per event" : "Track-level info for the run");
+            G4cout << "Output TTree object created." << G4endl;
+        }
+    }
+
+    if( index_tree==0 )
+        index_tree = new TTree("event_index", "Entry range of every event in the data trees");
+
+    BindTrees();
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int RootSink::GetResumedEvents(){
+
+    if( output_file==0 )
+        return 0;
+
+    TMacro* ckpt = (TMacro*)output_file->Get( "checkpoint" );
+    if( ckpt==0 )
+        return 0;
+
+    TObjString* line = ckpt->GetLineWith( "completed" );
+    if( line==0 )
+        return 0;
+
+    std::stringstream ss( line->GetString().Data() );
+    std::string key;
+    G4int n = 0;
+    ss >> key >> n;
+
+    return n;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::WriteText( G4String name, const vector<std::string>& lines ){
+
+    if( output_file==0 )
+        return;
+
+    TMacro mac( name, "" );
+    for( size_t i=0; i<lines.size(); i++ )
+        mac.AddLine( lines[i].c_str() );
+
+    output_file->cd();
+    mac.Write( 0, TObject::kOverwrite );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::FillTable( G4String name, const vector<std::string>& columns, const vector<G4double>& row ){
+
+    if( output_file==0 )
+        return;
+
+    std::map< G4String, Table >::iterator it = tables.find( name );
+    if( it==tables.end() ){
+        Table t;
+        t.tree = (TTree*)output_file->Get( name );
+        if( t.tree==0 ){
+            output_file->cd();
+            t.tree = new TTree( name, name );
+        }
+        it = tables.insert( std::make_pair( name, t ) ).first;
+
+        // The row buffer is sized once, so that the branch addresses stay valid.
+        Table& table = it->second;
+        table.row.resize( columns.size() );
+        for( size_t i=0; i<columns.size(); i++ )
+            Bind( table.tree, columns[i].c_str(), &table.row[i], ( columns[i]+"/D" ).c_str() );
+    }
+
+    Table& table = it->second;
+    for( size_t i=0; i<table.row.size() && i<row.size(); i++ )
+        table.row[i] = row[i];
+    table.tree->Fill();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::WriteHistogram( G4String name, G4String title, G4double min, G4double max, const vector<G4double>& contents ){
+
+    if( output_file==0 || contents.size()<2 )
+        return;
+
+    output_file->cd();
+
+    TH1D h( name, title, contents.size()-2, min, max );
+    for( size_t i=0; i<contents.size(); i++ )
+        h.SetBinContent( i, contents[i] );
+    h.SetEntries( h.Integral( 0, contents.size()-1 ) );
+    h.Write( 0, TObject::kOverwrite );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::WriteHistogram2D( G4String name, G4String title, G4int nx, G4double xmin, G4double xmax,
+                                 G4int ny, G4double ymin, G4double ymax, const vector<G4double>& contents ){
+
+    if( output_file==0 || contents.size()!=size_t( (nx+2)*(ny+2) ) )
+        return;
+
+    output_file->cd();
+
+    // TH2 global bins run over x first, as the contents do.
+    TH2D h( name, title, nx, xmin, xmax, ny, ymin, ymax );
+    for( size_t i=0; i<contents.size(); i++ )
+        h.SetBinContent( i, contents[i] );
+    h.SetEntries( h.Integral( 0, nx+1, 0, ny+1 ) );
+    h.Write( 0, TObject::kOverwrite );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::Checkpoint( G4int /*completed_events*/, const vector<std::string>& lines ){
+
+    if( output_file==0 )
+        return;
+
+    output_file->cd();
+    if( data_tree )
+        data_tree->AutoSave( "SaveSelf" );
+    if( track_tree ){
+        track_tree->AutoSave( "SaveSelf" );
+        step_tree->AutoSave( "SaveSelf" );
+    }
+    index_tree->AutoSave( "SaveSelf" );
+    for( std::map< G4String, Table >::iterator it=tables.begin(); it!=tables.end(); ++it )
+        it->second.tree->AutoSave( "SaveSelf" );
+
+    WriteText( "checkpoint", lines );
+    output_file->Flush();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::Close(){
+
+    if( output_file==0 )
+        return;
+
+    output_file->Write( 0, TObject::kOverwrite );
+    output_file->Close();
+
+    delete output_file;
+    output_file = 0;
+    data_tree = 0;
+    track_tree = 0;
+    step_tree = 0;
+    index_tree = 0;
+    tables.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::Bind( TTree* tree, const char* name, void* address, const char* leaflist ){
+    if( tree->GetBranch( name ) )
+        tree->SetBranchAddress( name, address );
+    else
+        tree->Branch( name, address, leaflist );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::BindTrees(){
+
+    columnar = schema=="event";
+
+    // Fields outside the step record are not written.
+    for( int i=0; i<kNumKinematics; i++ )
+        kinematics_enabled[i] = GetLeafType( kinematics_names[i] )!="" && ( record_fields & GetKinematicsField( i ) );
+
+    // first/n refer to the events tree, or to the tracks tree with first_step/nsteps
+    // referring to the steps tree.
+    Bind(index_tree, "eventID", &index_eventID, "eventID/I");
+    Bind(index_tree, "runID", &index_runID, "runID/I");
+    Bind(index_tree, "job", &index_job, "job/L");
+    Bind(index_tree, "first", &index_first, "first/L");
+    Bind(index_tree, "n", &index_n, "n/L");
+    if( track_tree!=0 ){
+        Bind(index_tree, "first_step", &index_first_step, "first_step/L");
+        Bind(index_tree, "nsteps", &index_nsteps, "nsteps/L");
+    }
+    Bind(index_tree, "edep_center", &edep_center, "edep_center/D");
+    Bind(index_tree, "edep_farside", &edep_farside, "edep_farside/D");
+    Bind(index_tree, "nfarside", &nfarside, "nfarside/I");
+
+    // Event schema: one entry per event with an array per field.
+    if( data_tree!=0 && columnar ){
+        BindColumns();
+        return;
+    }
+
+    // Step schema: everything in one row per step.
+    if( data_tree!=0 ){
+        // information about its order in the event/run sequence
+        Bind(data_tree, "eventID", &eventID, "eventID/I");
+        Bind(data_tree, "trackID", &trackID, "trackID/I");
+        Bind(data_tree, "stepID", &stepID, "stepID/I");
+
+        // information about its idenity
+        if( record_fields & StepFields::kParticle )
+            Bind(data_tree, "particle", particle_name, "particle[16]/C");
+        Bind(data_tree, "parentID", &parentID, "parentID/I");
+    }
+
+    // Track schema: the per-track constants are written once per track, followed by
+    // nsteps entries of the step tree.
+    if( track_tree!=0 ){
+        Bind(track_tree, "eventID", &eventID, "eventID/I");
+        Bind(track_tree, "trackID", &trackID, "trackID/I");
+        Bind(track_tree, "parentID", &parentID, "parentID/I");
+        if( record_fields & StepFields::kParticle )
+            Bind(track_tree, "particle", particle_name, "particle[16]/C");
+        Bind(track_tree, "nsteps", &nsteps, "nsteps/I");
+    }
+
+    TTree* kinematics_tree = data_tree!=0 ? data_tree : step_tree;
+
+    if( kinematics_tree!=0 ){
+        if( kinematics_tree==step_tree )
+            Bind(kinematics_tree, "stepID", &stepID, "stepID/I");
+
+        // geometric information
+        if( record_fields & StepFields::kVolume )
+            Bind(kinematics_tree, "volume", volume_name, "volume[16]/C");
+        if( record_fields & StepFields::kCopyNumber )
+            Bind(kinematics_tree, "copy_n", &volume_copy_number, "copy_n/I");
+
+        // position, direction, time and energies
+        for( int i=0; i<kNumKinematics; i++ ){
+            if( !kinematics_enabled[i] )
+                continue;
+            std::string leaf = std::string( kinematics_names[i] ) + "/" + GetLeafType( kinematics_names[i] );
+            Bind(kinematics_tree, kinematics_names[i], &kinematics[i], leaf.c_str());
+        }
+
+        if( record_fields & StepFields::kProcess )
+            Bind(kinematics_tree, "process", process_name, "process[16]/C");
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::BindColumns(){
+
+    Bind(data_tree, "eventID", &eventID, "eventID/I");
+    Bind(data_tree, "nsteps", &nsteps, "nsteps/I");
+
+    const char* id_names[kNumIDs] = { "trackID", "stepID", "parentID" };
+    for( int i=0; i<kNumIDs; i++ ){
+        id_columns[i].reserve( 1024 );
+        std::string leaf = std::string( id_names[i] ) + "[nsteps]/I";
+        Bind(data_tree, id_names[i], id_columns[i].data(), leaf.c_str());
+        id_branches[i] = data_tree->GetBranch( id_names[i] );
+    }
+
+    copy_branch = 0;
+    if( record_fields & StepFields::kCopyNumber ){
+        copy_column.reserve( 1024 );
+        Bind(data_tree, "copy_n", copy_column.data(), "copy_n[nsteps]/I");
+        copy_branch = data_tree->GetBranch( "copy_n" );
+    }
+
+    for( int i=0; i<kNumKinematics; i++ ){
+        kinematics_branches[i] = 0;
+        if( !kinematics_enabled[i] )
+            continue;
+        kinematics_columns[i].reserve( 1024 );
+        std::string leaf = std::string( kinematics_names[i] ) + "[nsteps]/" + GetLeafType( kinematics_names[i] );
+        Bind(data_tree, kinematics_names[i], kinematics_columns[i].data(), leaf.c_str());
+        kinematics_branches[i] = data_tree->GetBranch( kinematics_names[i] );
+    }
+
+    const char* string_names[3] = { "particle", "volume", "process" };
+    vector<std::string>** string_ptrs[3] = { &particle_column_ptr, &volume_column_ptr, &process_column_ptr };
+    unsigned string_fields[3] = { StepFields::kParticle, StepFields::kVolume, StepFields::kProcess };
+    for( int i=0; i<3; i++ ){
+        if( !( record_fields & string_fields[i] ) )
+            continue;
+        if( data_tree->GetBranch( string_names[i] ) )
+            data_tree->SetBranchAddress( string_names[i], string_ptrs[i] );
+        else
+            data_tree->Branch( string_names[i], string_ptrs[i] );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::WriteEvent( vector<StepInfo>& steps ){
+    WriteEventPart( steps, true, true );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::WriteEventPart( vector<StepInfo>& steps, G4bool first, G4bool last ){
+
+    // Entry ranges are taken before filling.
+    if( first )
+        BeginIndex( steps );
+    AddToIndex( steps );
+
+    if( data_tree!=0 && columnar )
+        FillEvent( steps );
+    else if( data_tree!=0 )
+        FillSteps( steps );
+    if( track_tree!=0 )
+        FillTracks( steps );
+
+    if( last ){
+        EndIndex();
+        index_tree->Fill();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::BeginIndex( vector<StepInfo>& steps ){
+
+    index_eventID = steps.empty() ? 0 : steps[0].GetEventID();
+    index_runID = runID;
+    index_job = jobID;
+
+    if( track_tree!=0 ){
+        index_first = track_tree->GetEntries();
+        index_first_step = step_tree->GetEntries();
+    }
+    else{
+        index_first = data_tree->GetEntries();
+        index_first_step = index_first;
+    }
+    index_nsteps = 0;
+
+    edep_center = 0;
+    edep_farside = 0;
+    farside_hit.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::AddToIndex( vector<StepInfo>& steps ){
+
+    index_nsteps += steps.size();
+
+    for( size_t i=0; i<steps.size(); ++i ){
+        G4double e = steps[i].GetDepositedEnergy();
+        if( e<=0 )
+            continue;
+        G4String volume = steps[i].GetVolumeName();
+        if( volume=="detector" )
+            edep_center += e;
+        else if( volume.compare( 0, 8, "farside_" )==0 ){
+            // The detectors of an array share their name.
+            edep_farside += e;
+            farside_hit.insert( std::make_pair( volume, steps[i].GetVolumeCopyNumber() ) );
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::EndIndex(){
+    index_n = ( track_tree!=0 ? track_tree : data_tree )->GetEntries() - index_first;
+    nfarside = farside_hit.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::CopyStep( StepInfo& step ){
+
+    eventID = step.GetEventID();
+    trackID = step.GetTrackID();
+    stepID = step.GetStepID();
+    parentID = step.GetParentID();
+
+    if( record_fields & StepFields::kParticle ){
+        tmp_particle_name = step.GetParticleName();
+        strncpy( particle_name, tmp_particle_name.c_str(), max_char_len);
+    }
+
+    if( record_fields & StepFields::kVolume ){
+        tmp_volume_name = step.GetVolumeName();
+        strncpy( volume_name, tmp_volume_name.c_str(), max_char_len);
+    }
+
+    if( record_fields & StepFields::kProcess ){
+        tmp_process_name = step.GetProcessName();
+        strncpy( process_name, tmp_process_name.c_str(), max_char_len);
+    }
+    if( record_fields & StepFields::kCopyNumber )
+        volume_copy_number = step.GetVolumeCopyNumber();
+
+    GetKinematics( step, kinematics, kinematics_enabled );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::FillSteps( vector<StepInfo>& steps ){
+    for( size_t i=0; i < steps.size(); ++i ){
+        CopyStep( steps[i] );
+        data_tree->Fill();
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::FillTracks( vector<StepInfo>& steps ){
+
+    // Steps of a track are contiguous in the collection since Geant4 tracks one particle
+    // at a time. A suspended track that comes back simply gets a second track entry.
+    size_t first = 0;
+    while( first < steps.size() ){
+
+        size_t last = first+1;
+        while( last < steps.size() && steps[last].GetTrackID()==steps[first].GetTrackID() )
+            last++;
+
+        CopyStep( steps[first] );
+        nsteps = last-first;
+        track_tree->Fill();
+
+        for( size_t i=first; i<last; ++i ){
+            CopyStep( steps[i] );
+            step_tree->Fill();
+        }
+        first = last;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RootSink::FillEvent( vector<StepInfo>& steps ){
+
+    for( int k=0; k<kNumIDs; k++ )
+        id_columns[k].clear();
+    for( int k=0; k<kNumKinematics; k++ )
+        kinematics_columns[k].clear();
+    particle_column.clear();
+    volume_column.clear();
+    process_column.clear();
+    copy_column.clear();
+
+    for( size_t i=0; i < steps.size(); ++i ){
+        StepInfo& step = steps[i];
+
+        id_columns[kTrackID].push_back( step.GetTrackID() );
+        id_columns[kStepID].push_back( step.GetStepID() );
+        id_columns[kParentID].push_back( step.GetParentID() );
+
+        if( record_fields & StepFields::kParticle )
+            particle_column.push_back( step.GetParticleName() );
+        if( record_fields & StepFields::kVolume )
+            volume_column.push_back( step.GetVolumeName() );
+        if( record_fields & StepFields::kCopyNumber )
+            copy_column.push_back( step.GetVolumeCopyNumber() );
+        if( record_fields & StepFields::kProcess )
+            process_column.push_back( step.GetProcessName() );
+
+        GetKinematics( step, kinematics, kinematics_enabled );
+        for( int k=0; k<kNumKinematics; k++ ){
+            if( kinematics_enabled[k] )
+                kinematics_columns[k].push_back( kinematics[k] );
+        }
+    }
+
+    eventID = steps.empty() ? 0 : steps[0].GetEventID();
+    nsteps = steps.size();
+
+    // The columns may have been reallocated while growing.
+    for( int k=0; k<kNumIDs; k++ )
+        id_branches[k]->SetAddress( id_columns[k].data() );
+    for( int k=0; k<kNumKinematics; k++ ){
+        if( kinematics_branches[k] )
+            kinematics_branches[k]->SetAddress( kinematics_columns[k].data() );
+    }
+    if( copy_branch )
+        copy_branch->SetAddress( copy_column.data() );
+
+    data_tree->Fill();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1,4 +1,3 @@
-
 // $Id: RunAction.cc $
 //
 /// \file RunAction.cc
@@ -6,28 +5,89 @@
 
 
 #include "RunAction.hh"
+#include "RunActionMessenger.hh"
+#include "GeneratorAction.hh"
+#include "RootSink.hh"
+#include "FlatSink.hh"
+#include "NullSink.hh"
+#include "Trigger.hh"
+#include "StepFilter.hh"
+#include "XrayTally.hh"
+#include "SphereScorer.hh"
+#include "PointDetector.hh"
+#include "ResponseMatrix.hh"
+#include "ConvergenceMonitor.hh"
+#include "ScoringMesh.hh"
+#include "GeometryProfiler.hh"
+#include "RunMetrics.hh"
+#include "DecaySource.hh"
+#include "DetectorArrayParameterisation.hh"
 
 #include "G4Run.hh"
+#include "G4Event.hh"
 #include "G4RunManager.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
 
-#include "TFile.h"
-#include "TTree.h"
+#include "Randomize.hh"
+
+#include "G4PhysicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4RotationMatrix.hh"
+#include "G4VSolid.hh"
+#include "G4Material.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4VPhysicsConstructor.hh"
+
+#include <cstdlib>
+#include <algorithm>
+#include <sys/resource.h>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 RunAction::RunAction() : G4UserRunAction(), 
-    output_file( 0 ),
-    data_tree( 0 ),
-    output_name ("")/*, fRunActionMessenger(0)*/
+    output_name (""),
+    sink( 0 ),
+    format( "root" ),
+    schema( "step" ),
+    record_type( StepInfo::GetRecordType( "full" ) ),
+    fRunActionMessenger( 0 ),
+    metrics( 0 ),
+    generator( 0 ),
+    trigger( 0 ),
+    step_filter( 0 ),
+    xray_tally( 0 ),
+    sphere_scorer( 0 ),
+    point_detector( 0 ),
+    response_matrix( 0 ),
+    convergence( 0 ),
+    mesh( 0 ),
+    geometry_profiler( 0 ),
+    resume( false ),
+    tabulating( false ),
+    checkpoint_interval( 0 ),
+    completed_events( 0 ),
+    events_since_checkpoint( 0 ),
+    run_events( 0 ),
+    run_primaries( 0 ),
+    max_event_memory( 0 ),
+    overflow_mode( "spill" ),
+    peak_buffer( 0 ),
+    peak_buffer_event( -1 ),
+    peak_spilled( 0 ),
+    nspilled( 0 )
 {
-    G4RunManager::GetRunManager()->SetPrintProgress(1);
+    fRunActionMessenger = new RunActionMessenger( this );
+    metrics = new RunMetrics();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-RunAction::~RunAction(){}
+RunAction::~RunAction(){
+    delete fRunActionMessenger;
+    delete metrics;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -37,44 +97,445 @@ void RunAction::SetOutputFileName(G4String newname){
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run* /*run*/){
-    if( output_name!="" ){
-        output_file = new TFile(output_name, "NEW");
-        G4cout << "Output ROOT file " << output_name << " created." << G4endl;
+void RunAction::BeginOfRunAction(const G4Run* run){
+
+    // The decays of a tabulation are not events of the experiment: no output is opened,
+    // no tally is reset or filled, and the state of the previous run is left alone.
+    tabulating = generator!=0 && generator->GetDecaySource()->IsTabulating();
+    if( tabulating )
+        return;
+
+    completed_events = 0;
+    events_since_checkpoint = 0;
+    run_events = 0;
+    run_primaries = 0;
+
+    if( trigger!=0 )
+        trigger->ResetCounters();
+
+    metrics->BeginOfRun( run->GetRunID(), run->GetNumberOfEventToBeProcessed(), output_name );
+
+    peak_buffer = 0;
+    peak_buffer_event = -1;
+    peak_spilled = 0;
+    nspilled = 0;
+    truncated_events.clear();
+
+    if( step_filter!=0 ){
+        step_filter->Compile();
+        step_filter->ResetCounters();
+    }
+
+    if( xray_tally!=0 )
+        xray_tally->BeginOfRun();
+
+    if( sphere_scorer!=0 )
+        sphere_scorer->BeginOfRun();
+
+    if( point_detector!=0 )
+        point_detector->BeginOfRun();
+
+    // The runs of /response/run have a fixed length, and their steps are not those of
+    // the experiment.
+    G4bool simulating = response_matrix==0 || !response_matrix->IsActive();
+    if( convergence!=0 )
+        convergence->BeginOfRun( simulating );
+    if( mesh!=0 )
+        mesh->BeginOfRun( simulating );
+
+    if( geometry_profiler!=0 )
+        geometry_profiler->BeginOfRun();
 
-        if( output_file ){
-            data_tree = new TTree("events", "Track-level info for the run");
-            G4cout << "Output TTree object created." << G4endl;
+    // Nothing to simulate if the response matrices are all in the cache.
+    if( response_matrix!=0 && response_matrix->IsActive() && response_matrix->BeginOfRun( DescribeGeometry(), generator!=0 ? generator->DescribeSource() : std::vector< std::string >() ) )
+        G4RunManager::GetRunManager()->AbortRun( true );
+
+    // Event IDs start at 0 unless this run continues a checkpointed one.
+    if( generator )
+        generator->SetFirstEventID( 0 );
+
+    if( output_name!="" || format=="null" ){
+
+        if( format=="flat" )
+            sink = new FlatSink();
+        else if( format=="null" )
+            sink = new NullSink();
+        else
+            sink = new RootSink( schema, leaf_types );
+
+        sink->SetFields( record_type->fields );
+
+        if( !sink->Open( output_name, resume ) ){
+            delete sink;
+            sink = 0;
+            return;
         }
+
+        sink->SetRunInfo( run->GetRunID(), random_seeds.empty() ? 0 : random_seeds[0] );
+
+        if( xray_tally!=0 )
+            xray_tally->SetSink( sink );
+        if( point_detector!=0 )
+            point_detector->SetSink( sink );
+        if( response_matrix!=0 )
+            response_matrix->SetSink( sink );
+        if( convergence!=0 )
+            convergence->SetSink( sink );
+        if( mesh!=0 )
+            mesh->SetSink( sink );
+        if( geometry_profiler!=0 )
+            geometry_profiler->SetSink( sink );
+
+        if( resume ){
+            completed_events = sink->GetResumedEvents();
+            G4cout << "Resuming " << output_name << " after " << completed_events << " events." << G4endl;
+
+            if( generator )
+                generator->SetFirstEventID( completed_events );
+
+            if( mesh!=0 && mesh->IsEnabled() )
+                G4cout << "The scoring mesh is not checkpointed, it covers the events after " << completed_events << " only." << G4endl;
+
+            // Only the first run continues the file, later runs of the job start anew.
+            resume = false;
+        }
+
+        if( max_event_memory>0 && overflow_mode=="spill" && !sink->SupportsPartialEvents() )
+            G4cout << "The event schema keeps whole events in memory: events over the memory limit will be truncated." << G4endl;
     }
 }
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::EndOfRunAction(const G4Run* /*run*/){
+void RunAction::EndOfRunAction(const G4Run* run){
+
+    if( tabulating ){
+        tabulating = false;
+        return;
+    }
+
+    if( trigger!=0 )
+        trigger->Print();
+    if( step_filter!=0 )
+        step_filter->Print();
+
+    PrintBufferStatistics();
+
+    // Spectra are written before the sink is closed. Yields are per primary, of which
+    // there may be several per event.
+    G4int nevents = run->GetNumberOfEvent();
+    G4int nprimaries = run_primaries>0 ? G4int( run_primaries ) : nevents;
+
+    if( xray_tally!=0 )
+        xray_tally->EndOfRun( nprimaries );
+
+    if( point_detector!=0 )
+        point_detector->EndOfRun( nevents, nevents>0 ? nprimaries/G4double( nevents ) : 1. );
+
+    if( response_matrix!=0 )
+        response_matrix->EndOfRun( run->GetNumberOfEvent() );
+
+    if( convergence!=0 )
+        convergence->EndOfRun( nevents>0 ? nprimaries/G4double( nevents ) : 1. );
+
+    if( sphere_scorer!=0 && sphere_scorer->IsPlaced() )
+        sphere_scorer->EndOfRun( sink, nprimaries );
 
-    if( output_file!=0 ) {
+    // The events skipped when resuming reach the run but not the mesh.
+    if( mesh!=0 )
+        mesh->EndOfRun( run_events, nprimaries );
+
+    if( geometry_profiler!=0 )
+        geometry_profiler->EndOfRun();
+
+    if( sink!=0 ) {
         for( unsigned int i=0; i<macros.size(); i++){
-            TMacro mac( macros[i] );
-            mac.Write();    
+            sink->WriteMacroFile( macros[i] );
         }
 
         std::stringstream ss;
         for( unsigned int i=0; i<random_seeds.size(); i++)
             ss << random_seeds[i] << '\t';
 
-        TMacro randm( "rand_seeds");
-        randm.AddLine( ss.str().c_str());
-        randm.Write();
+        std::vector< std::string > lines;
+        lines.push_back( ss.str() );
+        sink->WriteText( "rand_seeds", lines );
+
+        // How the per-event random state is derived, needed to replay single events.
+        std::stringstream sch;
+        sch << "runID " << run->GetRunID();
+        lines.clear();
+        lines.push_back( "per-event seeds = SplitMix64( seed0, seed1, runID, eventID ) -> RanecuEngine" );
+        lines.push_back( sch.str() );
+        sink->WriteText( "rand_scheme", lines );
+
+        sink->WriteText( "geometry", DescribeGeometry() );
+
+        if( trigger!=0 )
+            sink->WriteText( "trigger", trigger->GetSummary() );
+
+        // Events whose steps were cut at the memory limit.
+        if( !truncated_events.empty() ){
+            lines.clear();
+            for( unsigned int i=0; i<truncated_events.size(); i++ ){
+                std::stringstream tr;
+                tr << truncated_events[i];
+                lines.push_back( tr.str() );
+            }
+            sink->WriteText( "truncated_events", lines );
+        }
+
+        // Final checkpoint, so that resuming a finished file does nothing.
+        Checkpoint( run );
 
-        output_file->Write();
-        output_file->Close();
+        sink->Close();
+        delete sink;
+        sink = 0;
     }
+
+    // Last sample once the output is complete.
+    metrics->EndOfRun();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-TTree* RunAction::GetDataTree(){
-    return data_tree;
+G4bool RunAction::SetRecord( G4String name ){
+
+    const StepInfo::RecordType* type = StepInfo::GetRecordType( name );
+    if( type==0 ){
+        G4cerr << "Unknown step record " << name << ", the records are " << StepInfo::GetRecordNames() << G4endl;
+        return false;
+    }
+
+    if( type!=record_type )
+        G4cout << "Steps will be recorded with the " << name << " record." << G4endl;
+    record_type = type;
+    return true;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::SetPrecision( G4String field, G4String mode, G4double min, G4double max, G4int nbits ){
+
+    // All modes keep a double in memory; Double32_t ('d') decides what is written to the file.
+    std::stringstream ss;
+
+    if( mode=="double" )
+        ss << "D";
+    else if( mode=="float" )
+        ss << "d";
+    else if( mode=="double32" ){
+        // ROOT truncates the mantissa only up to 14 bits, more would be a plain float.
+        if( nbits==0 )
+            nbits = 14;
+        if( nbits<2 || nbits>14 ){
+            G4cerr << "double32 takes 2 to 14 bits of mantissa, not " << nbits << ", " << field << " is left unchanged." << G4endl;
+            return;
+        }
+        ss << "d[0,0," << nbits << "]";
+    }
+    else if( mode=="fixed" ){
+        // With min not below max, ROOT falls back to a float.
+        if( nbits==0 )
+            nbits = 16;
+        if( min>=max ){
+            G4cerr << "fixed needs min below max, " << field << " is left unchanged." << G4endl;
+            return;
+        }
+        ss << "d[" << min << "," << max << "," << nbits << "]";
+    }
+    else if( mode=="off" )
+        ss << "";
+    else{
+        G4cerr << "Unknown precision mode " << mode << " for " << field << ", ignored." << G4endl;
+        return;
+    }
+
+    leaf_types[field] = ss.str();
+    G4cout << "Field " << field << " will be stored as " << mode << " (" << ss.str() << ")" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::EventBuffered( G4int eventID, G4double buffer_bytes, G4double spilled_bytes, G4bool truncated ){
+
+    if( buffer_bytes>peak_buffer ){
+        peak_buffer = buffer_bytes;
+        peak_buffer_event = eventID;
+    }
+    if( spilled_bytes>0 ){
+        nspilled++;
+        peak_spilled = std::max( peak_spilled, spilled_bytes );
+    }
+    if( truncated )
+        truncated_events.push_back( eventID );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::PrintBufferStatistics() const {
+
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+
+    G4cout << "Step buffer: peak " << peak_buffer/1048576 << " MB";
+    if( peak_buffer_event>=0 )
+        G4cout << " (event " << peak_buffer_event << ")";
+    if( max_event_memory>0 )
+        G4cout << ", limit " << max_event_memory/1048576 << " MB";
+    G4cout << G4endl;
+
+    if( nspilled>0 )
+        G4cout << "    " << nspilled << " events spilled to disk, largest " << peak_spilled/1048576 << " MB" << G4endl;
+    if( !truncated_events.empty() )
+        G4cout << "    " << truncated_events.size() << " events truncated at the limit" << G4endl;
+
+    // ru_maxrss is in kB on Linux.
+    G4cout << "    process peak RSS " << usage.ru_maxrss/1024. << " MB" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::EventCompleted( const G4Event* event, G4int nsteps, G4bool accepted ){
+
+    if( tabulating )
+        return;
+
+    // Events without primaries are the ones skipped when resuming past the end of the run.
+    if( event->GetNumberOfPrimaryVertex()==0 )
+        return;
+
+    if( event->GetEventID()+1 > completed_events )
+        completed_events = event->GetEventID()+1;
+
+    run_events++;
+    run_primaries += generator!=0 ? generator->GetEventPrimaries() : 1;
+
+    metrics->EventDone( nsteps, accepted );
+
+    // Soft abort: the run ends after this event, with the usual end of run.
+    if( convergence!=0 && convergence->EndOfEvent() )
+        G4RunManager::GetRunManager()->AbortRun( true );
+
+    events_since_checkpoint++;
+    if( checkpoint_interval>0 && events_since_checkpoint>=checkpoint_interval ){
+        Checkpoint( G4RunManager::GetRunManager()->GetCurrentRun() );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::Checkpoint( const G4Run* run ){
+
+    events_since_checkpoint = 0;
+
+    if( sink==0 )
+        return;
+
+    std::vector< std::string > lines;
+    std::stringstream ss;
+
+    ss << "completed " << completed_events;
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "runID " << ( run ? run->GetRunID() : 0 );
+    lines.push_back( ss.str() );
+
+    // With per-event reseeding the engine state follows from the event number,
+    // but it is kept for reference.
+    ss.str("");
+    G4Random::getTheEngine()->put( ss );
+    lines.push_back( "engine" );
+    std::string line;
+    while( std::getline( ss, line ) ){
+        lines.push_back( line );
+    }
+
+    sink->Checkpoint( completed_events, lines );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// The nine elements of a rotation on one line.
+static void StreamRotation( std::ostream& os, const G4RotationMatrix& r ){
+    os << '(' << r.xx() << ',' << r.xy() << ',' << r.xz() << ','
+       << r.yx() << ',' << r.yy() << ',' << r.yz() << ','
+       << r.zx() << ',' << r.zy() << ',' << r.zz() << ')';
+}
+
+std::vector< std::string > RunAction::DescribeGeometry() const {
+
+    std::vector< std::string > geo;
+    std::stringstream ss;
+
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( size_t i=0; i<store->size(); i++ ){
+        G4VPhysicalVolume* pv = (*store)[i];
+        G4LogicalVolume* lv = pv->GetLogicalVolume();
+
+        // getline below leaves eof set, which str("") does not clear.
+        ss.str("");
+        ss.clear();
+        G4String mother = pv->GetMotherLogical() ? pv->GetMotherLogical()->GetName() : G4String("none");
+
+        // The translation and copy number of a parameterised or replicated volume are
+        // those of the copy navigated last, the copies are described instead.
+        if( pv->IsParameterised() || pv->IsReplicated() ){
+            ss << pv->GetName() << "\tcopies " << pv->GetMultiplicity() << '\t' << mother << '\t' << lv->GetMaterial()->GetName();
+            geo.push_back( ss.str() );
+
+            const DetectorArrayParameterisation* array = dynamic_cast<const DetectorArrayParameterisation*>( pv->GetParameterisation() );
+            if( array!=0 ){
+                for( G4int k=0; k<array->GetNumberOfElements(); k++ ){
+                    ss.str("");
+                    ss.clear();
+                    ss << "copy " << k << '\t' << array->GetPosition( k ) << '\t';
+                    StreamRotation( ss, array->GetRotation( k ) );
+                    geo.push_back( ss.str() );
+                }
+            }
+            else if( pv->IsReplicated() && !pv->IsParameterised() ){
+                EAxis axis;
+                G4int n;
+                G4double width, offset;
+                G4bool consuming;
+                pv->GetReplicationData( axis, n, width, offset, consuming );
+                ss.str("");
+                ss.clear();
+                ss << "replica " << axis << ' ' << n << ' ' << width << ' ' << offset;
+                geo.push_back( ss.str() );
+            }
+        }
+        else{
+            // The rotation too, a volume turned in place is another geometry.
+            ss << pv->GetName() << '\t' << pv->GetCopyNo() << '\t' << mother << '\t'
+               << lv->GetMaterial()->GetName() << '\t' << pv->GetTranslation() << '\t';
+            StreamRotation( ss, pv->GetObjectRotationValue() );
+            geo.push_back( ss.str() );
+        }
+
+        ss.str("");
+        ss.clear();
+        lv->GetSolid()->StreamInfo( ss );
+        std::string line;
+        while( std::getline( ss, line ) ){
+            geo.push_back( line );
+        }
+    }
+
+    const G4VModularPhysicsList* physics = dynamic_cast<const G4VModularPhysicsList*>( G4RunManager::GetRunManager()->GetUserPhysicsList() );
+    if( physics ){
+        G4int i = 0;
+        while( const G4VPhysicsConstructor* ctor = physics->GetPhysics( i++ ) ){
+            ss.str("");
+            ss.clear();
+            ss << "physics " << ctor->GetPhysicsName();
+            geo.push_back( ss.str() );
+        }
+    }
+
+    return geo;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
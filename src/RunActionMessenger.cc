@@ -0,0 +1,164 @@
+// $Id: RunActionMessenger.cc $
+//
+/// \file RunActionMessenger.cc
+/// \brief Definition of the RunActionMessenger class
+
+#include "RunActionMessenger.hh"
+#include "RunAction.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
+
+RunActionMessenger::RunActionMessenger( RunAction* action ) : G4UImessenger(), run_action( action ){
+
+    directory = new G4UIdirectory( "/output/" );
+    directory->SetGuidance( "Output file control." );
+
+    checkpointCmd = new G4UIcmdWithAnInteger( "/output/checkpoint", this );
+    checkpointCmd->SetGuidance( "Save the output tree, the RNG state and the number of completed events every N events." );
+    checkpointCmd->SetGuidance( "A run interrupted after a checkpoint can be continued with the --resume flag. 0 disables checkpoints." );
+    checkpointCmd->SetParameterName( "N", false );
+    checkpointCmd->SetRange( "N>=0" );
+    checkpointCmd->SetDefaultValue( 0 );
+    checkpointCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    formatCmd = new G4UIcmdWithAString( "/output/format", this );
+    formatCmd->SetGuidance( "Output backend." );
+    formatCmd->SetGuidance( "root: ROOT trees in the layout set by /output/schema." );
+    formatCmd->SetGuidance( "flat: header, fixed-size step records and event index, to be memory-mapped by analysis tools." );
+    formatCmd->SetGuidance( "null: discard everything, to measure the speed of the simulation alone." );
+    formatCmd->SetParameterName( "format", false );
+    formatCmd->SetCandidates( "root flat null" );
+    formatCmd->SetDefaultValue( "root" );
+    formatCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    schemaCmd = new G4UIcmdWithAString( "/output/schema", this );
+    schemaCmd->SetGuidance( "Layout of the output trees." );
+    schemaCmd->SetGuidance( "step: one entry per step in the events tree (default)." );
+    schemaCmd->SetGuidance( "track: per-track constants in the tracks tree, per-step kinematics in the steps tree." );
+    schemaCmd->SetGuidance( "event: one entry per event in the events tree, with an array of nsteps values per field." );
+    schemaCmd->SetParameterName( "schema", false );
+    schemaCmd->SetCandidates( "event step track" );
+    schemaCmd->SetDefaultValue( "step" );
+    schemaCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    recordCmd = new G4UIcmdWithAString( "/output/record", this );
+    recordCmd->SetGuidance( "Fields computed and written for every recorded step. The IDs are always recorded." );
+    recordCmd->SetGuidance( "full: all the fields (default)." );
+    recordCmd->SetGuidance( "calorimetric: volume, copy number, position, time and deposited energy." );
+    recordCmd->SetGuidance( "xray: particle, volume, copy number, process, position, direction, initial and deposited energy." );
+    recordCmd->SetParameterName( "record", false );
+    recordCmd->SetCandidates( StepInfo::GetRecordNames() );
+    recordCmd->SetDefaultValue( "full" );
+    recordCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    precisionCmd = new G4UIcommand( "/output/precision", this );
+    precisionCmd->SetGuidance( "Set how a kinematic field (x y z theta phi px py pz t Eki Ekf Edep) is stored." );
+    precisionCmd->SetGuidance( "double: 8-byte double (default). float: 4-byte float." );
+    precisionCmd->SetGuidance( "double32: float with nbits (2 to 14, default 14) of mantissa." );
+    precisionCmd->SetGuidance( "fixed: nbits (2 to 32, default 16) integer over [min,max], min below max." );
+    precisionCmd->SetGuidance( "off: the field is not written. Ranges are in Geant4 internal units (mm, ns, MeV)." );
+    precisionCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "field", 's', false );
+    param->SetParameterCandidates( "x y z theta phi px py pz t Eki Ekf Edep" );
+    precisionCmd->SetParameter( param );
+
+    param = new G4UIparameter( "mode", 's', false );
+    param->SetParameterCandidates( "double float double32 fixed off" );
+    precisionCmd->SetParameter( param );
+
+    param = new G4UIparameter( "min", 'd', true );
+    param->SetDefaultValue( 0. );
+    precisionCmd->SetParameter( param );
+
+    param = new G4UIparameter( "max", 'd', true );
+    param->SetDefaultValue( 0. );
+    precisionCmd->SetParameter( param );
+
+    param = new G4UIparameter( "nbits", 'i', true );
+    param->SetDefaultValue( 0 );
+        // the default of the mode
+    param->SetParameterRange( "nbits==0 || ( nbits>=2 && nbits<=32 )" );
+    precisionCmd->SetParameter( param );
+
+    memoryCmd = new G4UIcommand( "/output/maxEventMemory", this );
+    memoryCmd->SetGuidance( "Memory allowed for the steps of one event. 0 (default) means no limit." );
+    memoryCmd->SetGuidance( "The steps are counted with the memory of their particle, volume and process names." );
+    memoryCmd->SetGuidance( "What happens past the limit is set by /output/overflow." );
+    memoryCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    param = new G4UIparameter( "size", 'd', false );
+    param->SetParameterRange( "size>=0" );
+    memoryCmd->SetParameter( param );
+
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetParameterCandidates( "kB MB GB" );
+    param->SetDefaultValue( "MB" );
+    memoryCmd->SetParameter( param );
+
+    overflowCmd = new G4UIcmdWithAString( "/output/overflow", this );
+    overflowCmd->SetGuidance( "Steps of an event past /output/maxEventMemory." );
+    overflowCmd->SetGuidance( "spill: write them to a temporary file and stream them to the output at the end of the event." );
+    overflowCmd->SetGuidance( "      Needs the step or track schema or the flat format, the event schema truncates instead." );
+    overflowCmd->SetGuidance( "truncate: drop them. The IDs of truncated events are stored in truncated_events." );
+    overflowCmd->SetParameterName( "mode", false );
+    overflowCmd->SetCandidates( "spill truncate" );
+    overflowCmd->SetDefaultValue( "spill" );
+    overflowCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+RunActionMessenger::~RunActionMessenger(){
+    delete checkpointCmd;
+    delete formatCmd;
+    delete schemaCmd;
+    delete recordCmd;
+    delete precisionCmd;
+    delete memoryCmd;
+    delete overflowCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void RunActionMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==checkpointCmd ){
+        run_action->SetCheckpointInterval( checkpointCmd->GetNewIntValue( newValue ) );
+    }
+    else if( command==formatCmd ){
+        run_action->SetFormat( newValue );
+    }
+    else if( command==schemaCmd ){
+        run_action->SetSchema( newValue );
+    }
+    else if( command==recordCmd ){
+        run_action->SetRecord( newValue );
+    }
+    else if( command==precisionCmd ){
+        std::istringstream is( newValue );
+        G4String field, mode;
+        G4double min = 0, max = 0;
+        G4int nbits = 0;
+        is >> field >> mode >> min >> max >> nbits;
+        run_action->SetPrecision( field, mode, min, max, nbits );
+    }
+    else if( command==memoryCmd ){
+        std::istringstream is( newValue );
+        G4double size = 0;
+        G4String unit = "MB";
+        is >> size >> unit;
+        G4double scale = unit=="GB" ? 1073741824. : unit=="kB" ? 1024. : 1048576.;
+        run_action->SetMaxEventMemory( size*scale );
+    }
+    else if( command==overflowCmd ){
+        run_action->SetOverflowMode( newValue );
+    }
+    return;
+}
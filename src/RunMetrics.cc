@@ -0,0 +1,296 @@
+/// \file RunMetrics.cc
+/// \brief Implementation of the RunMetrics class
+
+#include "RunMetrics.hh"
+#include "RunMetricsMessenger.hh"
+
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMetrics::RunMetrics() :
+    messenger( 0 ),
+    file_name( "" ),
+    socket_name( "" ),
+    interval( 1*s ),
+    print_interval( 1*s ),
+    run_id( 0 ),
+    total_events( 0 ),
+    output_name( "" ),
+    events( 0 ),
+    steps( 0 ),
+    accepted_events( 0 ),
+    listen_fd( -1 ),
+    sampled_events( 0 ),
+    sampled_steps( 0 ),
+    sampled_time( 0 )
+{
+    wake_pipe[0] = wake_pipe[1] = -1;
+    messenger = new RunMetricsMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMetrics::~RunMetrics(){
+    EndOfRun();
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::BeginOfRun( G4int runID, G4int nevents, G4String output ){
+
+    EndOfRun();
+
+    run_id = runID;
+    total_events = nevents;
+    output_name = output;
+
+    events = 0;
+    steps = 0;
+    accepted_events = 0;
+
+    start = std::chrono::steady_clock::now();
+    last_print = std::chrono::steady_clock::time_point();
+
+    sampled_events = 0;
+    sampled_steps = 0;
+    sampled_time = 0;
+    json = "";
+
+    if( file_name=="" && socket_name=="" )
+        return;
+
+    if( socket_name!="" && !OpenSocket() )
+        G4cerr << "Cannot listen on " << socket_name << ", the metrics are not served there." << G4endl;
+
+    if( pipe( wake_pipe )!=0 ){
+        G4cerr << "Cannot start the metrics thread." << G4endl;
+        CloseSocket();
+        return;
+    }
+
+    G4cout << "Run metrics every " << interval/s << " s";
+    if( file_name!="" )
+        G4cout << " in " << file_name;
+    if( listen_fd>=0 )
+        G4cout << " on the socket " << socket_name;
+    G4cout << G4endl;
+
+    thread = std::thread( &RunMetrics::Loop, this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::EndOfRun(){
+
+    if( !thread.joinable() )
+        return;
+
+    char c = 0;
+    if( write( wake_pipe[1], &c, 1 )!=1 )
+        G4cerr << "Cannot wake the metrics thread." << G4endl;
+    thread.join();
+
+    close( wake_pipe[0] );
+    close( wake_pipe[1] );
+    wake_pipe[0] = wake_pipe[1] = -1;
+
+    // The thread is gone, the last sample is taken here.
+    Sample( true );
+    CloseSocket();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::Loop(){
+
+    std::chrono::steady_clock::duration period = std::chrono::nanoseconds( std::max( (long long)( interval/ns ), 1000000LL ) );
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + period;
+
+    Sample( false );
+
+    while( true ){
+
+        struct pollfd fds[2];
+        fds[0].fd = wake_pipe[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = listen_fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        int timeout = next>now ? std::chrono::duration_cast<std::chrono::milliseconds>( next-now ).count()+1 : 0;
+
+        int n = poll( fds, listen_fd>=0 ? 2 : 1, timeout );
+        if( n<0 && errno!=EINTR )
+            return;
+
+        if( fds[0].revents!=0 )
+            return;
+
+        if( listen_fd>=0 && ( fds[1].revents & POLLIN ) )
+            Serve();
+
+        now = std::chrono::steady_clock::now();
+        if( now>=next ){
+            Sample( false );
+            next += period;
+            if( next<now )
+                next = now + period;
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::Sample( G4bool finished ){
+
+    G4double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now()-start ).count();
+    long long e = events.load( std::memory_order_relaxed );
+    long long st = steps.load( std::memory_order_relaxed );
+    long long a = accepted_events.load( std::memory_order_relaxed );
+
+    // Rates over the last interval, over the whole run for the final sample.
+    G4double dt = finished ? elapsed : elapsed-sampled_time;
+    G4double event_rate = dt>0 ? ( e - ( finished ? 0 : sampled_events ) )/dt : 0;
+    G4double step_rate = dt>0 ? ( st - ( finished ? 0 : sampled_steps ) )/dt : 0;
+
+    sampled_events = e;
+    sampled_steps = st;
+    sampled_time = elapsed;
+
+    G4double eta = !finished && event_rate>0 && total_events>e ? ( total_events-e )/event_rate : 0;
+
+    struct stat info;
+    long long bytes = output_name!="" && stat( output_name.c_str(), &info )==0 ? info.st_size : 0;
+
+    // Second field of statm: resident pages.
+    long long pages = 0, resident = 0;
+    std::ifstream statm( "/proc/self/statm" );
+    statm >> pages >> resident;
+    long long rss = resident*sysconf( _SC_PAGESIZE );
+
+    std::ostringstream ss;
+    ss << "{\"run\": " << run_id
+       << ", \"finished\": " << ( finished ? "true" : "false" )
+       << ", \"elapsed_s\": " << elapsed
+       << ", \"events\": " << e
+       << ", \"events_total\": " << total_events
+       << ", \"accepted\": " << a
+       << ", \"steps\": " << st
+       << ", \"events_per_s\": " << event_rate
+       << ", \"steps_per_s\": " << step_rate
+       << ", \"bytes_written\": " << bytes
+       << ", \"rss_bytes\": " << rss
+       << ", \"eta_s\": " << eta << "}\n";
+    json = ss.str();
+
+    if( file_name=="" )
+        return;
+
+    std::string tmp = file_name + ".tmp";
+    FILE* f = fopen( tmp.c_str(), "w" );
+    if( f==0 )
+        return;
+    G4bool ok = fwrite( json.data(), 1, json.size(), f )==json.size();
+    ok = fclose( f )==0 && ok;
+    if( ok )
+        rename( tmp.c_str(), file_name.c_str() );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::Serve(){
+
+    // The listening socket is non-blocking: accept until nothing is pending.
+    int fd;
+    while( ( fd = accept( listen_fd, 0, 0 ) )>=0 ){
+        send( fd, json.data(), json.size(), MSG_NOSIGNAL );
+        close( fd );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RunMetrics::OpenSocket(){
+
+    struct sockaddr_un addr;
+    if( socket_name.size()>=sizeof( addr.sun_path ) )
+        return false;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    strncpy( addr.sun_path, socket_name.c_str(), sizeof( addr.sun_path )-1 );
+
+    listen_fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( listen_fd<0 )
+        return false;
+
+    // A socket left by an earlier job is replaced.
+    unlink( socket_name.c_str() );
+    if( bind( listen_fd, (struct sockaddr*)&addr, sizeof( addr ) )!=0 || listen( listen_fd, 8 )!=0
+            || fcntl( listen_fd, F_SETFL, fcntl( listen_fd, F_GETFL )|O_NONBLOCK )!=0 ){
+        close( listen_fd );
+        listen_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::CloseSocket(){
+
+    if( listen_fd<0 )
+        return;
+
+    close( listen_fd );
+    listen_fd = -1;
+    unlink( socket_name.c_str() );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMetrics::PrintProgress( G4int eventID ){
+
+    G4int modulo = G4RunManager::GetRunManager()->GetPrintProgress();
+    if( modulo<=0 || eventID%modulo!=0 )
+        return;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if( print_interval>0 && std::chrono::duration<double>( now-last_print ).count()*s<print_interval )
+        return;
+    last_print = now;
+
+    G4double elapsed = std::chrono::duration<double>( now-start ).count();
+    long long e = events.load( std::memory_order_relaxed );
+    G4double rate = elapsed>0 ? e/elapsed : 0;
+
+    G4cout << "---> End of event: " << eventID;
+    if( rate>0 ){
+        G4cout << " (" << rate << " events/s";
+        if( total_events>e )
+            G4cout << ", " << ( total_events-e )/rate << " s left";
+        G4cout << ")";
+    }
+    G4cout << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,74 @@
+// $Id: RunMetricsMessenger.cc $
+//
+/// \file RunMetricsMessenger.cc
+/// \brief Definition of the RunMetricsMessenger class
+
+#include "RunMetricsMessenger.hh"
+#include "RunMetrics.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+RunMetricsMessenger::RunMetricsMessenger( RunMetrics* m ) : G4UImessenger(), metrics( m ){
+
+    directory = new G4UIdirectory( "/metrics/" );
+    directory->SetGuidance( "Live metrics of the run: event and step rates, accepted events, bytes written, RSS and time left." );
+
+    fileCmd = new G4UIcmdWithAString( "/metrics/file", this );
+    fileCmd->SetGuidance( "JSON file rewritten with the metrics at every sample, none to disable." );
+    fileCmd->SetParameterName( "file", false );
+    fileCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    socketCmd = new G4UIcmdWithAString( "/metrics/socket", this );
+    socketCmd->SetGuidance( "Unix socket answering every connection with the metrics of the last sample, none to disable." );
+    socketCmd->SetGuidance( "Read it with e.g. nc -U <socket>." );
+    socketCmd->SetParameterName( "socket", false );
+    socketCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    intervalCmd = new G4UIcmdWithADoubleAndUnit( "/metrics/interval", this );
+    intervalCmd->SetGuidance( "Sampling period of the metrics (default 1 s)." );
+    intervalCmd->SetParameterName( "interval", false );
+    intervalCmd->SetRange( "interval>0" );
+    intervalCmd->SetUnitCategory( "Time" );
+    intervalCmd->SetDefaultUnit( "s" );
+    intervalCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    printCmd = new G4UIcmdWithADoubleAndUnit( "/metrics/printInterval", this );
+    printCmd->SetGuidance( "Shortest time between two progress lines of /run/printProgress (default 1 s), 0 for no limit." );
+    printCmd->SetParameterName( "interval", false );
+    printCmd->SetRange( "interval>=0" );
+    printCmd->SetUnitCategory( "Time" );
+    printCmd->SetDefaultUnit( "s" );
+    printCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+RunMetricsMessenger::~RunMetricsMessenger(){
+    delete fileCmd;
+    delete socketCmd;
+    delete intervalCmd;
+    delete printCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void RunMetricsMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==fileCmd ){
+        metrics->SetFile( newValue=="none" ? G4String( "" ) : newValue );
+    }
+    else if( command==socketCmd ){
+        metrics->SetSocket( newValue=="none" ? G4String( "" ) : newValue );
+    }
+    else if( command==intervalCmd ){
+        metrics->SetInterval( intervalCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==printCmd ){
+        metrics->SetPrintInterval( printCmd->GetNewDoubleValue( newValue ) );
+    }
+    return;
+}
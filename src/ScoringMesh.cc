@@ -0,0 +1,318 @@
+/// \file ScoringMesh.cc
+/// \brief Implementation of the ScoringMesh class
+
+#include "ScoringMesh.hh"
+#include "ScoringMeshMessenger.hh"
+#include "OutputSink.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Material.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4AffineTransform.hh"
+#include "G4Gamma.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace{
+
+    // Key of a voxel: 10 bits of volume and 18 bits per voxel index, offset to be
+    // positive, i.e. 2^17 voxels on each side of the origin.
+    const G4int kIndexBits = 18;
+    const G4int kIndexOffset = 1<<( kIndexBits-1 );
+    const uint64_t kIndexMask = ( uint64_t( 1 )<<kIndexBits )-1;
+    const G4int kMaxVolumes = 1<<( 64-3*kIndexBits );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ScoringMesh::ScoringMesh() :
+    messenger( 0 ),
+    voxel_size( 10*um, 10*um, 10*um ),
+    frame( "local" ),
+    active( false ),
+    sink( 0 ),
+    last_track( -1 ),
+    last_key( 0 ),
+    outside( 0 )
+{
+    messenger = new ScoringMeshMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ScoringMesh::~ScoringMesh(){
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::AddVolume( G4String pattern ){
+    patterns.push_back( pattern );
+    volume_index.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::ClearVolumes(){
+    patterns.clear();
+    volume_index.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int ScoringMesh::GetVolume( const G4LogicalVolume* lv ){
+
+    std::unordered_map<const G4LogicalVolume*, G4int>::const_iterator it = volume_index.find( lv );
+    if( it!=volume_index.end() )
+        return it->second;
+
+    const G4String& name = lv->GetName();
+    G4bool match = false;
+    for( size_t i=0; i<patterns.size() && !match; i++ )
+        match = MatchesVolumePattern( patterns[i], name );
+
+    G4int index = -1;
+    if( match && G4int( volumes.size() )<kMaxVolumes ){
+        // The targets share the name of their logical volume, the material tells them apart.
+        index = volumes.size();
+        volumes.push_back( name + " " + ( lv->GetMaterial()!=0 ? lv->GetMaterial()->GetName() : G4String( "" ) ) );
+    }
+    else if( match )
+        G4cerr << "Too many volumes in the scoring mesh, " << name << " is not scored." << G4endl;
+
+    volume_index[lv] = index;
+    return index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ScoringMesh::GetKey( G4int volume, const G4ThreeVector& p, uint64_t& key ) const {
+
+    G4double i[3] = { std::floor( p.x()/voxel_size.x() ), std::floor( p.y()/voxel_size.y() ), std::floor( p.z()/voxel_size.z() ) };
+
+    key = uint64_t( volume );
+    for( G4int k=0; k<3; k++ ){
+        if( i[k]<-kIndexOffset || i[k]>=kIndexOffset )
+            return false;
+        key = ( key<<kIndexBits ) | uint64_t( G4int( i[k] )+kIndexOffset );
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::GetIndices( uint64_t key, G4int& volume, G4int& ix, G4int& iy, G4int& iz ) const {
+    iz = G4int( key & kIndexMask )-kIndexOffset;
+    iy = G4int( ( key>>kIndexBits ) & kIndexMask )-kIndexOffset;
+    ix = G4int( ( key>>( 2*kIndexBits ) ) & kIndexMask )-kIndexOffset;
+    volume = G4int( key>>( 3*kIndexBits ) );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::BeginOfRun( G4bool a ){
+
+    active = a && IsEnabled();
+
+    voxels.clear();
+    event_edep.clear();
+    last_track = -1;
+    outside = 0;
+
+    // Logical volumes may have been rebuilt since the last run.
+    volume_index.clear();
+    volumes.clear();
+
+    if( active )
+        G4cout << "Scoring mesh of " << G4BestUnit( voxel_size, "Length" ) << "voxels in the " << frame << " frame." << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::ProcessStep( const G4Step* step ){
+
+    if( !active )
+        return;
+
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    const G4VPhysicalVolume* pv = pre->GetPhysicalVolume();
+    if( pv==0 )
+        return;
+
+    G4int volume = GetVolume( pv->GetLogicalVolume() );
+    if( volume<0 )
+        return;
+
+    const G4AffineTransform* transform = 0;
+    if( frame=="local" )
+        transform = &pre->GetTouchable()->GetHistory()->GetTopTransform();
+
+    // Energy and track entries at the middle of the step.
+    G4ThreeVector middle = 0.5*( pre->GetPosition()+step->GetPostStepPoint()->GetPosition() );
+    if( transform!=0 )
+        middle = transform->TransformPoint( middle );
+
+    uint64_t key;
+    if( GetKey( volume, middle, key ) ){
+
+        G4double edep = step->GetTotalEnergyDeposit();
+        if( edep>0 )
+            event_edep[key] += edep;
+
+        G4int track = step->GetTrack()->GetTrackID();
+        if( track!=last_track || key!=last_key ){
+            voxels[key].tracks += 1;
+            last_track = track;
+            last_key = key;
+        }
+    }
+    else
+        outside += 1;
+
+    const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
+    if( secondaries==0 )
+        return;
+
+    const G4ParticleDefinition* gamma = G4Gamma::Definition();
+    for( size_t i=0; i<secondaries->size(); i++ ){
+
+        const G4Track* photon = (*secondaries)[i];
+        if( photon->GetDefinition()!=gamma )
+            continue;
+
+        G4ThreeVector vertex = photon->GetPosition();
+        if( transform!=0 )
+            vertex = transform->TransformPoint( vertex );
+
+        if( GetKey( volume, vertex, key ) )
+            voxels[key].xrays += 1;
+        else
+            outside += 1;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::EndOfEvent(){
+
+    if( !active )
+        return;
+
+    std::unordered_map<uint64_t, G4double>::const_iterator it;
+    for( it=event_edep.begin(); it!=event_edep.end(); ++it ){
+        Voxel& voxel = voxels[it->first];
+        voxel.edep += it->second;
+        voxel.edep2 += it->second*it->second;
+    }
+    event_edep.clear();
+    last_track = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ScoringMesh::EndOfRun( G4int nevents, G4int nprimaries ){
+
+    if( !active )
+        return;
+
+    active = false;
+
+    // Written in the order of the keys, i.e. by volume, x, y then z.
+    std::vector<uint64_t> keys;
+    keys.reserve( voxels.size() );
+    std::unordered_map<uint64_t, Voxel>::const_iterator it;
+    for( it=voxels.begin(); it!=voxels.end(); ++it )
+        keys.push_back( it->first );
+    std::sort( keys.begin(), keys.end() );
+
+    std::vector<G4double> volume_edep( volumes.size(), 0. );
+    std::vector<G4double> volume_tracks( volumes.size(), 0. );
+    std::vector<G4double> volume_xrays( volumes.size(), 0. );
+    std::vector<G4int> volume_voxels( volumes.size(), 0 );
+
+    std::vector<std::string> columns;
+    const char* names[] = { "volume", "ix", "iy", "iz", "x", "y", "z", "edep", "edep_error", "tracks", "xrays" };
+    columns.assign( names, names+11 );
+    std::vector<G4double> row( columns.size() );
+
+    for( size_t k=0; k<keys.size(); k++ ){
+
+        const Voxel& voxel = voxels[keys[k]];
+        G4int volume, ix, iy, iz;
+        GetIndices( keys[k], volume, ix, iy, iz );
+
+        volume_edep[volume] += voxel.edep;
+        volume_tracks[volume] += voxel.tracks;
+        volume_xrays[volume] += voxel.xrays;
+        volume_voxels[volume]++;
+
+        if( sink==0 )
+            continue;
+
+        // Error of the sum over the events, from the spread of the event sums.
+        G4double error = nevents>1 ? std::sqrt( std::max( voxel.edep2 - voxel.edep*voxel.edep/nevents, 0. )*nevents/( nevents-1 ) ) : 0;
+
+        row[0] = volume;
+        row[1] = ix;
+        row[2] = iy;
+        row[3] = iz;
+        row[4] = ( ix+0.5 )*voxel_size.x()/mm;
+        row[5] = ( iy+0.5 )*voxel_size.y()/mm;
+        row[6] = ( iz+0.5 )*voxel_size.z()/mm;
+        row[7] = voxel.edep/MeV;
+        row[8] = error/MeV;
+        row[9] = voxel.tracks;
+        row[10] = voxel.xrays;
+        sink->FillTable( "mesh", columns, row );
+    }
+
+    // Approximate: the voxel and its key per node, with the bucket array.
+    G4double bytes = voxels.size()*( sizeof( Voxel )+sizeof( uint64_t )+2*sizeof( void* ) ) + voxels.bucket_count()*sizeof( void* );
+
+    G4cout << "Scoring mesh, " << voxels.size() << " voxels occupied (" << bytes/1024/1024 << " MB), "
+           << nevents << " events, " << nprimaries << " primaries:" << G4endl;
+    for( size_t i=0; i<volumes.size(); i++ )
+        G4cout << "    " << volumes[i] << ": " << volume_voxels[i] << " voxels, " << G4BestUnit( volume_edep[i], "Energy" )
+               << "deposited, " << volume_tracks[i] << " track entries, " << volume_xrays[i] << " photons created" << G4endl;
+    if( outside>0 )
+        G4cout << "    " << outside << " points beyond the index range of the mesh were not scored." << G4endl;
+
+    // Meaning of the volume codes and of the grid.
+    if( sink!=0 ){
+        std::vector<std::string> lines;
+        for( size_t i=0; i<volumes.size(); i++ ){
+            std::stringstream ss;
+            ss << "volume " << i << ' ' << volumes[i];
+            lines.push_back( ss.str() );
+        }
+        std::stringstream ss;
+        ss << "voxel " << voxel_size.x()/mm << ' ' << voxel_size.y()/mm << ' ' << voxel_size.z()/mm << " mm";
+        lines.push_back( ss.str() );
+        lines.push_back( "frame " + frame );
+        ss.str( "" );
+        ss << "events " << nevents;
+        lines.push_back( ss.str() );
+        ss.str( "" );
+        ss << "primaries " << nprimaries;
+        lines.push_back( ss.str() );
+        sink->WriteText( "mesh_info", lines );
+    }
+
+    sink = 0;
+
+    // The memory is given back.
+    std::unordered_map<uint64_t, Voxel>().swap( voxels );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
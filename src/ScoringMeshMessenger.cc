@@ -0,0 +1,75 @@
+// $Id: ScoringMeshMessenger.cc $
+//
+/// \file ScoringMeshMessenger.cc
+/// \brief Definition of the ScoringMeshMessenger class
+
+#include "ScoringMeshMessenger.hh"
+#include "ScoringMesh.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+ScoringMeshMessenger::ScoringMeshMessenger( ScoringMesh* m ) : G4UImessenger(), mesh( m ){
+
+    directory = new G4UIdirectory( "/mesh/" );
+    directory->SetGuidance( "Sparse 3D scoring mesh: energy deposited, track entries and photons created per voxel." );
+    directory->SetGuidance( "Only the voxels hit are stored. The mesh is written at the end of the run in the mesh table." );
+    directory->SetGuidance( "The mesh is not checkpointed: with --resume it covers only the events after the checkpoint." );
+
+    volumeCmd = new G4UIcmdWithAString( "/mesh/volume", this );
+    volumeCmd->SetGuidance( "Attach the mesh to the logical volumes of this name, e.g. target_lv or det_lv." );
+    volumeCmd->SetGuidance( "A trailing * matches any suffix. The command can be repeated for several names." );
+    volumeCmd->SetParameterName( "volume", false );
+    volumeCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    clearCmd = new G4UIcmdWithoutParameter( "/mesh/clear", this );
+    clearCmd->SetGuidance( "Detach the mesh from all the volumes, which disables it." );
+    clearCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    voxelCmd = new G4UIcmdWith3VectorAndUnit( "/mesh/voxel", this );
+    voxelCmd->SetGuidance( "Size of the voxels along x, y and z (default 10 um)." );
+    voxelCmd->SetParameterName( "dx", "dy", "dz", false );
+    voxelCmd->SetRange( "dx>0 && dy>0 && dz>0" );
+    voxelCmd->SetUnitCategory( "Length" );
+    voxelCmd->SetDefaultUnit( "um" );
+    voxelCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    frameCmd = new G4UIcmdWithAString( "/mesh/frame", this );
+    frameCmd->SetGuidance( "Frame of the grid: local, with the origin at the centre of each volume (default), or world." );
+    frameCmd->SetGuidance( "In the local frame the copies of a volume are summed in the same voxels." );
+    frameCmd->SetParameterName( "frame", false );
+    frameCmd->SetCandidates( "local world" );
+    frameCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+ScoringMeshMessenger::~ScoringMeshMessenger(){
+    delete volumeCmd;
+    delete clearCmd;
+    delete voxelCmd;
+    delete frameCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void ScoringMeshMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==volumeCmd ){
+        mesh->AddVolume( newValue );
+    }
+    else if( command==clearCmd ){
+        mesh->ClearVolumes();
+    }
+    else if( command==voxelCmd ){
+        mesh->SetVoxelSize( voxelCmd->GetNew3VectorValue( newValue ) );
+    }
+    else if( command==frameCmd ){
+        mesh->SetFrame( newValue );
+    }
+    return;
+}
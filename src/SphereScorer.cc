@@ -0,0 +1,135 @@
+/// \file SphereScorer.cc
+/// \brief Implementation of the SphereScorer class
+
+#include "SphereScorer.hh"
+#include "OutputSink.hh"
+
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SphereScorer::SphereScorer( G4String name ) :
+    G4VSensitiveDetector( name ),
+    center( 0, 0, 0 ),
+    placed( false ),
+    ntheta( 180 ),
+    nphi( 360 ),
+    nE( 1000 ),
+    Emin( 0 ),
+    Emax( 10*MeV )
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SphereScorer::~SphereScorer(){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SphereScorer::SetBinning( G4int nt, G4int np, G4int ne, G4double emin, G4double emax ){
+    ntheta = nt;
+    nphi = np;
+    nE = ne;
+    Emin = emin;
+    Emax = emax;
+    histograms.clear();
+    particle_index.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int SphereScorer::Bin( G4double x, G4double min, G4double max, G4int n ){
+    if( x<min )
+        return 0;
+    if( x>=max )
+        return n+1;
+    return 1 + G4int( ( x-min )/( max-min )*n );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SphereScorer::ProcessHits( G4Step* step, G4TouchableHistory* ){
+
+    // Only the first step in the shell, and only particles going outwards.
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    if( pre->GetStepStatus()!=fGeomBoundary )
+        return false;
+
+    G4ThreeVector r = pre->GetPosition() - center;
+    if( r.dot( pre->GetMomentumDirection() )<=0 )
+        return false;
+
+    const G4ParticleDefinition* particle = step->GetTrack()->GetDefinition();
+    std::map<const G4ParticleDefinition*, size_t>::iterator it = particle_index.find( particle );
+    if( it==particle_index.end() ){
+        Histograms h;
+        h.particle = particle->GetParticleName();
+        h.theta_phi.assign( ( ntheta+2 )*( nphi+2 ), 0. );
+        h.theta_E.assign( ( ntheta+2 )*( nE+2 ), 0. );
+        h.crossings = 0;
+        histograms.push_back( h );
+        it = particle_index.insert( std::make_pair( particle, histograms.size()-1 ) ).first;
+    }
+
+    Histograms& h = histograms[it->second];
+
+    G4int it_bin = Bin( r.theta(), 0, pi, ntheta );
+    G4int ip_bin = Bin( r.phi(), -pi, pi, nphi );
+    G4int ie_bin = Bin( pre->GetKineticEnergy(), Emin, Emax, nE );
+
+    G4double w = pre->GetWeight();
+    h.theta_phi[ it_bin + ( ntheta+2 )*ip_bin ] += w;
+    h.theta_E[ it_bin + ( ntheta+2 )*ie_bin ] += w;
+    h.crossings += w;
+
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SphereScorer::BeginOfRun(){
+    histograms.clear();
+    particle_index.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SphereScorer::EndOfRun( OutputSink* sink, G4int nprimaries ){
+
+    G4cout << "Scoring sphere crossings (" << nprimaries << " primaries):" << G4endl;
+
+    for( size_t k=0; k<histograms.size(); k++ ){
+
+        Histograms& h = histograms[k];
+        G4cout << "    " << h.particle << ": " << h.crossings << G4endl;
+
+        if( sink==0 )
+            continue;
+
+        // Projections, with the under- and overflows of the other axis included.
+        std::vector<G4double> theta( ntheta+2, 0. ), phi( nphi+2, 0. ), energy( nE+2, 0. );
+        for( G4int i=0; i<ntheta+2; i++ ){
+            for( G4int j=0; j<nphi+2; j++ ){
+                theta[i] += h.theta_phi[ i + ( ntheta+2 )*j ];
+                phi[j] += h.theta_phi[ i + ( ntheta+2 )*j ];
+            }
+            for( G4int j=0; j<nE+2; j++ )
+                energy[j] += h.theta_E[ i + ( ntheta+2 )*j ];
+        }
+
+        G4String name = "sphere_" + h.particle;
+        sink->WriteHistogram2D( name+"_theta_phi", h.particle+" crossing the scoring sphere;#theta (rad);#phi (rad)",
+                                ntheta, 0, pi, nphi, -pi, pi, h.theta_phi );
+        sink->WriteHistogram2D( name+"_theta_E", h.particle+" crossing the scoring sphere;#theta (rad);E (MeV)",
+                                ntheta, 0, pi, nE, Emin, Emax, h.theta_E );
+        sink->WriteHistogram( name+"_theta", h.particle+" crossing the scoring sphere;#theta (rad)", 0, pi, theta );
+        sink->WriteHistogram( name+"_phi", h.particle+" crossing the scoring sphere;#phi (rad)", -pi, pi, phi );
+        sink->WriteHistogram( name+"_E", h.particle+" crossing the scoring sphere;E (MeV)", Emin, Emax, energy );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,32 @@
+//
+/// \file /src/StackingAction.cc
+/// \brief Implementation of the StackingAction class
+
+#include "StackingAction.hh"
+#include "XrayTally.hh"
+#include "DecaySource.hh"
+
+#include "G4Track.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::StackingAction( XrayTally* tally, DecaySource* decay )
+  : G4UserStackingAction(),
+    fXrayTally( tally ),
+    fDecaySource( decay ){
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack( const G4Track* track ){
+
+    if( fDecaySource->IsTabulating() )
+        return fDecaySource->Record( track ) ? fUrgent : fKill;
+
+    if( track->GetParentID()>0 && fXrayTally->IsYieldOnly() )
+        return fKill;
+
+    return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
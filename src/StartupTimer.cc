@@ -0,0 +1,76 @@
+/// \file StartupTimer.cc
+/// \brief Implementation of the StartupTimer class
+
+#include "StartupTimer.hh"
+
+#include "G4StateManager.hh"
+
+#include <iomanip>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StartupTimer::StartupTimer() :
+    G4VStateDependent(),
+    start( std::chrono::steady_clock::now() ),
+    last( start ),
+    state( G4StateManager::GetStateManager()->GetCurrentState() ),
+    initialized( false ),
+    printed( false )
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StartupTimer::~StartupTimer(){
+    if( !printed )
+        Print();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupTimer::Mark( G4String phase ){
+
+    if( printed )
+        return;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    phases.push_back( std::make_pair( phase, std::chrono::duration<double>( now-last ).count() ) );
+    last = now;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StartupTimer::Notify( G4ApplicationState requested ){
+
+    if( state==G4State_PreInit && requested==G4State_Init )
+        Mark( "commands before /run/initialize" );
+    else if( state==G4State_Init && requested==G4State_Idle ){
+        Mark( initialized ? "physics tables and voxels" : "physics list" );
+        initialized = true;
+    }
+    else if( state==G4State_Idle && requested==G4State_Init && initialized )
+        Mark( "commands before /run/beamOn" );
+    else if( state==G4State_GeomClosed && requested==G4State_EventProc && !printed ){
+        Mark( "start of the run" );
+        Print();
+    }
+
+    state = requested;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupTimer::Print(){
+
+    printed = true;
+
+    G4double total = std::chrono::duration<double>( last-start ).count();
+
+    G4cout << "Startup time " << total << " s:" << G4endl;
+    for( unsigned int i=0; i<phases.size(); i++ )
+        G4cout << "    " << std::left << std::setw( 36 ) << phases[i].first << std::right << std::setw( 12 ) << phases[i].second
+               << " s" << std::setw( 8 ) << std::setprecision( 3 ) << ( total>0 ? 100*phases[i].second/total : 0 )
+               << std::setprecision( 6 ) << " %" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,204 @@
+/// \file StepFilter.cc
+/// \brief Implementation of the StepFilter class
+
+#include "StepFilter.hh"
+#include "StepFilterMessenger.hh"
+#include "GeometryUtils.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Region.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4UnitsTable.hh"
+
+#include <cfloat>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepFilter::StepFilter() :
+    messenger( 0 ),
+    active( false ),
+    min_edep( -DBL_MAX ),
+    ekin_min( -DBL_MAX ),
+    ekin_max( DBL_MAX ),
+    nseen( 0 ),
+    nrecorded( 0 )
+{
+    messenger = new StepFilterMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepFilter::~StepFilter(){
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepFilter::Include( Key key, G4String pattern ){
+    lists[key].include.push_back( pattern );
+    active = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepFilter::Exclude( Key key, G4String pattern ){
+    lists[key].exclude.push_back( pattern );
+    active = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepFilter::Clear(){
+    for( int k=0; k<kNKeys; k++ ){
+        lists[k].include.clear();
+        lists[k].exclude.clear();
+    }
+    min_edep = -DBL_MAX;
+    ekin_min = -DBL_MAX;
+    ekin_max = DBL_MAX;
+    active = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StepFilter::NameList::Passes( const G4String& name ) const {
+
+    for( size_t i=0; i<exclude.size(); i++ ){
+        if( MatchesVolumePattern( exclude[i], name ) )
+            return false;
+    }
+
+    if( include.empty() )
+        return true;
+
+    for( size_t i=0; i<include.size(); i++ ){
+        if( MatchesVolumePattern( include[i], name ) )
+            return true;
+    }
+    return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepFilter::Compile(){
+
+    volume_ok.clear();
+    particle_ok.clear();
+    process_ok.clear();
+
+    if( !active )
+        return;
+
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    for( size_t i=0; i<store->size(); i++ )
+        ResolveVolume( (*store)[i] );
+
+    G4ParticleTable::G4PTblDicIterator* it = G4ParticleTable::GetParticleTable()->GetIterator();
+    it->reset();
+    while( (*it)() )
+        AcceptParticle( it->value() );
+
+    // Processes are resolved as they are met, there are only a few of them.
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StepFilter::ResolveVolume( const G4VPhysicalVolume* pv ){
+
+    G4bool ok = lists[kVolume].Passes( pv->GetName() );
+
+    const G4Region* region = pv->GetLogicalVolume()->GetRegion();
+    if( ok && region!=0 )
+        ok = lists[kRegion].Passes( region->GetName() );
+    else if( ok )
+        ok = lists[kRegion].include.empty();
+
+    volume_ok[pv] = ok;
+    return ok;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StepFilter::AcceptParticle( const G4ParticleDefinition* particle ){
+
+    if( !active )
+        return true;
+
+    std::unordered_map<const G4ParticleDefinition*, G4bool>::const_iterator it = particle_ok.find( particle );
+    if( it!=particle_ok.end() )
+        return it->second;
+
+    G4bool ok = lists[kParticle].Passes( particle->GetParticleName() );
+    particle_ok[particle] = ok;
+    return ok;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StepFilter::AcceptTrack( const G4Track* track ){
+
+    if( !active )
+        return true;
+
+    const G4VPhysicalVolume* pv = track->GetVolume();
+    if( pv==0 )
+        return false;
+
+    // Nothing is deposited by the initial step.
+    if( 0 < min_edep )
+        return false;
+
+    G4double ekin = track->GetKineticEnergy();
+    if( ekin < ekin_min || ekin > ekin_max )
+        return false;
+
+    std::unordered_map<const G4VPhysicalVolume*, G4bool>::const_iterator v = volume_ok.find( pv );
+    if( !( v!=volume_ok.end() ? v->second : ResolveVolume( pv ) ) )
+        return false;
+
+    if( !AcceptParticle( track->GetParticleDefinition() ) )
+        return false;
+
+    std::unordered_map<const G4VProcess*, G4bool>::const_iterator p = process_ok.find( 0 );
+    return p!=process_ok.end() ? p->second : ResolveProcess( 0 );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StepFilter::ResolveProcess( const G4VProcess* proc ){
+
+    // Same name as stored in the output for steps without a defining process.
+    G4bool ok = lists[kProcess].Passes( proc ? proc->GetProcessName() : G4String("initStep") );
+    process_ok[proc] = ok;
+    return ok;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepFilter::Print() const {
+
+    const char* names[] = { "volume", "region", "particle", "process" };
+
+    G4cout << "Step recording:" << G4endl;
+    if( !active )
+        G4cout << "    all steps" << G4endl;
+
+    for( int k=0; k<kNKeys; k++ ){
+        for( size_t i=0; i<lists[k].include.size(); i++ )
+            G4cout << "    " << names[k] << " include " << lists[k].include[i] << G4endl;
+        for( size_t i=0; i<lists[k].exclude.size(); i++ )
+            G4cout << "    " << names[k] << " exclude " << lists[k].exclude[i] << G4endl;
+    }
+    if( min_edep>-DBL_MAX )
+        G4cout << "    minimum Edep " << G4BestUnit( min_edep, "Energy" ) << G4endl;
+    if( ekin_min>-DBL_MAX || ekin_max<DBL_MAX )
+        G4cout << "    kinetic energy " << G4BestUnit( ekin_min, "Energy" ) << "to " << G4BestUnit( ekin_max, "Energy" ) << G4endl;
+
+    if( nseen>0 )
+        G4cout << "    recorded " << nrecorded << " of " << nseen << " steps" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
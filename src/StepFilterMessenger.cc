@@ -0,0 +1,123 @@
+// $Id: StepFilterMessenger.cc $
+//
+/// \file StepFilterMessenger.cc
+/// \brief Definition of the StepFilterMessenger class
+
+#include "StepFilterMessenger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+StepFilterMessenger::StepFilterMessenger( StepFilter* f ) : G4UImessenger(), filter( f ){
+
+    directory = new G4UIdirectory( "/record/" );
+    directory->SetGuidance( "Selection of the steps written to the output." );
+    directory->SetGuidance( "Names may end with * to match any suffix. Exclusions take precedence over inclusions," );
+    directory->SetGuidance( "and an empty include list accepts every name. The trigger always sees all steps." );
+
+    const char* keys[] = { "volume", "region", "particle", "process" };
+    const char* what[] = {
+        "post-step physical volume",
+        "region of the post-step volume",
+        "particle",
+        "process that limited the step (initStep for the first step of a track)" };
+
+    for( int k=0; k<StepFilter::kNKeys; k++ ){
+
+        G4String dir = G4String( "/record/" ) + keys[k] + "/";
+        subdirectory[k] = new G4UIdirectory( dir );
+        subdirectory[k]->SetGuidance( G4String( "Selection by " ) + what[k] + "." );
+
+        includeCmd[k] = new G4UIcmdWithAString( dir + "include", this );
+        includeCmd[k]->SetGuidance( G4String( "Record only steps whose " ) + what[k] + " matches one of the included names." );
+        includeCmd[k]->SetParameterName( "name", false );
+        includeCmd[k]->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+        excludeCmd[k] = new G4UIcmdWithAString( dir + "exclude", this );
+        excludeCmd[k]->SetGuidance( G4String( "Do not record steps whose " ) + what[k] + " matches the name." );
+        excludeCmd[k]->SetParameterName( "name", false );
+        excludeCmd[k]->AvailableForStates( G4State_PreInit, G4State_Idle );
+    }
+
+    edepCmd = new G4UIcmdWithADoubleAndUnit( "/record/minEdep", this );
+    edepCmd->SetGuidance( "Record only steps depositing at least this energy." );
+    edepCmd->SetGuidance( "A positive minimum also drops the first step of every track, which deposits nothing." );
+    edepCmd->SetParameterName( "Edep", false );
+    edepCmd->SetDefaultUnit( "keV" );
+    edepCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    ekinCmd = new G4UIcommand( "/record/ekin", this );
+    ekinCmd->SetGuidance( "Record only steps starting with a kinetic energy between min and max." );
+    ekinCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "min", 'd', false );
+    ekinCmd->SetParameter( param );
+    param = new G4UIparameter( "max", 'd', false );
+    ekinCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    ekinCmd->SetParameter( param );
+
+    clearCmd = new G4UIcmdWithoutParameter( "/record/clear", this );
+    clearCmd->SetGuidance( "Remove all filters: every step is recorded." );
+    clearCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    printCmd = new G4UIcmdWithoutParameter( "/record/print", this );
+    printCmd->SetGuidance( "Print the filters and the fraction of steps recorded in the last run." );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+StepFilterMessenger::~StepFilterMessenger(){
+    for( int k=0; k<StepFilter::kNKeys; k++ ){
+        delete includeCmd[k];
+        delete excludeCmd[k];
+        delete subdirectory[k];
+    }
+    delete edepCmd;
+    delete ekinCmd;
+    delete clearCmd;
+    delete printCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void StepFilterMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    for( int k=0; k<StepFilter::kNKeys; k++ ){
+        if( command==includeCmd[k] ){
+            filter->Include( StepFilter::Key( k ), newValue );
+            return;
+        }
+        if( command==excludeCmd[k] ){
+            filter->Exclude( StepFilter::Key( k ), newValue );
+            return;
+        }
+    }
+
+    if( command==edepCmd ){
+        filter->SetMinEdep( edepCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==ekinCmd ){
+        std::istringstream is( newValue );
+        G4double min, max;
+        G4String unit;
+        is >> min >> max >> unit;
+        filter->SetEkinWindow( min*G4UIcommand::ValueOf( unit ), max*G4UIcommand::ValueOf( unit ) );
+    }
+    else if( command==clearCmd ){
+        filter->Clear();
+    }
+    else if( command==printCmd ){
+        filter->Print();
+    }
+    return;
+}
@@ -6,12 +6,15 @@
 /// \brief Implementation of the StepInfo class
 
 #include "StepInfo.hh"
+#include "DetectorConstruction.hh"
 
 #include "globals.hh"
 #include "G4Step.hh"
 #include "G4StepPoint.hh"
 #include "G4Track.hh"
 #include "G4ThreeVector.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
 #include "G4EventManager.hh"
 #include "G4Event.hh"
 
@@ -24,6 +27,7 @@ StepInfo::StepInfo()
     trackID(0),
     stepID(0),
     parentID(0),
+    primary_index(0),
     particle_name(""),
     volume_name(""),
     volume_copy_number(0),
@@ -40,21 +44,19 @@ StepInfo::StepInfo()
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 StepInfo::StepInfo( const G4Step* step )
-  : eventID(0),
-    trackID(0),
-    stepID(0),
-    parentID(0),
-    particle_name(""),
-    volume_name(""),
-    volume_copy_number(0),
-    energy_i(0),
-    energy_f(0),
-    deposited_energy(0),
-    position(0),
-    momentum_direction(0),
-    global_time(0),
-    process_name("")
+  : StepInfo()
 {
+    Fill<FullRecord>( step );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+template< class Record >
+void StepInfo::Fill( const G4Step* step )
+{
+    // The tests are on a constant: the compiler drops the fields outside the record.
+    const unsigned fields = Record::fields;
+
     G4StepPoint* postStep = step->GetPostStepPoint();
     G4StepPoint* preStep = step->GetPreStepPoint();
     G4Track* track = step->GetTrack();
@@ -64,39 +66,132 @@ StepInfo::StepInfo( const G4Step* step )
     stepID = track->GetCurrentStepNumber();
     parentID = track->GetParentID();
 
-    particle_name = track->GetParticleDefinition()->GetParticleName();
-
-    if(!postStep->GetPhysicalVolume()){
-        volume_name = "OutOfWorld";
-        volume_copy_number = 0;
+    if( fields & StepFields::kParticle )
+        particle_name = track->GetParticleDefinition()->GetParticleName();
+
+    if( fields & ( StepFields::kVolume | StepFields::kCopyNumber ) ){
+        if(!postStep->GetPhysicalVolume()){
+            if( fields & StepFields::kVolume )
+                volume_name = "OutOfWorld";
+            volume_copy_number = 0;
+        }
+        else {
+            if( fields & StepFields::kVolume )
+                volume_name = postStep->GetPhysicalVolume()->GetName();
+            if( fields & StepFields::kCopyNumber )
+                volume_copy_number = DetectorConstruction::GetDetectorID( postStep->GetTouchable() );
+        }
     }
-    else {
-        volume_name = postStep->GetPhysicalVolume()->GetName();
-        volume_copy_number = postStep->GetPhysicalVolume()->GetCopyNo();
+
+    if( fields & StepFields::kEki )
+        energy_i = preStep->GetKineticEnergy();
+    if( fields & StepFields::kEkf )
+        energy_f = postStep->GetKineticEnergy();
+    if( fields & StepFields::kEdep )
+        deposited_energy = step->GetTotalEnergyDeposit();
+
+    if( fields & StepFields::kPosition )
+        position = postStep->GetPosition();
+    if( fields & StepFields::kDirection )
+        momentum_direction = postStep->GetMomentumDirection();
+    if( fields & StepFields::kTime )
+        global_time = postStep->GetGlobalTime();
+
+    if( fields & StepFields::kProcess ){
+        if(!postStep->GetProcessDefinedStep()){
+            process_name = "initStep";
+        }
+        else {
+            process_name = postStep->GetProcessDefinedStep()->GetProcessName();
+        }
     }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    energy_i = preStep->GetKineticEnergy();
-    energy_f = postStep->GetKineticEnergy();
-    /*
-    G4double pre_energy;
-    if(eventID>=1){
-        pre_energy = preStep->GetKineticEnergy();
-        deposited_energy = pre_energy - energy;
-    }else{
-        deposited_energy = 0;
-    }*/
-    deposited_energy = step->GetTotalEnergyDeposit();
-
-    position = postStep->GetPosition();
-    momentum_direction = postStep->GetMomentumDirection();
-    global_time = postStep->GetGlobalTime();
-
-    if(!postStep->GetProcessDefinedStep()){
+template< class Record >
+void StepInfo::FillInitial( const G4Track* track )
+{
+    const unsigned fields = Record::fields;
+
+    eventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+    trackID = track->GetTrackID();
+    stepID = track->GetCurrentStepNumber();
+    parentID = track->GetParentID();
+
+    if( fields & StepFields::kParticle )
+        particle_name = track->GetParticleDefinition()->GetParticleName();
+    if( fields & StepFields::kVolume )
+        volume_name = track->GetVolume()->GetName();
+    if( fields & StepFields::kCopyNumber )
+        volume_copy_number = DetectorConstruction::GetDetectorID( track->GetTouchable() );
+
+    if( fields & StepFields::kEki )
+        energy_i = track->GetKineticEnergy();
+    if( fields & StepFields::kEkf )
+        energy_f = track->GetKineticEnergy();
+
+    if( fields & StepFields::kPosition )
+        position = track->GetPosition();
+    if( fields & StepFields::kDirection )
+        momentum_direction = track->GetMomentumDirection();
+    if( fields & StepFields::kTime )
+        global_time = track->GetGlobalTime();
+
+    if( fields & StepFields::kProcess )
         process_name = "initStep";
-    } 
-    else {
-        process_name = postStep->GetProcessDefinedStep()->GetProcessName();
-    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+    // Each entry instantiates the fill functions of its record.
+    const StepInfo::RecordType record_types[] = {
+        { "full", FullRecord::fields, &StepInfo::Fill<FullRecord>, &StepInfo::FillInitial<FullRecord> },
+        { "calorimetric", CalorimetricRecord::fields, &StepInfo::Fill<CalorimetricRecord>, &StepInfo::FillInitial<CalorimetricRecord> },
+        { "xray", XrayRecord::fields, &StepInfo::Fill<XrayRecord>, &StepInfo::FillInitial<XrayRecord> }
+    };
+
+    const size_t nrecord_types = sizeof( record_types )/sizeof( record_types[0] );
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const StepInfo::RecordType* StepInfo::GetRecordType( G4String name )
+{
+  for( size_t i=0; i<nrecord_types; i++ ){
+      if( name==record_types[i].name )
+          return &record_types[i];
+  }
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String StepInfo::GetRecordNames()
+{
+  G4String names;
+  for( size_t i=0; i<nrecord_types; i++ )
+      names += ( i>0 ? " " : "" ) + G4String( record_types[i].name );
+  return names;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t StepInfo::GetMemorySize() const
+{
+  // Short names are stored in the string itself, longer ones in a buffer of the
+  // capacity of the string plus the terminating null.
+  static const size_t local_capacity = G4String().capacity();
+  const G4String* names[3] = { &particle_name, &volume_name, &process_name };
+  size_t bytes = sizeof( StepInfo );
+  for( size_t i=0; i<3; i++ ){
+      if( names[i]->capacity()>local_capacity )
+          bytes += names[i]->capacity()+1;
+  }
+  return bytes;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -135,6 +230,20 @@ void StepInfo::SetTrackID( G4int newID )
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4int StepInfo::GetPrimaryIndex() const
+{
+  return primary_index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepInfo::SetPrimaryIndex( G4int index )
+{
+  primary_index = index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4int StepInfo::GetStepID()
 {
   return stepID;
@@ -0,0 +1,149 @@
+/// \file StepSpill.cc
+/// \brief Implementation of the StepSpill class
+
+#include "StepSpill.hh"
+
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepSpill::StepSpill() : file( 0 ), nwritten( 0 ), nread( 0 ), bytes( 0 ){}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepSpill::~StepSpill(){
+    if( file!=0 )
+        fclose( file );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StepSpill::Write( std::vector<StepInfo>& steps ){
+
+    if( file==0 ){
+        const char* dir = getenv( "TMPDIR" );
+        std::string path = std::string( dir ? dir : "/tmp" ) + "/apixs_spill_XXXXXX";
+
+        int fd = mkstemp( &path[0] );
+        if( fd<0 ){
+            G4cerr << "Cannot create a spill file in " << ( dir ? dir : "/tmp" ) << G4endl;
+            return false;
+        }
+        unlink( path.c_str() );
+        file = fdopen( fd, "w+b" );
+        if( file==0 )
+            return false;
+    }
+
+    fseek( file, 0, SEEK_END );
+
+    for( size_t i=0; i<steps.size(); i++ ){
+        StepInfo& s = steps[i];
+
+        G4int ids[5] = { s.GetEventID(), s.GetTrackID(), s.GetStepID(), s.GetParentID(), s.GetVolumeCopyNumber() };
+        G4ThreeVector pos = s.GetPosition();
+        G4ThreeVector dir = s.GetMomentumDirection();
+        G4double values[10] = { s.GetEki(), s.GetEkf(), s.GetDepositedEnergy(), s.GetGlobalTime(),
+                                pos.x(), pos.y(), pos.z(), dir.x(), dir.y(), dir.z() };
+
+        fwrite( ids, sizeof( ids ), 1, file );
+        fwrite( values, sizeof( values ), 1, file );
+        WriteString( s.GetParticleName() );
+        WriteString( s.GetVolumeName() );
+        WriteString( s.GetProcessName() );
+    }
+
+    nwritten += steps.size();
+    bytes = ftell( file );
+
+    return !ferror( file );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepSpill::WriteString( const G4String& s ){
+    unsigned short n = s.size();
+    fwrite( &n, sizeof( n ), 1, file );
+    fwrite( s.data(), 1, n, file );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String StepSpill::ReadString(){
+    unsigned short n = 0;
+    if( fread( &n, sizeof( n ), 1, file )!=1 )
+        return "";
+    std::string s( n, ' ' );
+    if( n>0 && fread( &s[0], 1, n, file )!=n )
+        return "";
+    return s;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepSpill::Rewind(){
+    nread = 0;
+    if( file!=0 ){
+        fflush( file );
+        rewind( file );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t StepSpill::Read( std::vector<StepInfo>& steps, size_t max ){
+
+    steps.clear();
+    if( file==0 )
+        return 0;
+
+    while( nread<nwritten && steps.size()<max ){
+
+        G4int ids[5];
+        G4double values[10];
+        if( fread( ids, sizeof( ids ), 1, file )!=1 || fread( values, sizeof( values ), 1, file )!=1 ){
+            G4cerr << "Spill file truncated after " << nread << " steps." << G4endl;
+            nread = nwritten;
+            break;
+        }
+
+        StepInfo s;
+        s.SetEventID( ids[0] );
+        s.SetTrackID( ids[1] );
+        s.SetStepID( ids[2] );
+        s.SetParentID( ids[3] );
+        s.SetVolumeCopyNumber( ids[4] );
+        s.SetEki( values[0] );
+        s.SetEkf( values[1] );
+        s.SetDepositedEnergy( values[2] );
+        s.SetGlobalTime( values[3] );
+        s.SetPosition( G4ThreeVector( values[4], values[5], values[6] ) );
+        s.SetMomentumDirection( G4ThreeVector( values[7], values[8], values[9] ) );
+        s.SetParticleName( ReadString() );
+        s.SetVolumeName( ReadString() );
+        s.SetProcessName( ReadString() );
+
+        steps.push_back( s );
+        nread++;
+    }
+
+    return steps.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepSpill::Clear(){
+    nwritten = 0;
+    nread = 0;
+    bytes = 0;
+    if( file!=0 ){
+        fflush( file );
+        if( ftruncate( fileno( file ), 0 )!=0 )
+            G4cerr << "Cannot reset the spill file." << G4endl;
+        rewind( file );
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
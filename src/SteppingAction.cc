@@ -4,10 +4,18 @@
 
 #include "SteppingAction.hh"
 #include "EventAction.hh"
+#include "Trigger.hh"
+#include "StepFilter.hh"
+#include "XrayTally.hh"
+#include "PointDetector.hh"
+#include "ResponseMatrix.hh"
+#include "ConvergenceMonitor.hh"
+#include "ScoringMesh.hh"
 #include "DetectorConstruction.hh"
 
 #include "G4Neutron.hh"
 #include "G4Step.hh"
+#include "G4Track.hh"
 #include "G4RunManager.hh"
 #include "StepInfo.hh"
 
@@ -16,7 +24,14 @@
 SteppingAction::SteppingAction( const DetectorConstruction* detectorConstruction, EventAction* eventAction)
       : G4UserSteppingAction(),
         fDetConstruction(detectorConstruction),
-        fEventAction(eventAction){
+        fEventAction(eventAction),
+        fTrigger(eventAction->GetTrigger()),
+        fStepFilter(eventAction->GetStepFilter()),
+        fXrayTally(eventAction->GetXrayTally()),
+        fPointDetector(eventAction->GetPointDetector()),
+        fResponseMatrix(eventAction->GetResponseMatrix()),
+        fConvergence(eventAction->GetConvergenceMonitor()),
+        fMesh(eventAction->GetScoringMesh()){
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -28,12 +43,31 @@ SteppingAction::~SteppingAction(){
 
 void SteppingAction::UserSteppingAction(const G4Step* step){
 
-    // Collect energy and number of scatters step by step
-    // Don't save the out of world step
-    if(!step->GetPostStepPoint()->GetPhysicalVolume()) return;
+    if( fEventAction->IsTabulating() )
+        return;
 
-//    if( step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName()!="Transportation" )
-        fEventAction->GetStepCollection().push_back(StepInfo(step));
+    fEventAction->CountStep();
+
+    // The trigger sees every step, whether it is recorded or not.
+    fTrigger->AddStep( step, fEventAction->GetPrimaryIndex( step->GetTrack()->GetTrackID() ) );
+
+    fXrayTally->ProcessStep( step, fEventAction->GetOutputEventID( step->GetTrack()->GetTrackID() ) );
+    fPointDetector->ProcessStep( step );
+    fConvergence->ProcessStep( step );
+    fMesh->ProcessStep( step );
+
+    if( fResponseMatrix->IsActive() ){
+        fResponseMatrix->ProcessStep( step );
+        return;
+    }
+
+    if( fXrayTally->IsYieldOnly() )
+        return;
+
+    // Out of world steps and steps rejected by the /record/ filters are dropped
+    // before building the StepInfo.
+    if( fStepFilter->Accept( step ) )
+        fEventAction->AddStep( step );
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
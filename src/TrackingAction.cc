@@ -8,6 +8,9 @@
 
 #include "TrackingAction.hh"
 #include "EventAction.hh"
+#include "StepFilter.hh"
+#include "XrayTally.hh"
+#include "ResponseMatrix.hh"
 
 #include "G4RunManager.hh"
 #include "G4Track.hh"
@@ -26,24 +29,23 @@ TrackingAction::TrackingAction(EventAction* eventAction)
 
 void TrackingAction::PreUserTrackingAction(const G4Track* track){
 
+  if( fEventAction->IsTabulating() )
+      return;
+
+  fEventAction->TagTrack( track );
+
+  if( fEventAction->GetXrayTally()->IsYieldOnly() )
+      return;
+
+  // The sweeps of /response/run are not recorded.
+  if( fEventAction->GetResponseMatrix()->IsActive() )
+      return;
+
+  if( !fEventAction->GetStepFilter()->AcceptTrack( track ) )
+      return;
+
   // We have to set up the initStep by hand
-  StepInfo stepInfo;
-
-  stepInfo.SetEventID(G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID());
-  stepInfo.SetTrackID(track->GetTrackID());
-  stepInfo.SetStepID( /*0*/ track->GetCurrentStepNumber() );
-  stepInfo.SetParentID(track->GetParentID());
-  stepInfo.SetParticleName(track->GetParticleDefinition()->GetParticleName());
-  stepInfo.SetVolumeName(track->GetVolume()->GetName());
-  stepInfo.SetVolumeCopyNumber(track->GetVolume()->GetCopyNo());
-  stepInfo.SetEki(track->GetKineticEnergy());
-  stepInfo.SetEkf(track->GetKineticEnergy());
-  stepInfo.SetPosition(track->GetPosition());
-  stepInfo.SetMomentumDirection(track->GetMomentumDirection());
-  stepInfo.SetGlobalTime(track->GetGlobalTime());
-  stepInfo.SetProcessName("initStep");
-
-  fEventAction->GetStepCollection().push_back(stepInfo);
+  fEventAction->AddTrack( track );
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,333 @@
+/// \file Trigger.cc
+/// \brief Implementation of the Trigger class
+
+#include "Trigger.hh"
+#include "TriggerMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Step.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4RunManager.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Trigger::Trigger() :
+    messenger( 0 ),
+    window( 0 ),
+    abort_on_veto( false ),
+    nevents( 0 ),
+    naccepted( 0 ),
+    nvetoed( 0 ),
+    nwindow( 0 )
+{
+    // Default: anything reaching the center detector.
+    AddCondition( kRequire, "detector", 1, 0 );
+
+    messenger = new TriggerMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Trigger::~Trigger(){
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Trigger::AddCondition( Type type, G4String pattern, G4int multiplicity, G4double threshold ){
+
+    Condition c;
+    c.type = type;
+    c.pattern = pattern;
+    c.multiplicity = type==kMajority ? multiplicity : 1;
+    c.threshold = threshold;
+    c.passed = 0;
+    conditions.push_back( c );
+
+    volume_conditions.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Trigger::Clear(){
+    conditions.clear();
+    volume_conditions.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const std::vector<int>& Trigger::GetConditions( const G4VPhysicalVolume* pv ){
+
+    std::map< const G4VPhysicalVolume*, std::vector<int> >::iterator it = volume_conditions.find( pv );
+    if( it!=volume_conditions.end() )
+        return it->second;
+
+    std::vector<int>& list = volume_conditions[pv];
+    for( size_t i=0; i<conditions.size(); i++ ){
+        if( MatchesVolumePattern( conditions[i].pattern, pv->GetName() ) )
+            list.push_back( i );
+    }
+    return list;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Trigger::BeginOfEvent( G4int nprimaries ){
+    detectors.clear();
+    detector_index.clear();
+    decisions.assign( nprimaries, conditions.empty() ? kAccepted : kUndecided );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Trigger::Decision Trigger::AddStep( const G4Step* step, G4int primary ){
+
+    Decision& decision = decisions[primary];
+    if( decision!=kUndecided )
+        return decision;
+
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    const G4VPhysicalVolume* pv = pre->GetPhysicalVolume();
+    if( pv==0 )
+        return decision;
+
+    const std::vector<int>& list = GetConditions( pv );
+    if( list.empty() )
+        return decision;
+
+    DetectorKey key( std::make_pair( pv, DetectorConstruction::GetDetectorID( pre->GetTouchable() ) ), primary );
+    std::map< DetectorKey, size_t >::iterator it = detector_index.find( key );
+
+    if( it==detector_index.end() ){
+        Detector d;
+        d.primary = primary;
+        d.conditions = list;
+        d.energy = 0;
+        d.time = pre->GetGlobalTime();
+        d.fired.assign( list.size(), false );
+        detectors.push_back( d );
+        it = detector_index.insert( std::make_pair( key, detectors.size()-1 ) ).first;
+    }
+
+    Detector& d = detectors[it->second];
+    d.energy += step->GetTotalEnergyDeposit();
+    d.time = std::min( d.time, pre->GetGlobalTime() );
+
+    G4bool changed = false;
+    for( size_t j=0; j<d.conditions.size(); j++ ){
+
+        if( d.fired[j] )
+            continue;
+
+        const Condition& c = conditions[ d.conditions[j] ];
+        if( d.energy < c.threshold )
+            continue;
+
+        d.fired[j] = true;
+        changed = true;
+
+        if( c.type==kVeto ){
+            decision = kRejected;
+            if( abort_on_veto && decisions.size()==1 )
+                G4RunManager::GetRunManager()->AbortEvent();
+            return decision;
+        }
+    }
+
+    if( changed && IsFinal() && Evaluate( 0, false, primary ) )
+        decision = kAccepted;
+
+    return decision;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Trigger::IsFinal() const {
+
+    if( window>0 )
+        return false;
+        // a hit earlier in time can still move a detector out of the window
+
+    for( size_t i=0; i<conditions.size(); i++ ){
+        if( conditions[i].type==kVeto )
+            return false;
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Trigger::Evaluate( G4double w, G4bool count, G4int primary ){
+
+    size_t nc = conditions.size();
+
+    // Times at which a window may open: those of the detectors firing a condition.
+    std::vector<G4double> starts;
+    for( size_t k=0; k<detectors.size(); k++ ){
+        if( detectors[k].primary!=primary )
+            continue;
+        for( size_t j=0; j<detectors[k].conditions.size(); j++ ){
+            if( detectors[k].fired[j] && conditions[ detectors[k].conditions[j] ].type!=kVeto ){
+                starts.push_back( detectors[k].time );
+                break;
+            }
+        }
+    }
+    std::sort( starts.begin(), starts.end() );
+
+    // Without a window a single pass over all detectors is enough.
+    G4bool windowed = w>0;
+    if( !windowed || starts.empty() )
+        starts.assign( 1, 0. );
+
+    std::vector<G4int> nfired( nc );
+
+    for( size_t s=0; s<starts.size(); s++ ){
+
+        std::fill( nfired.begin(), nfired.end(), 0 );
+
+        for( size_t k=0; k<detectors.size(); k++ ){
+            const Detector& d = detectors[k];
+            if( d.primary!=primary )
+                continue;
+            if( windowed && ( d.time < starts[s] || d.time > starts[s]+w ) )
+                continue;
+            for( size_t j=0; j<d.conditions.size(); j++ ){
+                if( d.fired[j] )
+                    nfired[ d.conditions[j] ]++;
+            }
+        }
+
+        G4bool ok = true;
+        for( size_t i=0; i<nc; i++ ){
+            if( conditions[i].type!=kVeto && nfired[i] < conditions[i].multiplicity )
+                ok = false;
+        }
+
+        if( count && s==0 && !windowed ){
+            for( size_t i=0; i<nc; i++ ){
+                if( conditions[i].type!=kVeto && nfired[i] >= conditions[i].multiplicity )
+                    conditions[i].passed++;
+            }
+        }
+
+        if( ok )
+            return true;
+    }
+
+    return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Trigger::EndOfEvent(){
+
+    G4bool any = false;
+    accepted.assign( decisions.size(), false );
+
+    for( size_t k=0; k<decisions.size(); k++ ){
+
+        nevents++;
+
+        if( decisions[k]==kRejected ){
+            nvetoed++;
+            continue;
+        }
+
+        G4bool ok = true;
+        if( !conditions.empty() ){
+
+            // Conditions are counted one by one without the window.
+            G4bool all = Evaluate( 0, true, k );
+
+            ok = all && ( window<=0 || Evaluate( window, false, k ) );
+            if( all && !ok )
+                nwindow++;
+        }
+
+        if( ok )
+            naccepted++;
+
+        accepted[k] = ok;
+        any = any || ok;
+    }
+
+    return any;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Trigger::ResetCounters(){
+    nevents = 0;
+    naccepted = 0;
+    nvetoed = 0;
+    nwindow = 0;
+    for( size_t i=0; i<conditions.size(); i++ )
+        conditions[i].passed = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<std::string> Trigger::GetSummary() const {
+
+    std::vector<std::string> lines;
+    std::stringstream ss;
+
+    const char* names[] = { "require", "majority", "veto" };
+
+    for( size_t i=0; i<conditions.size(); i++ ){
+        const Condition& c = conditions[i];
+        ss.str("");
+        ss << names[c.type] << ' ' << c.pattern;
+        if( c.type==kMajority )
+            ss << " M=" << c.multiplicity;
+        ss << " threshold=" << G4BestUnit( c.threshold, "Energy" );
+        if( c.type!=kVeto )
+            ss << " passed " << c.passed;
+        lines.push_back( ss.str() );
+    }
+
+    ss.str("");
+    ss << "window " << ( window>0 ? window/CLHEP::ns : 0. ) << " ns";
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "events " << nevents;
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "accepted " << naccepted;
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "vetoed " << nvetoed;
+    lines.push_back( ss.str() );
+
+    ss.str("");
+    ss << "outside_window " << nwindow;
+    lines.push_back( ss.str() );
+
+    return lines;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Trigger::Print() const {
+
+    std::vector<std::string> lines = GetSummary();
+
+    G4cout << "Trigger:" << G4endl;
+    for( size_t i=0; i<lines.size(); i++ )
+        G4cout << "    " << lines[i] << G4endl;
+
+    if( nevents>0 )
+        G4cout << "    efficiency " << double( naccepted )/nevents << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
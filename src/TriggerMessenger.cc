@@ -0,0 +1,130 @@
+// $Id: TriggerMessenger.cc $
+//
+/// \file TriggerMessenger.cc
+/// \brief Definition of the TriggerMessenger class
+
+#include "TriggerMessenger.hh"
+#include "Trigger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+// Parameters shared by the condition commands: volume name pattern, threshold and its unit.
+static void AddDetectorParameters( G4UIcommand* cmd ){
+
+    G4UIparameter* param = new G4UIparameter( "volume", 's', false );
+    cmd->SetParameter( param );
+
+    param = new G4UIparameter( "threshold", 'd', true );
+    param->SetDefaultValue( 0. );
+    param->SetParameterRange( "threshold>=0" );
+    cmd->SetParameter( param );
+
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    cmd->SetParameter( param );
+
+    cmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+TriggerMessenger::TriggerMessenger( Trigger* t ) : G4UImessenger(), trigger( t ){
+
+    directory = new G4UIdirectory( "/trigger/" );
+    directory->SetGuidance( "Selection of the events written to the output." );
+    directory->SetGuidance( "Detectors are matched by physical volume name, a trailing * matches any suffix (e.g. farside_*)." );
+    directory->SetGuidance( "A detector fires when the energy deposited in it reaches the threshold, or on any step if the threshold is 0." );
+    directory->SetGuidance( "By default events reaching the center detector are kept (/trigger/require detector)." );
+
+    requireCmd = new G4UIcommand( "/trigger/require", this );
+    requireCmd->SetGuidance( "At least one detector matching the volume name must fire." );
+    AddDetectorParameters( requireCmd );
+
+    majorityCmd = new G4UIcommand( "/trigger/majority", this );
+    majorityCmd->SetGuidance( "At least M distinct detectors matching the volume name must fire." );
+    G4UIparameter* param = new G4UIparameter( "M", 'i', false );
+    param->SetParameterRange( "M>=1" );
+    majorityCmd->SetParameter( param );
+    AddDetectorParameters( majorityCmd );
+
+    vetoCmd = new G4UIcommand( "/trigger/veto", this );
+    vetoCmd->SetGuidance( "Reject the event if a detector matching the volume name fires." );
+    AddDetectorParameters( vetoCmd );
+
+    windowCmd = new G4UIcmdWithADoubleAndUnit( "/trigger/window", this );
+    windowCmd->SetGuidance( "The detectors satisfying the conditions must fire within this time of each other." );
+    windowCmd->SetGuidance( "The time of a detector is the global time of its first step. 0 disables the window." );
+    windowCmd->SetParameterName( "window", false );
+    windowCmd->SetRange( "window>=0" );
+    windowCmd->SetDefaultUnit( "ns" );
+    windowCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    abortCmd = new G4UIcmdWithABool( "/trigger/abortOnVeto", this );
+    abortCmd->SetGuidance( "Abort the event as soon as a veto fires instead of tracking it to the end." );
+    abortCmd->SetParameterName( "abort", true );
+    abortCmd->SetDefaultValue( true );
+    abortCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    clearCmd = new G4UIcmdWithoutParameter( "/trigger/clear", this );
+    clearCmd->SetGuidance( "Remove all conditions, including the default one: every event is kept." );
+    clearCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    printCmd = new G4UIcmdWithoutParameter( "/trigger/print", this );
+    printCmd->SetGuidance( "Print the conditions and the efficiency counters of the last run." );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+TriggerMessenger::~TriggerMessenger(){
+    delete requireCmd;
+    delete majorityCmd;
+    delete vetoCmd;
+    delete windowCmd;
+    delete abortCmd;
+    delete clearCmd;
+    delete printCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void TriggerMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==requireCmd || command==majorityCmd || command==vetoCmd ){
+
+        std::istringstream is( newValue );
+        G4int m = 1;
+        G4String volume, unit;
+        G4double threshold = 0;
+
+        if( command==majorityCmd )
+            is >> m;
+        is >> volume >> threshold >> unit;
+        threshold *= G4UIcommand::ValueOf( unit );
+
+        Trigger::Type type = command==requireCmd ? Trigger::kRequire :
+                             command==majorityCmd ? Trigger::kMajority : Trigger::kVeto;
+        trigger->AddCondition( type, volume, m, threshold );
+    }
+    else if( command==windowCmd ){
+        trigger->SetWindow( windowCmd->GetNewDoubleValue( newValue ) );
+    }
+    else if( command==abortCmd ){
+        trigger->SetAbortOnVeto( abortCmd->GetNewBoolValue( newValue ) );
+    }
+    else if( command==clearCmd ){
+        trigger->Clear();
+    }
+    else if( command==printCmd ){
+        trigger->Print();
+    }
+    return;
+}
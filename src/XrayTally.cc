@@ -0,0 +1,233 @@
+/// \file XrayTally.cc
+/// \brief Implementation of the XrayTally class
+
+#include "XrayTally.hh"
+#include "XrayTallyMessenger.hh"
+#include "OutputSink.hh"
+#include "GeometryUtils.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Gamma.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+XrayTally::XrayTally() :
+    messenger( 0 ),
+    enabled( false ),
+    yield_only( false ),
+    write_table( true ),
+    volume_pattern( "target_*" ),
+    nbins( 2000 ),
+    emin( 0 ),
+    emax( 100*keV ),
+    sink( 0 )
+{
+    const char* names[] = { "eventID", "target", "process", "E", "x", "y", "z", "px", "py", "pz", "parent_E", "parent_pdg" };
+    columns.assign( names, names+12 );
+    row.resize( columns.size() );
+
+    // Fixed codes, the same in all jobs whatever the order the photons come in.
+    // Any other creator is tallied as "other", always the last code.
+    const char* known[] = { "ionIoni", "hIoni", "phot", "compt", "eIoni", "eBrem", "annihil",
+                            "RadioactiveDecay", "Radioactivation", "other" };
+    processes.assign( known, known+10 );
+
+    messenger = new XrayTallyMessenger( this );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+XrayTally::~XrayTally(){
+    delete messenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void XrayTally::SetHistogram( G4int n, G4double min, G4double max ){
+    nbins = n;
+    emin = min;
+    emax = max;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int XrayTally::GetTarget( const G4VPhysicalVolume* pv ){
+
+    std::unordered_map<const G4VPhysicalVolume*, G4int>::const_iterator it = volume_index.find( pv );
+    if( it!=volume_index.end() )
+        return it->second;
+
+    const G4String& name = pv->GetName();
+    G4bool match = MatchesVolumePattern( volume_pattern, name );
+
+    G4int index = -1;
+    if( match ){
+        for( size_t i=0; i<targets.size(); i++ ){
+            if( targets[i]==name )
+                index = i;
+        }
+        if( index<0 ){
+            targets.push_back( name );
+            index = targets.size()-1;
+        }
+    }
+
+    volume_index[pv] = index;
+    return index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int XrayTally::GetProcess( const G4String& name ){
+    for( size_t i=0; i+1<processes.size(); i++ ){
+        if( processes[i]==name )
+            return i;
+    }
+    other_processes.insert( name );
+    return processes.size()-1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void XrayTally::BeginOfRun(){
+
+    sink = 0;
+    spectra.clear();
+    volume_index.clear();
+    other_processes.clear();
+
+    if( enabled ){
+        // Targets are numbered in the order of the volume store, the same in all jobs.
+        G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+        for( size_t i=0; i<store->size(); i++ )
+            GetTarget( (*store)[i] );
+
+        G4cout << "X-ray tally in " << volume_pattern << ( yield_only ? ", yield only" : "" ) << G4endl;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void XrayTally::ProcessStep( const G4Step* step, G4int eventID ){
+
+    if( !enabled )
+        return;
+
+    const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
+    if( secondaries==0 || secondaries->empty() )
+        return;
+
+    // The interaction took place in the pre-step volume.
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    if( pre->GetPhysicalVolume()==0 )
+        return;
+    G4int target = GetTarget( pre->GetPhysicalVolume() );
+    if( target<0 )
+        return;
+
+    const G4ParticleDefinition* gamma = G4Gamma::Definition();
+    G4double parent_energy = pre->GetKineticEnergy();
+
+    for( size_t i=0; i<secondaries->size(); i++ ){
+
+        const G4Track* photon = (*secondaries)[i];
+        if( photon->GetDefinition()!=gamma )
+            continue;
+
+        const G4VProcess* creator = photon->GetCreatorProcess();
+        G4int process = GetProcess( creator ? creator->GetProcessName() : G4String( "unknown" ) );
+
+        G4double energy = photon->GetKineticEnergy();
+
+        std::vector<G4double>& spectrum = spectra[ std::make_pair( target, process ) ];
+        if( spectrum.empty() )
+            spectrum.assign( nbins+2, 0. );
+
+        G4int bin = energy<emin ? 0 : energy>=emax ? nbins+1 : 1 + G4int( ( energy-emin )/( emax-emin )*nbins );
+        spectrum[bin] += 1;
+
+        if( write_table && sink!=0 ){
+            G4ThreeVector pos = photon->GetPosition();
+            G4ThreeVector dir = photon->GetMomentumDirection();
+
+            row[0] = eventID;
+            row[1] = target;
+            row[2] = process;
+            row[3] = energy;
+            row[4] = pos.x();
+            row[5] = pos.y();
+            row[6] = pos.z();
+            row[7] = dir.x();
+            row[8] = dir.y();
+            row[9] = dir.z();
+            row[10] = parent_energy;
+            row[11] = step->GetTrack()->GetDefinition()->GetPDGEncoding();
+
+            sink->FillTable( "xrays", columns, row );
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void XrayTally::EndOfRun( G4int nprimaries ){
+
+    if( !enabled )
+        return;
+
+    G4cout << "X-ray yield per primary (" << nprimaries << " primaries):" << G4endl;
+
+    std::map< std::pair<G4int, G4int>, std::vector<G4double> >::iterator it;
+    for( it=spectra.begin(); it!=spectra.end(); ++it ){
+
+        const G4String& target = targets[ it->first.first ];
+        const G4String& process = processes[ it->first.second ];
+
+        G4double n = 0;
+        for( size_t i=0; i<it->second.size(); i++ )
+            n += it->second[i];
+
+        G4cout << "    " << target << " " << process << ": " << n << " photons, "
+               << ( nprimaries>0 ? n/nprimaries : 0. ) << " per primary" << G4endl;
+
+        if( sink!=0 ){
+            G4String name = "xray_" + target + "_" + process;
+            G4String title = "Photons created by " + process + " in " + target + ";E (MeV);photons";
+            sink->WriteHistogram( name, title, emin, emax, it->second );
+        }
+    }
+
+    if( !other_processes.empty() ){
+        G4cout << "    creators tallied as other:";
+        for( std::set<G4String>::const_iterator p=other_processes.begin(); p!=other_processes.end(); ++p )
+            G4cout << " " << *p;
+        G4cout << G4endl;
+    }
+
+    // Meaning of the target and process codes of the table.
+    if( sink!=0 ){
+        std::vector<std::string> lines;
+        for( size_t i=0; i<targets.size(); i++ ){
+            std::stringstream ss;
+            ss << "target " << i << ' ' << targets[i];
+            lines.push_back( ss.str() );
+        }
+        for( size_t i=0; i<processes.size(); i++ ){
+            std::stringstream ss;
+            ss << "process " << i << ' ' << processes[i];
+            lines.push_back( ss.str() );
+        }
+        sink->WriteText( "xray_codes", lines );
+    }
+
+    sink = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,103 @@
+// $Id: XrayTallyMessenger.cc $
+//
+/// \file XrayTallyMessenger.cc
+/// \brief Definition of the XrayTallyMessenger class
+
+#include "XrayTallyMessenger.hh"
+#include "XrayTally.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+XrayTallyMessenger::XrayTallyMessenger( XrayTally* t ) : G4UImessenger(), tally( t ){
+
+    directory = new G4UIdirectory( "/xray/" );
+    directory->SetGuidance( "Tally of the photons created in the target foils, by target and creator process." );
+
+    enableCmd = new G4UIcmdWithABool( "/xray/enable", this );
+    enableCmd->SetGuidance( "Tally the photons created in the targets: spectra per target and process, and the xrays table." );
+    enableCmd->SetParameterName( "enable", true );
+    enableCmd->SetDefaultValue( true );
+    enableCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    volumeCmd = new G4UIcmdWithAString( "/xray/volume", this );
+    volumeCmd->SetGuidance( "Physical volume name of the targets, a trailing * matches any suffix (default target_*)." );
+    volumeCmd->SetParameterName( "volume", false );
+    volumeCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    yieldCmd = new G4UIcmdWithABool( "/xray/yieldOnly", this );
+    yieldCmd->SetGuidance( "Record nothing but the tally and kill all secondaries once tallied." );
+    yieldCmd->SetGuidance( "Only photons created by the primaries are then counted." );
+    yieldCmd->SetParameterName( "yieldOnly", true );
+    yieldCmd->SetDefaultValue( true );
+    yieldCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    tableCmd = new G4UIcmdWithABool( "/xray/table", this );
+    tableCmd->SetGuidance( "Write one row per photon in the xrays table (default true). The spectra are always written." );
+    tableCmd->SetParameterName( "table", true );
+    tableCmd->SetDefaultValue( true );
+    tableCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    histogramCmd = new G4UIcommand( "/xray/histogram", this );
+    histogramCmd->SetGuidance( "Binning of the energy spectra: number of bins, minimum and maximum energy." );
+    histogramCmd->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    G4UIparameter* param = new G4UIparameter( "nbins", 'i', false );
+    param->SetParameterRange( "nbins>0" );
+    histogramCmd->SetParameter( param );
+    param = new G4UIparameter( "min", 'd', false );
+    histogramCmd->SetParameter( param );
+    param = new G4UIparameter( "max", 'd', false );
+    histogramCmd->SetParameter( param );
+    param = new G4UIparameter( "unit", 's', true );
+    param->SetDefaultValue( "keV" );
+    histogramCmd->SetParameter( param );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+XrayTallyMessenger::~XrayTallyMessenger(){
+    delete enableCmd;
+    delete volumeCmd;
+    delete yieldCmd;
+    delete tableCmd;
+    delete histogramCmd;
+    delete directory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+void XrayTallyMessenger::SetNewValue( G4UIcommand* command, G4String newValue ){
+
+    if( command==enableCmd ){
+        tally->SetEnabled( enableCmd->GetNewBoolValue( newValue ) );
+    }
+    else if( command==volumeCmd ){
+        tally->SetVolume( newValue );
+    }
+    else if( command==yieldCmd ){
+        tally->SetYieldOnly( yieldCmd->GetNewBoolValue( newValue ) );
+    }
+    else if( command==tableCmd ){
+        tally->SetTable( tableCmd->GetNewBoolValue( newValue ) );
+    }
+    else if( command==histogramCmd ){
+        std::istringstream is( newValue );
+        G4int n;
+        G4double min, max;
+        G4String unit;
+        is >> n >> min >> max >> unit;
+        if( max<=min ){
+            G4cerr << "/xray/histogram: max must be larger than min." << G4endl;
+            return;
+        }
+        tally->SetHistogram( n, min*G4UIcommand::ValueOf( unit ), max*G4UIcommand::ValueOf( unit ) );
+    }
+    return;
+}
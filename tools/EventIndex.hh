@@ -0,0 +1,144 @@
+//
+/// \file EventIndex.hh
+/// \brief Direct access to single events of a ROOT output through its event_index tree.
+///
+/// The writer stores, for every accepted event, its run, job and the entry range it
+/// occupies in the data trees, together with the energy deposited in the center
+/// detector and in the far-side detectors. EventIndex loads that table once, after
+/// which the entries of an event are found without scanning the data, and events can
+/// be selected by a cut on the index (e.g. "edep_center>0 && nfarside>0") and read
+/// back through a TEntryList. Header only, for ROOT sessions and compiled tools.
+
+#ifndef EventIndex_h
+#define EventIndex_h 1
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TEntryList.h"
+
+#include <vector>
+#include <algorithm>
+
+class EventIndex{
+
+public:
+
+    struct Entry{
+        Int_t eventID;
+        Int_t runID;
+        Long64_t job;
+        Long64_t first;
+        Long64_t n;
+            // entry range in the events tree, or in the tracks tree for the track schema
+        Long64_t first_step;
+        Long64_t nsteps;
+            // entry range in the steps tree for the track schema
+
+        bool operator<( const Entry& b ) const {
+            return runID<b.runID || ( runID==b.runID && eventID<b.eventID );
+        }
+    };
+
+    EventIndex( TFile* file ) : index_tree( 0 ){
+
+        index_tree = (TTree*)file->Get( "event_index" );
+        if( index_tree==0 )
+            return;
+
+        Entry e;
+        e.first_step = e.nsteps = 0;
+
+        index_tree->SetBranchAddress( "eventID", &e.eventID );
+        index_tree->SetBranchAddress( "runID", &e.runID );
+        index_tree->SetBranchAddress( "job", &e.job );
+        index_tree->SetBranchAddress( "first", &e.first );
+        index_tree->SetBranchAddress( "n", &e.n );
+        if( index_tree->GetBranch( "first_step" ) ){
+            index_tree->SetBranchAddress( "first_step", &e.first_step );
+            index_tree->SetBranchAddress( "nsteps", &e.nsteps );
+        }
+
+        Long64_t n = index_tree->GetEntries();
+        entries.reserve( n );
+        for( Long64_t i=0; i<n; i++ ){
+            index_tree->GetEntry( i );
+            entries.push_back( e );
+        }
+        index_tree->ResetBranchAddresses();
+
+        std::sort( entries.begin(), entries.end() );
+    }
+
+    bool IsValid() const { return index_tree!=0; }
+
+    size_t GetNumberOfEvents() const { return entries.size(); }
+
+    /// Entry range of an event, 0 if the event is not in the file.
+    const Entry* Find( Int_t eventID, Int_t runID = 0 ) const {
+        Entry key;
+        key.eventID = eventID;
+        key.runID = runID;
+        std::vector<Entry>::const_iterator it = std::lower_bound( entries.begin(), entries.end(), key );
+        if( it==entries.end() || it->eventID!=eventID || it->runID!=runID )
+            return 0;
+        return &(*it);
+    }
+
+    /// Read all entries of an event from the data tree (events, or tracks/steps with track_tree/step_tree).
+    /// Returns the number of entries read; the caller's branch addresses hold the last one, so
+    /// for the step and track schemas use Find() and loop over the range instead.
+    Long64_t LoadEvent( TTree* tree, Int_t eventID, Int_t runID = 0 ) const {
+        const Entry* e = Find( eventID, runID );
+        if( e==0 )
+            return 0;
+        for( Long64_t i=e->first; i<e->first+e->n; i++ )
+            tree->GetEntry( i );
+        return e->n;
+    }
+
+    /// Events passing a cut on the event_index variables.
+    std::vector<Long64_t> Select( const char* cut ) const {
+
+        std::vector<Long64_t> selected;
+        if( index_tree==0 )
+            return selected;
+
+        index_tree->Draw( ">>apixs_selected", cut, "entrylist" );
+        TEntryList* list = (TEntryList*)gDirectory->Get( "apixs_selected" );
+        if( list==0 )
+            return selected;
+
+        for( Long64_t i=0; i<list->GetN(); i++ )
+            selected.push_back( list->GetEntry( i ) );
+        delete list;
+
+        return selected;
+    }
+
+    /// Entry list of the data tree holding every entry of the events passing the cut.
+    /// Attach it with tree->SetEntryList() to process only those events.
+    TEntryList* MakeEntryList( TTree* tree, const char* cut, bool steps = false ) const {
+
+        TEntryList* list = new TEntryList( tree );
+        std::vector<Long64_t> selected = Select( cut );
+
+        Long64_t first, n;
+        index_tree->SetBranchAddress( steps ? "first_step" : "first", &first );
+        index_tree->SetBranchAddress( steps ? "nsteps" : "n", &n );
+        for( size_t i=0; i<selected.size(); i++ ){
+            index_tree->GetEntry( selected[i] );
+            for( Long64_t k=first; k<first+n; k++ )
+                list->Enter( k );
+        }
+        index_tree->ResetBranchAddresses();
+
+        return list;
+    }
+
+private:
+
+    TTree* index_tree;
+    std::vector<Entry> entries;
+};
+
+#endif
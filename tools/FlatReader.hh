@@ -0,0 +1,161 @@
+//
+/// \file FlatReader.hh
+/// \brief Zero-copy reader for the flat binary output (/output/format flat).
+///
+/// The file is memory-mapped and the step records are used in place. The event index
+/// written when the file is closed gives the records of an event directly; for a file
+/// that was not closed, records up to the last checkpoint are available and the index
+/// is rebuilt on demand. Header only, depends on FlatFormat.hh and POSIX only.
+
+#ifndef FlatReader_h
+#define FlatReader_h 1
+
+#include "FlatFormat.hh"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class FlatReader{
+
+public:
+
+    FlatReader() : data( 0 ), size( 0 ){}
+
+    ~FlatReader(){
+        if( data )
+            munmap( data, size );
+    }
+
+    /// Map the file. Returns false if it is not a flat output file.
+    bool Open( const std::string& name ){
+
+        int fd = open( name.c_str(), O_RDONLY );
+        if( fd<0 )
+            return false;
+
+        struct stat st;
+        if( fstat( fd, &st )!=0 || size_t( st.st_size )<sizeof( flat::FlatHeader ) ){
+            close( fd );
+            return false;
+        }
+
+        size = st.st_size;
+        void* p = mmap( 0, size, PROT_READ, MAP_SHARED, fd, 0 );
+        close( fd );
+        if( p==MAP_FAILED ){
+            size = 0;
+            return false;
+        }
+        data = (char*)p;
+
+        if( memcmp( GetHeader().magic, flat::kMagic, sizeof( flat::kMagic ) )!=0
+            || GetHeader().version!=flat::kVersion
+            || GetHeader().record_size!=sizeof( flat::FlatStepRecord ) ){
+            munmap( data, size );
+            data = 0;
+            return false;
+        }
+
+        ReadIndex();
+        return true;
+    }
+
+    const flat::FlatHeader& GetHeader() const { return *(const flat::FlatHeader*)data; }
+
+    const flat::FlatField* GetFields() const { return (const flat::FlatField*)( data + sizeof( flat::FlatHeader ) ); }
+
+    /// Byte offset of the named field within a record, -1 if there is no such field.
+    int GetFieldOffset( const char* name ) const {
+        for( uint32_t i=0; i<GetHeader().nfields; i++ ){
+            if( strncmp( GetFields()[i].name, name, 16 )==0 )
+                return GetFields()[i].offset;
+        }
+        return -1;
+    }
+
+    uint64_t GetNumberOfRecords() const { return GetHeader().nrecords; }
+
+    const flat::FlatStepRecord* GetRecords() const { return (const flat::FlatStepRecord*)( data + GetHeader().header_size ); }
+
+    const std::vector<flat::FlatEventEntry>& GetIndex() const { return index; }
+
+    /// Records of an event, found by binary search in the index. Returns the number of records.
+    uint64_t GetEvent( int64_t eventID, const flat::FlatStepRecord** first ) const {
+        flat::FlatEventEntry key = { eventID, 0, 0 };
+        std::vector<flat::FlatEventEntry>::const_iterator it = std::lower_bound( index.begin(), index.end(), key, LessID );
+        if( it==index.end() || it->eventID!=eventID ){
+            *first = 0;
+            return 0;
+        }
+        *first = GetRecords() + it->first;
+        return it->nrecords;
+    }
+
+    /// Named text blocks (macros, seeds, geometry) of a closed file.
+    std::map<std::string, std::string> GetTexts() const {
+
+        std::map<std::string, std::string> texts;
+        const flat::FlatHeader& h = GetHeader();
+        if( h.index_offset==0 )
+            return texts;
+
+        const char* p = data + h.text_offset;
+        const char* end = p + h.text_size;
+        while( p+sizeof( uint32_t )<=end ){
+            uint32_t n;
+            memcpy( &n, p, sizeof( n ) );
+            std::string name( p+sizeof( n ), n );
+            p += sizeof( n ) + n;
+            memcpy( &n, p, sizeof( n ) );
+            texts[name] = std::string( p+sizeof( n ), n );
+            p += sizeof( n ) + n;
+        }
+        return texts;
+    }
+
+private:
+
+    char* data;
+    size_t size;
+
+    std::vector<flat::FlatEventEntry> index;
+
+    static bool LessID( const flat::FlatEventEntry& a, const flat::FlatEventEntry& b ){
+        return a.eventID<b.eventID;
+    }
+
+    void ReadIndex(){
+
+        const flat::FlatHeader& h = GetHeader();
+        index.clear();
+
+        if( h.index_offset>0 ){
+            const flat::FlatEventEntry* e = (const flat::FlatEventEntry*)( data + h.index_offset );
+            index.assign( e, e+h.nindex );
+        }
+        else{
+            // Not closed: rebuild the index from the records written up to the last checkpoint.
+            const flat::FlatStepRecord* r = GetRecords();
+            for( uint64_t i=0; i<h.nrecords; i++ ){
+                if( index.empty() || index.back().eventID!=r[i].eventID ){
+                    flat::FlatEventEntry e = { r[i].eventID, i, 0 };
+                    index.push_back( e );
+                }
+                index.back().nrecords++;
+            }
+        }
+
+        // Events are written in order except after a resume or a merge.
+        std::stable_sort( index.begin(), index.end(), LessID );
+    }
+};
+
+#endif
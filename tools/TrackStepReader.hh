@@ -0,0 +1,142 @@
+//
+/// \file TrackStepReader.hh
+/// \brief Rejoins the tracks and steps trees written with the "track" output schema.
+///
+/// Every entry of the tracks tree is followed by nsteps consecutive entries of the steps
+/// tree. The reader builds the index of the first step of every track once, after which
+/// steps can be iterated together with the constants of their track, or the step-level
+/// events tree of the "step" schema can be rebuilt. Header only, so it can be loaded in
+/// a ROOT session with .L TrackStepReader.hh+ or included in compiled tools.
+
+#ifndef TrackStepReader_h
+#define TrackStepReader_h 1
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <vector>
+#include <algorithm>
+
+class TrackStepReader{
+
+public:
+
+    TrackStepReader( TTree* tracks, TTree* steps ) : track_tree( tracks ), step_tree( steps ),
+        current_track( -1 ), current_step( -1 )
+    {
+        track_tree->SetBranchAddress( "eventID", &eventID );
+        track_tree->SetBranchAddress( "trackID", &trackID );
+        track_tree->SetBranchAddress( "parentID", &parentID );
+        track_tree->SetBranchAddress( "particle", particle );
+        track_tree->SetBranchAddress( "nsteps", &nsteps );
+
+        step_tree->SetBranchAddress( "stepID", &stepID );
+        step_tree->SetBranchAddress( "volume", volume );
+        step_tree->SetBranchAddress( "process", process );
+
+        const char* names[] = { "x", "y", "z", "theta", "phi", "px", "py", "pz", "t", "Eki", "Ekf", "Edep" };
+        double* addresses[] = { &x, &y, &z, &theta, &phi, &px, &py, &pz, &t, &Eki, &Ekf, &Edep };
+        for( int i=0; i<12; i++ ){
+            if( step_tree->GetBranch( names[i] ) )
+                step_tree->SetBranchAddress( names[i], addresses[i] );
+        }
+
+        // Index of the first step of every track, reading only the nsteps branch.
+        TBranch* b = track_tree->GetBranch( "nsteps" );
+        Long64_t ntracks = track_tree->GetEntries();
+        first_step.resize( ntracks+1 );
+        first_step[0] = 0;
+        for( Long64_t k=0; k<ntracks; k++ ){
+            b->GetEntry( k );
+            first_step[k+1] = first_step[k] + nsteps;
+        }
+    }
+
+    Long64_t GetTrackEntries() const { return first_step.size()-1; }
+    Long64_t GetStepEntries() const { return first_step.back(); }
+
+    Long64_t GetFirstStep( Long64_t track ) const { return first_step[track]; }
+
+    void LoadTrack( Long64_t k ){
+        track_tree->GetEntry( k );
+        current_track = k;
+    }
+
+    /// Load step n and the track it belongs to.
+    void LoadStep( Long64_t n ){
+        if( current_track<0 || n<first_step[current_track] || n>=first_step[current_track+1] ){
+            Long64_t k = std::upper_bound( first_step.begin(), first_step.end(), n ) - first_step.begin() - 1;
+            LoadTrack( k );
+        }
+        step_tree->GetEntry( n );
+        current_step = n;
+    }
+
+    /// Move to the next step, loading the next track when needed. Returns false at the end.
+    bool Next(){
+        if( current_step+1 >= GetStepEntries() )
+            return false;
+        LoadStep( current_step+1 );
+        return true;
+    }
+
+    void Rewind(){ current_step = -1; }
+
+    /// Rebuild the step-level events tree of the "step" schema in the current directory.
+    TTree* MakeEventsTree( const char* name = "events" ){
+
+        TTree* events = new TTree( name, "Track-level info for the run" );
+        events->Branch( "eventID", &eventID, "eventID/I" );
+        events->Branch( "trackID", &trackID, "trackID/I" );
+        events->Branch( "stepID", &stepID, "stepID/I" );
+        events->Branch( "particle", particle, "particle[16]/C" );
+        events->Branch( "parentID", &parentID, "parentID/I" );
+        events->Branch( "volume", volume, "volume[16]/C" );
+        events->Branch( "x", &x, "x/D" );
+        events->Branch( "y", &y, "y/D" );
+        events->Branch( "z", &z, "z/D" );
+        events->Branch( "theta", &theta, "theta/D" );
+        events->Branch( "phi", &phi, "phi/D" );
+        events->Branch( "px", &px, "px/D" );
+        events->Branch( "py", &py, "py/D" );
+        events->Branch( "pz", &pz, "pz/D" );
+        events->Branch( "t", &t, "t/D" );
+        events->Branch( "Eki", &Eki, "Eki/D" );
+        events->Branch( "Ekf", &Ekf, "Ekf/D" );
+        events->Branch( "Edep", &Edep, "Edep/D" );
+        events->Branch( "process", process, "process[16]/C" );
+
+        Rewind();
+        while( Next() )
+            events->Fill();
+
+        return events;
+    }
+
+    // Track constants
+    Int_t eventID;
+    Int_t trackID;
+    Int_t parentID;
+    char particle[16];
+    Int_t nsteps;
+
+    // Step kinematics
+    Int_t stepID;
+    char volume[16];
+    double x, y, z, theta, phi;
+    double px, py, pz;
+    double t, Eki, Ekf, Edep;
+    char process[16];
+
+private:
+
+    TTree* track_tree;
+    TTree* step_tree;
+
+    std::vector<Long64_t> first_step;
+
+    Long64_t current_track;
+    Long64_t current_step;
+};
+
+#endif
@@ -0,0 +1,253 @@
+//
+/// \file apixs-fold.cc
+/// \brief Folds an emission spectrum with a detector response matrix made by /response/run.
+///
+/// The response matrix is read from a file of the response cache. The emission spectrum
+/// is either a histogram of a ROOT file, e.g. one of the xray_* spectra of the X-ray
+/// tally, or a text file of energy (MeV) and weight pairs. Each emitted energy is
+/// spread over the deposited energies with the response rows of the two nearest
+/// incident energies, interpolated linearly. The result is the expected deposited
+/// spectrum in the detector for the given emission, in the units of the weights.
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TH1D.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Response matrix as written by ResponseMatrix::WriteCache, energies in MeV.
+struct Response{
+
+    string detector;
+    string key;
+
+    int nincident = 0;
+    double incident_min = 0;
+    double incident_max = 0;
+
+    int ndeposit = 0;
+    double deposit_max = 0;
+
+    double photons = 0;
+
+    vector< vector<double> > rows;
+        // per incident bin with under- and overflow, probability per deposited energy bin
+};
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+bool ReadResponse( const string& name, Response& r ){
+
+    ifstream file( name.c_str() );
+    if( !file.good() ){
+        cerr << "Cannot open " << name << endl;
+        return false;
+    }
+
+    string line, word;
+    getline( file, line );
+    file >> word >> r.key;
+    file >> word >> r.detector;
+    file >> word >> r.nincident >> r.incident_min >> r.incident_max;
+    file >> word >> r.ndeposit >> r.deposit_max;
+    file >> word >> r.photons;
+
+    if( !file.good() || r.nincident<=0 || r.ndeposit<=0 || r.photons<=0 ){
+        cerr << name << " is not a response matrix." << endl;
+        return false;
+    }
+
+    r.rows.assign( r.nincident+2, vector<double>( r.ndeposit+2, 0. ) );
+    for( int i=0; i<r.nincident+2; i++ ){
+        for( int j=0; j<r.ndeposit+2; j++ ){
+            file >> r.rows[i][j];
+            r.rows[i][j] /= r.photons;
+        }
+    }
+
+    if( file.fail() ){
+        cerr << name << " is truncated." << endl;
+        return false;
+    }
+    return true;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Emission spectrum as energy and weight pairs, from file.root:histogram or a text file.
+bool ReadSpectrum( const string& name, vector<double>& energies, vector<double>& weights ){
+
+    size_t colon = name.rfind( ':' );
+    if( colon!=string::npos && name.find( ".root" )!=string::npos ){
+
+        TFile f( name.substr( 0, colon ).c_str(), "READ" );
+        TH1* h = f.IsZombie() ? 0 : dynamic_cast<TH1*>( f.Get( name.substr( colon+1 ).c_str() ) );
+        if( h==0 ){
+            cerr << "Cannot read the histogram " << name << endl;
+            return false;
+        }
+        for( int i=1; i<=h->GetNbinsX(); i++ ){
+            if( h->GetBinContent( i )!=0 ){
+                energies.push_back( h->GetBinCenter( i ) );
+                weights.push_back( h->GetBinContent( i ) );
+            }
+        }
+        return true;
+    }
+
+    ifstream file( name.c_str() );
+    if( !file.good() ){
+        cerr << "Cannot open " << name << endl;
+        return false;
+    }
+
+    string line;
+    while( getline( file, line ) ){
+        if( line.empty() || line[0]=='#' )
+            continue;
+        istringstream is( line );
+        double e, w;
+        if( is >> e >> w ){
+            energies.push_back( e );
+            weights.push_back( w );
+        }
+    }
+    return true;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+void PrintUsage(){
+    cerr << "\nUsage: apixs-fold [-o output] [-n name] response.resp spectrum\n";
+    cerr << "\tresponse.resp, response matrix from the cache of /response/run.\n";
+    cerr << "\tspectrum, file.root:histogram, or a text file of energy (MeV) and weight pairs.\n";
+    cerr << "\t-o, output file: a histogram if it ends with .root, text otherwise (default standard output).\n";
+    cerr << "\t-n, name of the output histogram (default folded_<detector>).\n" << endl;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+int main( int argc, char** argv ){
+
+    string output;
+    string hname;
+    vector<string> args;
+
+    for( int i=1; i<argc; i++ ){
+        string arg = argv[i];
+        if( arg=="-o" && i!=argc-1 ){
+            output = argv[++i];
+        }
+        else if( arg=="-n" && i!=argc-1 ){
+            hname = argv[++i];
+        }
+        else if( arg=="-h" ){
+            PrintUsage();
+            return 0;
+        }
+        else{
+            args.push_back( arg );
+        }
+    }
+
+    if( args.size()!=2 ){
+        PrintUsage();
+        return 2;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    Response r;
+    vector<double> energies, weights;
+    if( !ReadResponse( args[0], r ) || !ReadSpectrum( args[1], energies, weights ) )
+        return 1;
+
+    // Fold, interpolating between the rows of the incident energies around each energy.
+    vector<double> folded( r.ndeposit+2, 0. );
+    double width = ( r.incident_max-r.incident_min )/r.nincident;
+    double outside = 0;
+    double total = 0;
+
+    for( size_t k=0; k<energies.size(); k++ ){
+
+        total += weights[k];
+        if( energies[k]<r.incident_min || energies[k]>=r.incident_max ){
+            outside += weights[k];
+            continue;
+        }
+
+        double x = ( energies[k]-r.incident_min )/width - 0.5;
+        int i = x<0 ? 0 : x>=r.nincident-1 ? r.nincident-1 : int( x );
+        double f = x<0 || x>=r.nincident-1 ? 0 : x-i;
+
+        const vector<double>& low = r.rows[i+1];
+        const vector<double>& high = r.rows[ min( i+2, r.nincident ) ];
+        for( int j=0; j<r.ndeposit+2; j++ )
+            folded[j] += weights[k]*( ( 1-f )*low[j] + f*high[j] );
+    }
+
+    double elapsed = chrono::duration<double, milli>( chrono::steady_clock::now()-start ).count();
+
+    cerr << "Folded " << energies.size() << " emission bins with the response of " << r.detector
+         << " in " << elapsed << " ms" << endl;
+    if( outside>0 )
+        cerr << "    " << outside/total << " of the emission is outside of the incident energies of the matrix and was ignored." << endl;
+    cerr << "    no deposit: " << folded[0] << ", above " << r.deposit_max << " MeV: " << folded[r.ndeposit+1] << endl;
+
+    if( hname=="" )
+        hname = "folded_" + r.detector;
+
+    if( output.size()>5 && output.compare( output.size()-5, 5, ".root" )==0 ){
+        TFile f( output.c_str(), "UPDATE" );
+        if( f.IsZombie() ){
+            cerr << "Cannot open " << output << endl;
+            return 1;
+        }
+        string title = "Deposited energy in " + r.detector + ";E (MeV)";
+        TH1D h( hname.c_str(), title.c_str(), r.ndeposit, 0, r.deposit_max );
+        for( int j=1; j<=r.ndeposit; j++ )
+            h.SetBinContent( j, folded[j] );
+        h.SetBinContent( r.ndeposit+1, folded[r.ndeposit+1] );
+        h.SetEntries( total-outside );
+        h.Write( hname.c_str(), TObject::kOverwrite );
+        return 0;
+    }
+
+    ofstream file;
+    if( output!="" ){
+        file.open( output.c_str() );
+        if( !file.good() ){
+            cerr << "Cannot open " << output << endl;
+            return 1;
+        }
+    }
+    ostream& out = output!="" ? file : cout;
+
+    out << "# deposited energy in " << r.detector << ": low (MeV), high (MeV), value\n";
+    double bin = r.deposit_max/r.ndeposit;
+    for( int j=1; j<=r.ndeposit; j++ )
+        out << ( j-1 )*bin << '\t' << j*bin << '\t' << folded[j] << '\n';
+
+    return 0;
+}
@@ -0,0 +1,522 @@
+//
+/// \file apixs-merge.cc
+/// \brief Merges the output files of split apixs jobs after checking their provenance.
+///
+/// All inputs must have been produced with the same macros, geometry and physics list
+/// and with distinct random seeds. Event IDs of every input are shifted by the number of
+/// events of the inputs before it, so that they stay unique in the merged file. The shift
+/// applied to each input is stored in the merge_offsets TMacro, so single events can
+/// still be replayed with the seeds of the job they came from. The entry ranges of the
+/// event_index tree are shifted the same way by the entries of the preceding inputs.
+
+#include "TROOT.h"
+#include "TSystem.h"
+#include "TFile.h"
+#include "TKey.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TLeaf.h"
+#include "TH1.h"
+#include "TMacro.h"
+#include "TMD5.h"
+#include "TObjString.h"
+#include "TList.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Provenance and size of one input file.
+struct InputInfo{
+
+    string name;
+
+    bool ok = false;
+
+    string macro_hash;
+        // checksum of the macros used to configure the job
+    string geometry_hash;
+        // checksum of the geometry and physics description
+    string codes_hash;
+        // checksum of the codes used in the tables, xray_codes and point_detector_names
+
+    vector<string> seeds;
+        // one entry per line of rand_seeds (merged files carry several)
+
+    set<string> trees;
+        // names of the TTrees in the file
+
+    map<string, Long64_t> entries;
+        // number of entries of every TTree
+
+    Long64_t nevents = 0;
+        // number of simulated events, used to offset the event IDs of the following inputs
+};
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Objects written by apixs itself that are not configuration macros.
+bool IsBookkeeping( const string& name ){
+    return name=="rand_seeds" || name=="rand_scheme" || name=="checkpoint"
+        || name=="geometry" || name=="merge_offsets" || name=="trigger"
+        || name=="truncated_events" || name=="xray_codes" || name=="point_detector_names";
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+string Checksum( TMacro* mac ){
+    TMD5* md5 = mac->Checksum();
+    string s = md5 ? md5->AsString() : "";
+    delete md5;
+    return s;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+InputInfo ReadInfo( const string& name ){
+
+    InputInfo info;
+    info.name = name;
+
+    TFile f( name.c_str(), "READ" );
+    if( f.IsZombie() ){
+        cerr << "Cannot open " << name << endl;
+        return info;
+    }
+
+    vector<string> macro_sums;
+    set<string> seen;
+
+    TIter next( f.GetListOfKeys() );
+    while( TKey* key = (TKey*)next() ){
+
+        string kname = key->GetName();
+        if( seen.count( kname ) )
+            continue;
+            // keys are sorted by cycle, only the latest one is used
+        seen.insert( kname );
+
+        TClass* cl = TClass::GetClass( key->GetClassName() );
+        if( cl==0 )
+            continue;
+
+        if( cl->InheritsFrom( TTree::Class() ) ){
+            info.trees.insert( kname );
+
+            TTree* tree = (TTree*)key->ReadObj();
+            info.entries[kname] = tree->GetEntries();
+            if( tree->GetBranch( "eventID" ) && tree->GetEntries()>0 ){
+                Long64_t n = Long64_t( tree->GetMaximum( "eventID" ) ) + 1;
+                info.nevents = max( info.nevents, n );
+            }
+            delete tree;
+        }
+        else if( cl->InheritsFrom( TMacro::Class() ) ){
+            TMacro* mac = (TMacro*)key->ReadObj();
+
+            if( kname=="rand_seeds" ){
+                TIter lines( mac->GetListOfLines() );
+                while( TObjString* l = (TObjString*)lines() ){
+                    if( l->GetString().Length()>0 )
+                        info.seeds.push_back( l->GetString().Data() );
+                }
+            }
+            else if( kname=="geometry" ){
+                info.geometry_hash = Checksum( mac );
+            }
+            else if( kname=="xray_codes" || kname=="point_detector_names" ){
+                info.codes_hash += kname + Checksum( mac );
+            }
+            else if( kname=="checkpoint" ){
+                TObjString* l = mac->GetLineWith( "completed" );
+                if( l ){
+                    stringstream ss( l->GetString().Data() );
+                    string tag;
+                    Long64_t n = 0;
+                    ss >> tag >> n;
+                    info.nevents = max( info.nevents, n );
+                }
+            }
+            else if( !IsBookkeeping( kname ) ){
+                macro_sums.push_back( Checksum( mac ) );
+            }
+            delete mac;
+        }
+    }
+
+    // The macro hash does not depend on the macro file names.
+    sort( macro_sums.begin(), macro_sums.end() );
+    string all;
+    for( size_t i=0; i<macro_sums.size(); i++ )
+        all += macro_sums[i];
+    TMD5 md5;
+    md5.Update( (const UChar_t*)all.c_str(), all.size() );
+    md5.Final();
+    info.macro_hash = md5.AsString();
+
+    info.ok = true;
+    return info;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Run func(i) for i in [0,n) on njobs threads.
+template<class F>
+void RunParallel( int njobs, int n, F func ){
+
+    atomic<int> next( 0 );
+    vector<thread> workers;
+
+    for( int j=0; j<njobs; j++ ){
+        workers.push_back( thread( [&](){
+            for( int i=next++; i<n; i=next++ )
+                func( i );
+        } ) );
+    }
+    for( size_t j=0; j<workers.size(); j++ )
+        workers[j].join();
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Entries of the data trees in the inputs before each input: the shift of the first entry
+// of the event_index, pointing to the tracks tree if present and to the events tree
+// otherwise, and of first_step, pointing to the steps tree.
+void IndexOffsets( const vector<InputInfo>& inputs, vector<Long64_t>& first, vector<Long64_t>& first_step ){
+
+    size_t n = inputs.size();
+    first.assign( n, 0 );
+    first_step.assign( n, 0 );
+
+    map<string, Long64_t> sum;
+    for( size_t i=0; i<n; i++ ){
+        const InputInfo& in = inputs[i];
+        const char* target = in.trees.count( "tracks" ) ? "tracks" : "events";
+        const char* step_target = in.trees.count( "steps" ) ? "steps" : "events";
+        first[i] = sum[target];
+        first_step[i] = sum[step_target];
+
+        for( map<string, Long64_t>::const_iterator it=in.entries.begin(); it!=in.entries.end(); ++it )
+            sum[it->first] += it->second;
+    }
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+// Copy all trees of the given inputs into one file, shifting the event IDs and index ranges.
+bool MergeTrees( const vector<InputInfo>& inputs, const vector<Long64_t>& offsets,
+                 const vector<Long64_t>& first_offsets, const vector<Long64_t>& step_offsets,
+                 const set<string>& tree_names, const string& output ){
+
+    TFile out( output.c_str(), "RECREATE" );
+    if( out.IsZombie() ){
+        cerr << "Cannot create " << output << endl;
+        return false;
+    }
+
+    for( set<string>::const_iterator it=tree_names.begin(); it!=tree_names.end(); ++it ){
+
+        TChain chain( it->c_str() );
+        vector<Long64_t> chain_offsets;
+        vector<Long64_t> chain_first;
+        vector<Long64_t> chain_step;
+
+        for( size_t i=0; i<inputs.size(); i++ ){
+            if( inputs[i].trees.count( *it ) ){
+                chain.Add( inputs[i].name.c_str() );
+                chain_offsets.push_back( offsets[i] );
+                chain_first.push_back( first_offsets[i] );
+                chain_step.push_back( step_offsets[i] );
+            }
+        }
+        if( chain_offsets.empty() )
+            continue;
+
+        // Event IDs are integers in the step trees and doubles in the tally tables.
+        Int_t eventID = 0;
+        Double_t eventID_d = 0;
+        TLeaf* id_leaf = chain.GetLeaf( "eventID" );
+        bool has_id = id_leaf!=0;
+        bool id_double = has_id && string( id_leaf->GetTypeName() )=="Double_t";
+        if( id_double )
+            chain.SetBranchAddress( "eventID", &eventID_d );
+        else if( has_id )
+            chain.SetBranchAddress( "eventID", &eventID );
+
+        Long64_t first = 0;
+        Long64_t first_step = 0;
+        bool is_index = *it=="event_index";
+        bool has_steps = is_index && chain.GetBranch( "first_step" )!=0;
+        if( is_index )
+            chain.SetBranchAddress( "first", &first );
+        if( has_steps )
+            chain.SetBranchAddress( "first_step", &first_step );
+
+        out.cd();
+        TTree* merged = chain.CloneTree( 0 );
+
+        Long64_t nentries = chain.GetEntries();
+        for( Long64_t n=0; n<nentries; n++ ){
+            chain.GetEntry( n );
+            if( id_double )
+                eventID_d += chain_offsets[ chain.GetTreeNumber() ];
+            else if( has_id )
+                eventID += chain_offsets[ chain.GetTreeNumber() ];
+            if( is_index )
+                first += chain_first[ chain.GetTreeNumber() ];
+            if( has_steps )
+                first_step += chain_step[ chain.GetTreeNumber() ];
+            merged->Fill();
+        }
+        merged->Write( 0, TObject::kOverwrite );
+    }
+
+    out.Close();
+    return true;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+void PrintUsage(){
+    cerr << "\nUsage: apixs-merge [-j njobs] [--force] -o merged.root input1.root input2.root ...\n";
+    cerr << "\t-o, output ROOT file.\n";
+    cerr << "\t-j, number of threads used to read and merge the inputs.\n";
+    cerr << "\t--force, merge even if macros, geometry or seeds are inconsistent.\n" << endl;
+}
+
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+
+int main( int argc, char** argv ){
+
+    string output;
+    vector<string> input_names;
+    int njobs = 1;
+    bool force = false;
+
+    for( int i=1; i<argc; i++ ){
+        string arg = argv[i];
+        if( arg=="-o" && i!=argc-1 ){
+            output = argv[++i];
+        }
+        else if( arg=="-j" && i!=argc-1 ){
+            njobs = max( 1, atoi( argv[++i] ) );
+        }
+        else if( arg=="--force" ){
+            force = true;
+        }
+        else if( arg=="-h" ){
+            PrintUsage();
+            return 0;
+        }
+        else{
+            input_names.push_back( arg );
+        }
+    }
+
+    if( output=="" || input_names.empty() ){
+        PrintUsage();
+        return 2;
+    }
+
+    ROOT::EnableThreadSafety();
+
+    // Read the provenance of every input.
+    int n = input_names.size();
+    vector<InputInfo> inputs( n );
+    RunParallel( njobs, n, [&]( int i ){ inputs[i] = ReadInfo( input_names[i] ); } );
+
+    // Check that all inputs describe the same simulation with different seeds.
+    int errors = 0;
+    map<string, string> seed_owner;
+    set<string> tree_names;
+
+    for( int i=0; i<n; i++ ){
+        if( !inputs[i].ok ){
+            errors++;
+            continue;
+        }
+        if( inputs[i].macro_hash!=inputs[0].macro_hash ){
+            cerr << "Macros of " << inputs[i].name << " differ from those of " << inputs[0].name << endl;
+            errors++;
+        }
+        if( inputs[i].geometry_hash!=inputs[0].geometry_hash ){
+            cerr << "Geometry/physics of " << inputs[i].name << " differ from those of " << inputs[0].name << endl;
+            errors++;
+        }
+        if( inputs[i].codes_hash!=inputs[0].codes_hash ){
+            // The tables are concatenated and the codes of the first input are kept.
+            cerr << "Target, process or detector codes of " << inputs[i].name << " differ from those of " << inputs[0].name << endl;
+            errors++;
+        }
+        for( size_t s=0; s<inputs[i].seeds.size(); s++ ){
+            const string& seed = inputs[i].seeds[s];
+            if( seed_owner.count( seed ) ){
+                cerr << "Seeds " << seed << " of " << inputs[i].name << " were already used by " << seed_owner[seed] << endl;
+                errors++;
+            }
+            else
+                seed_owner[seed] = inputs[i].name;
+        }
+        tree_names.insert( inputs[i].trees.begin(), inputs[i].trees.end() );
+    }
+
+    if( errors>0 ){
+        if( !force ){
+            cerr << errors << " inconsistencies found, nothing merged. Use --force to merge anyway." << endl;
+            return 1;
+        }
+        cerr << errors << " inconsistencies ignored." << endl;
+    }
+
+    // Event ID offset of every input.
+    vector<Long64_t> offsets( n, 0 );
+    for( int i=1; i<n; i++ )
+        offsets[i] = offsets[i-1] + inputs[i-1].nevents;
+
+    // Entry offsets of the event_index ranges, global so that the partial files below
+    // can be concatenated unchanged.
+    vector<Long64_t> first_offsets, step_offsets;
+    IndexOffsets( inputs, first_offsets, step_offsets );
+
+    // Merge groups of inputs into partial files in parallel, then concatenate them.
+    int ngroups = min( njobs, n );
+    vector<string> parts( ngroups );
+    vector<char> parts_ok( ngroups, false );
+        // not vector<bool>: its elements share words and are written by several threads
+
+    RunParallel( njobs, ngroups, [&]( int g ){
+        vector<InputInfo> group_inputs;
+        vector<Long64_t> group_offsets, group_first, group_step;
+        for( int i=g*n/ngroups; i<(g+1)*n/ngroups; i++ ){
+            group_inputs.push_back( inputs[i] );
+            group_offsets.push_back( offsets[i] );
+            group_first.push_back( first_offsets[i] );
+            group_step.push_back( step_offsets[i] );
+        }
+        parts[g] = ngroups==1 ? output : output + ".part" + to_string( g );
+        parts_ok[g] = MergeTrees( group_inputs, group_offsets, group_first, group_step, tree_names, parts[g] );
+    } );
+
+    for( int g=0; g<ngroups; g++ ){
+        if( !parts_ok[g] )
+            return 1;
+    }
+
+    TFile out( output.c_str(), ngroups==1 ? "UPDATE" : "RECREATE" );
+
+    if( ngroups>1 ){
+        for( set<string>::iterator it=tree_names.begin(); it!=tree_names.end(); ++it ){
+            TChain chain( it->c_str() );
+            for( int g=0; g<ngroups; g++ )
+                chain.Add( parts[g].c_str() );
+            if( chain.GetEntries()>0 )
+                chain.Merge( &out, 0, "fast keep" );
+        }
+        for( int g=0; g<ngroups; g++ )
+            gSystem->Unlink( parts[g].c_str() );
+    }
+
+    // Sum the histograms and keep one copy of the configuration macros.
+    map<string, TH1*> histograms;
+
+    for( int i=0; i<n; i++ ){
+        TFile f( inputs[i].name.c_str(), "READ" );
+        set<string> seen;
+
+        TIter next( f.GetListOfKeys() );
+        while( TKey* key = (TKey*)next() ){
+
+            string kname = key->GetName();
+            if( seen.count( kname ) )
+                continue;
+            seen.insert( kname );
+
+            TClass* cl = TClass::GetClass( key->GetClassName() );
+            if( cl==0 )
+                continue;
+
+            if( cl->InheritsFrom( TH1::Class() ) ){
+                TH1* h = (TH1*)key->ReadObj();
+                if( histograms.count( kname ) ){
+                    histograms[kname]->Add( h );
+                    delete h;
+                }
+                else{
+                    h->SetDirectory( 0 );
+                    histograms[kname] = h;
+                }
+            }
+            else if( i==0 && cl->InheritsFrom( TMacro::Class() ) && ( !IsBookkeeping( kname ) || kname=="geometry" || kname=="rand_scheme" || kname=="xray_codes" || kname=="point_detector_names" ) ){
+                TMacro* mac = (TMacro*)key->ReadObj();
+                out.cd();
+                mac->Write( kname.c_str(), TObject::kOverwrite );
+                delete mac;
+            }
+        }
+    }
+
+    out.cd();
+    for( map<string, TH1*>::iterator it=histograms.begin(); it!=histograms.end(); ++it ){
+        it->second->Write( it->first.c_str(), TObject::kOverwrite );
+        delete it->second;
+    }
+
+    // Provenance of the merged file.
+    TMacro seeds( "rand_seeds" );
+    TMacro offs( "merge_offsets" );
+    Long64_t total = 0;
+
+    for( int i=0; i<n; i++ ){
+        for( size_t s=0; s<inputs[i].seeds.size(); s++ )
+            seeds.AddLine( inputs[i].seeds[s].c_str() );
+
+        stringstream ss;
+        ss << inputs[i].name << '\t' << offsets[i] << '\t' << inputs[i].nevents;
+        offs.AddLine( ss.str().c_str() );
+
+        total += inputs[i].nevents;
+    }
+
+    stringstream ss;
+    ss << "completed " << total;
+    TMacro ckpt( "checkpoint" );
+    ckpt.AddLine( ss.str().c_str() );
+
+    seeds.Write( 0, TObject::kOverwrite );
+    offs.Write( 0, TObject::kOverwrite );
+    ckpt.Write( 0, TObject::kOverwrite );
+
+    out.Close();
+
+    cout << "Merged " << n << " files with " << total << " events into " << output << endl;
+    return 0;
+}